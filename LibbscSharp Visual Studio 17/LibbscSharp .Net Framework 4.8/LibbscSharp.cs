@@ -18,43 +18,88 @@ namespace LibbscSharp
         }
 
         static public int BSCCompress(Stream inputStream, Stream outputStream, int CompressionLevel, int Numthreads, int BlobkSize)
+        {
+            return BSCCompress(inputStream, outputStream, CompressionLevel, Numthreads, BlobkSize, false);
+        }
+
+        /// <summary>
+        /// Compress the whole content of <paramref name="inputStream"/> into a bsc container written to <paramref name="outputStream"/>.
+        /// </summary>
+        /// <remarks>
+        /// A seekable input is rewound to position 0 and streamed block by block, its Length gives the container size.
+        /// A non-seekable input (network, pipe, GZipStream...) has no Length: it is spooled to a temporary file deleted on close
+        /// and streamed from there, memory stays bounded by a few blocks whatever the input size.
+        /// When the size is known up front, the overload taking the input length streams the source directly.
+        /// </remarks>
+        static public int BSCCompress(Stream inputStream, Stream outputStream, int CompressionLevel, int Numthreads, int BlobkSize, bool WriteIndex)
         {
             //return Compressor.CompressOmp(inputStream, outputStream, BlobkSize, 0, 0, 0, 1, CompressionLevel);
+            if (!inputStream.CanSeek)
+            {
+                // the container header holds the input size, spool a forward-only source to disk to learn it
+                using (FileStream spooled = new FileStream(Path.GetTempFileName(), FileMode.Create, FileAccess.ReadWrite, FileShare.None, 81920, FileOptions.DeleteOnClose))
+                {
+                    inputStream.CopyTo(spooled);
+                    spooled.Position = 0;
+                    return Compressor.CompressStream(spooled, spooled.Length, outputStream, BlobkSize, Numthreads, 0, 0, 1, CompressionLevel, WriteIndex);
+                }
+            }
             if (inputStream is MemoryStream ms && ms.TryGetBuffer(out ArraySegment<byte> segment))
             {
                 // pass underlying stream buffer without copy
-                return Compressor.CompressOmp(segment.Array, inputStream.Length, outputStream, BlobkSize, 0, 0, 0, 1, CompressionLevel);
+                return Compressor.CompressOmp(segment.Array, inputStream.Length, outputStream, BlobkSize, Numthreads, 0, 0, 1, CompressionLevel, WriteIndex);
             }
             else
             {
-                long length = inputStream.Length;
-                byte[] buffer = new byte[length];
+                // stream blocks from the source, only a few blocks are kept in memory whatever the input size
                 inputStream.Position = 0;
-                inputStream.Read(buffer, 0, (int)length);
-                return Compressor.CompressOmp(buffer, length, outputStream, BlobkSize, 0, 0, 0, 1, CompressionLevel);
+                return Compressor.CompressStream(inputStream, inputStream.Length, outputStream, BlobkSize, Numthreads, 0, 0, 1, CompressionLevel, WriteIndex);
             }
         }
+
+        /// <summary>
+        /// Compress the next <paramref name="InputLength"/> bytes of <paramref name="inputStream"/>, read forward from its current position.
+        /// </summary>
+        /// <remarks>
+        /// For a non-seekable source whose size is known (Content-Length, a framing header...): nothing is buffered beyond a few blocks.
+        /// A source ending before <paramref name="InputLength"/> bytes fails with a negative error code.
+        /// </remarks>
+        static public int BSCCompress(Stream inputStream, long InputLength, Stream outputStream, int CompressionLevel, int Numthreads, int BlobkSize, bool WriteIndex)
+        {
+            return Compressor.CompressStream(inputStream, InputLength, outputStream, BlobkSize, Numthreads, 0, 0, 1, CompressionLevel, WriteIndex);
+        }
         static public int BSCDecompress(Stream inputStream, Stream outputStream)
         {
-            return BSCDecompress(inputStream, outputStream);
+            return BSCDecompress(inputStream, outputStream, 0);
         }
 
         static public int BSCDecompress(Stream inputStream, Stream outputStream, int Numthreads)
         {
             //return Compressor.DecompressOmp(inputStream, outputStream, Numthreads);
-            if (inputStream is MemoryStream ms && ms.TryGetBuffer(out ArraySegment<byte> segment))
+            if (inputStream is MemoryStream ms && ms.TryGetBuffer(out ArraySegment<byte> segment) && outputStream.CanSeek)
             {
                 // pass underlying stream buffer without copy
                 return Compressor.DecompressOmp(segment.Array, inputStream.Length, outputStream, Numthreads);
             }
             else
             {
-                long length = inputStream.Length;
-                byte[] buffer = new byte[length];
-                inputStream.Position = 0;
-                inputStream.Read(buffer, 0, (int)length);
-                return Compressor.DecompressOmp(buffer, length, outputStream, Numthreads);
+                // decode blocks in order to any writable stream, the input is never loaded as a whole
+                if (inputStream.CanSeek) inputStream.Position = 0;
+                return Compressor.DecompressStream(inputStream, outputStream, Numthreads);
             }
         }
+
+        static public int BSCDecompressRange(Stream inputStream, Stream outputStream, long Offset, long Length)
+        {
+            return BSCDecompressRange(inputStream, outputStream, Offset, Length, 0);
+        }
+
+        static public int BSCDecompressRange(Stream inputStream, Stream outputStream, long Offset, long Length, int Numthreads)
+        {
+            // only the blocks overlapping [Offset, Offset + Length) are read and decoded, the index footer (see WriteIndex) avoids walking the block headers
+            if (!inputStream.CanSeek) throw new NotSupportedException("BSCDecompressRange needs a seekable input stream, use BSCDecompress for forward-only sources.");
+            inputStream.Position = 0;
+            return Compressor.DecompressRange(inputStream, Offset, Length, outputStream, Numthreads);
+        }
     }
 }
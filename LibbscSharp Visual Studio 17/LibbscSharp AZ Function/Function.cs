@@ -1,5 +1,6 @@
 ﻿using BscDotNet;
 using Microsoft.AspNetCore.Http;
+using Microsoft.AspNetCore.Http.Features;
 using Microsoft.AspNetCore.Mvc;
 using Microsoft.Azure.Functions.Worker;
 using Microsoft.Extensions.Logging;
@@ -70,11 +71,7 @@ public class Function
                 }
             }
 
-            if (inputData.Length > 4 &&
-            inputData[0] == (byte)'b' &&
-            inputData[1] == (byte)'s' &&
-            inputData[2] == (byte)'c' &&
-            inputData[3] == (byte)'1')
+            if (IsBscContainer(inputData, inputData.Length))
             {
                 return new BadRequestObjectResult("Input data is already compressed.");
             }
@@ -116,84 +113,128 @@ public class Function
         _logger.LogInformation("Decompress function requested");
         try
         {
-            // 1. Read the full request body as byte[]
+            // 1. Read the full request body as byte[], GetBuffer() may be larger than the body so keep its length aside
             byte[] inputData;
+            int inputLength;
             using (var memoryStream = new MemoryStream())
             {
                 req.Body.CopyToAsync(memoryStream).Wait();
                 inputData = memoryStream.GetBuffer();
+                inputLength = (int)memoryStream.Length;
             }
-            if (inputData.Length == 0)
+            if (inputLength == 0)
             {
                 return new NotFoundObjectResult("Empty request body.");
             }
-            if (inputData.Length < 4 ||
-            inputData[0] != (byte)'b' ||
-            inputData[1] != (byte)'s' ||
-            inputData[2] != (byte)'c' ||
-            inputData[3] != (byte)'1')
-            {
-                return new BadRequestObjectResult("Input does not contain BSC compressed data, expected header 'bsc1'.");
-            }
-            // 2. Prepare output streams for native compressor
-            var outputStream = new MemoryStream();
-            _logger.LogInformation($"Input file size : {inputData.Length}");
-
-            // 3. Call your native compressor
-
-            int result = BscDotNet.Compressor.DecompressOmp(
-                inputData,
-                inputData.Length,
-                outputStream,
-                numThreads: 0 // 0 = auto (uses all available cores) Note that Azure Function basic plan only have one core
-            );
-            if (result < 0)
+            if (!IsBscContainer(inputData, inputLength))
             {
-                return new NotFoundObjectResult($"Error code thrown during decompression : {result}");
+                return new BadRequestObjectResult("Input does not contain BSC compressed data, expected header 'bsc1', 'bsc2' or 'bsc3'.");
             }
-            _logger.LogInformation($"Decompression suceed to : {outputStream.Length}");
-
-            // 4. Prepare successful response
-            outputStream.Position = 0;
+            _logger.LogInformation($"Input file size : {inputLength}");
 
-            // Compress
             var acceptEncoding = req.Headers.AcceptEncoding.ToString(); // or req.Headers in controller
             if (acceptEncoding.Contains("gz", StringComparison.OrdinalIgnoreCase) ||
                 acceptEncoding.Contains("gzip", StringComparison.OrdinalIgnoreCase))
             {
-                var compressedStream = new MemoryStream(); // Or pipe directly if possible
-                var gzip = new GZipStream(compressedStream, CompressionLevel.Fastest, leaveOpen: true);
-                outputStream.CopyTo(gzip);
-                compressedStream.Position = 0;
-
-                // Now return the compressed version
-                return new CompressedFileResult(compressedStream, "decompressed-data.gz");
-            } else {
-                return new FileStreamResult(outputStream, "application/octet-stream") { FileDownloadName = "decompressed-data" };
+                // 2. Decode blocks in order straight into gzip over the response body, neither result is buffered as a whole
+                return new GzipDecompressResult(new MemoryStream(inputData, 0, inputLength, writable: false), "decompressed-data.gz", _logger);
             }
+
+            // 2. Decode blocks in order straight into the response body, the decompressed data is never buffered as a whole
+            return new DecompressStreamResult(new MemoryStream(inputData, 0, inputLength, writable: false), "decompressed-data", _logger);
         }
         catch (Exception ex)
         {
             return new NotFoundObjectResult($"Internal server error : {ex.Message}");
         }
     }
+
+    // bsc1 = plain blocks, bsc2 = deduplicated against a previous container, bsc3 = long-range references
+    private static bool IsBscContainer(byte[] data, int length)
+    {
+        return length > 4 &&
+            data[0] == (byte)'b' &&
+            data[1] == (byte)'s' &&
+            data[2] == (byte)'c' &&
+            data[3] >= (byte)'1' && data[3] <= (byte)'3';
+    }
 }
 
 
-public class CompressedFileResult : FileStreamResult
+// Decodes the container block by block into the response body, headers are sent before the first block so the length stays unknown
+public class DecompressStreamResult : IActionResult
 {
-    public CompressedFileResult(Stream fileStream, string fileDownloadName)
-        : base(fileStream, "application/octet-stream")
+    private readonly Stream _inputStream;
+    private readonly string _fileDownloadName;
+    private readonly ILogger _logger;
+
+    public DecompressStreamResult(Stream inputStream, string fileDownloadName, ILogger logger)
     {
-        FileDownloadName = fileDownloadName;
+        _inputStream = inputStream;
+        _fileDownloadName = fileDownloadName;
+        _logger = logger;
     }
-    public override async Task ExecuteResultAsync(ActionContext context)
+
+    public async Task ExecuteResultAsync(ActionContext context)
     {
-        // Set required headers BEFORE the base writes the body
+        // Set required headers BEFORE the body is written
         var response = context.HttpContext.Response;
+        response.ContentType = "application/octet-stream";
+        response.Headers["Content-Disposition"] = $"attachment; filename=\"{_fileDownloadName}\"";
+        response.Headers.Remove("Content-Length");
+        SetEncodingHeaders(response);
+
+        // DecompressStream writes synchronously from the native callbacks, run it off the request thread
+        var bodyControl = context.HttpContext.Features.Get<IHttpBodyControlFeature>();
+        if (bodyControl != null) bodyControl.AllowSynchronousIO = true;
+
+        var body = response.Body;
+        int result = await Task.Run(() => Decompress(body));
+        if (result < 0)
+        {
+            // headers are already sent, the truncated body is the only signal left to the client
+            _logger.LogError($"Error code thrown during decompression : {result}");
+            context.HttpContext.Abort();
+            return;
+        }
+        _logger.LogInformation($"Decompression suceed to {_fileDownloadName}");
+    }
+
+    protected virtual void SetEncodingHeaders(HttpResponse response)
+    {
+    }
+
+    // Decodes every block into body, a content encoding wraps body and calls back here
+    protected virtual int Decompress(Stream body)
+    {
+        return BscDotNet.Compressor.DecompressStream(
+            _inputStream,
+            body,
+            numThreads: 0 // 0 = auto (uses all available cores) Note that Azure Function basic plan only have one core
+        );
+    }
+}
+
+
+public class GzipDecompressResult : DecompressStreamResult
+{
+    public GzipDecompressResult(Stream inputStream, string fileDownloadName, ILogger logger)
+        : base(inputStream, fileDownloadName, logger)
+    {
+    }
+
+    protected override void SetEncodingHeaders(HttpResponse response)
+    {
         response.Headers["Content-Encoding"] = "gzip";
         response.Headers["Vary"] = "Accept-Encoding";
-        response.Headers.Remove("Content-Length"); // Important for compressed streams
-        await base.ExecuteResultAsync(context);
+    }
+
+    protected override int Decompress(Stream body)
+    {
+        // the gzip trailer is written when the stream is disposed, after the last block
+        using (var gzip = new GZipStream(body, CompressionLevel.Fastest, leaveOpen: true))
+        {
+            return base.Decompress(gzip);
+        }
     }
 }
\ No newline at end of file
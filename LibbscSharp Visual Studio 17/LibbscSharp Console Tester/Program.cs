@@ -3,8 +3,13 @@ using LibbscSharp;
 
 class Program
 {
-    static void Main()
+    static void Main(string[] args)
     {
+        if (args.Length > 0 && args[0] == "--self-test")
+        {
+            Environment.ExitCode = SelfTest.Run();
+            return;
+        }
 
         // ===================== COMPRESSION =====================
         Console.Write("Enter a file path to compress: ");
@@ -0,0 +1,23 @@
+﻿// Input generator of the --self-test round trips, linked into both console testers.
+// The C and C++ tests fill the same data with bsc_test_fill in tests/test_data.h.
+static class TestData
+{
+    // text like records, a 64KB window repeated every 1MB so dedup, long-range and LZP have something to find
+    public static byte[] Generate(int size)
+    {
+        byte[] data = new byte[size];
+        uint seed = 12345;
+        for (int i = 0; i < size; ++i)
+        {
+            if (i >= 1024 * 1024 && (i % (1024 * 1024)) < 65536)
+            {
+                data[i] = data[i - 1024 * 1024];
+                continue;
+            }
+
+            seed = seed * 1103515245u + 12345u;
+            data[i] = (i % 64) == 63 ? (byte)'\n' : (byte)('a' + ((seed >> 16) % 8));
+        }
+        return data;
+    }
+}
@@ -0,0 +1,90 @@
+﻿using System.Runtime.InteropServices;
+
+namespace LibbscSharp
+{
+    [StructLayout(LayoutKind.Sequential)]
+    public struct BscxParams
+    {
+        public int BlockSize;
+        public int NumThreads;
+        public int LzpHashSize;
+        public int LzpMinLen;
+        public int BlockSorter;
+        public int Coder;
+        public int Features;
+        public int WriteIndex;
+        public int SortingContexts;
+        public int RecordSize;
+        public int MinBlockSize;
+        public int StoreThreshold;
+        public int Deduplicate;
+        public int CdcBlockSize;
+        public int LongRange;
+    }
+
+    // Binds the plain C bscx library (bscx.dll / libbscx.so), usable without C++/CLI and on Linux.
+    // Results are the container length or a negative libbsc error code.
+    static public class Bscx
+    {
+        const string Library = "bscx";
+        const long BadParameter = -1; // BSCX_BAD_PARAMETER
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        static extern void bscx_default_params(out BscxParams parameters);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        static extern long bscx_compress_bound(nuint inputSize, in BscxParams parameters);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        static extern long bscx_compress_container(ref byte input, nuint inputSize, ref byte output, nuint outputCapacity, in BscxParams parameters);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        static extern long bscx_compress_incremental(ref byte input, nuint inputSize, ref byte previous, nuint previousSize, ref byte output, nuint outputCapacity, in BscxParams parameters);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        static extern long bscx_decompressed_size(ref byte input, nuint inputSize);
+
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        static extern long bscx_decompress_container(ref byte input, nuint inputSize, ref byte output, nuint outputCapacity, int numThreads);
+
+        static public BscxParams DefaultParams()
+        {
+            bscx_default_params(out BscxParams parameters);
+            return parameters;
+        }
+
+        // inputs past 2GB are valid (memory mapped files, native buffers), a negative size is a bad parameter
+        static public long CompressBound(long inputSize, in BscxParams parameters)
+        {
+            if (inputSize < 0) return BadParameter;
+            return bscx_compress_bound((nuint)inputSize, in parameters);
+        }
+
+        static public long Compress(ReadOnlySpan<byte> input, Span<byte> output, in BscxParams parameters)
+        {
+            // spans are pinned for the duration of the call, the container is written straight into output
+            return bscx_compress_container(ref MemoryMarshal.GetReference(input), (nuint)input.Length, ref MemoryMarshal.GetReference(output), (nuint)output.Length, in parameters);
+        }
+
+        static public long Compress(ReadOnlySpan<byte> input, Span<byte> output)
+        {
+            return Compress(input, output, DefaultParams());
+        }
+
+        // blocks found by hash in the previous container are copied, size output with WriteIndex = 2 (block hashes)
+        static public long CompressIncremental(ReadOnlySpan<byte> input, ReadOnlySpan<byte> previous, Span<byte> output, in BscxParams parameters)
+        {
+            return bscx_compress_incremental(ref MemoryMarshal.GetReference(input), (nuint)input.Length, ref MemoryMarshal.GetReference(previous), (nuint)previous.Length, ref MemoryMarshal.GetReference(output), (nuint)output.Length, in parameters);
+        }
+
+        static public long DecompressedSize(ReadOnlySpan<byte> input)
+        {
+            return bscx_decompressed_size(ref MemoryMarshal.GetReference(input), (nuint)input.Length);
+        }
+
+        static public long Decompress(ReadOnlySpan<byte> input, Span<byte> output, int NumThreads = 0)
+        {
+            return bscx_decompress_container(ref MemoryMarshal.GetReference(input), (nuint)input.Length, ref MemoryMarshal.GetReference(output), (nuint)output.Length, NumThreads);
+        }
+    }
+}
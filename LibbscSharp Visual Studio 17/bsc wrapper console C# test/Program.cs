@@ -1,13 +1,18 @@
 ﻿using System;
 using System.Diagnostics;
 using System.IO;
-using BscDotNet;
+using LibbscSharp;
 
 class Program
 {        
-    static void Main()
+    static void Main(string[] args)
     {
-        
+        if (args.Length > 0 && args[0] == "--self-test")
+        {
+            Environment.ExitCode = SelfTest.Run();
+            return;
+        }
+
         // ===================== COMPRESSION =====================
         Console.Write("Enter a file path to compress: ");
         string inputPath = Console.ReadLine()?.Trim('"');
@@ -28,8 +33,8 @@ class Program
             using (var inputStream = new FileStream(inputPath, FileMode.Open, FileAccess.Read))
             using (var outputStream = new FileStream(compressedPath, FileMode.Create, FileAccess.Write))
             {
-                int result = BscDotNet.Compressor.CompressOmp(inputStream, outputStream, 25*1024*1024, 0, 0, 0, 1, 2);
-                if (result <= 0)
+                int result = LibscSharp.BSCCompress(inputStream, outputStream, 2, 0, 25 * 1024 * 1024);
+                if (result < 0)
                 {
                     Console.WriteLine($"Compression failed with code: {result}");
                     return;
@@ -65,7 +70,7 @@ class Program
             using (var inputStream = new FileStream(decompressInput, FileMode.Open, FileAccess.Read))
             using (var outputStream = new FileStream(decompressedPath, FileMode.Create, FileAccess.Write))
             {
-                int result = Compressor.DecompressOmp(inputStream, outputStream, 0);
+                int result = LibscSharp.BSCDecompress(inputStream, outputStream, 0);
                 if (result < 0)
                 {
                     Console.WriteLine($"Decompression failed with code: {result}");
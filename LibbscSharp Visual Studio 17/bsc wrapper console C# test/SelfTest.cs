@@ -0,0 +1,222 @@
+﻿using System;
+using System.IO;
+using BscDotNet;
+using LibbscSharp;
+
+// Round trips generated data through every entry point of the wrapper, run with --self-test.
+// Returns the number of failed checks, 0 when every round trip gives back the input.
+static class SelfTest
+{
+    const int DataSize = 3 * 1024 * 1024;
+
+    static int failures;
+
+    static void Check(bool condition, string name, string what)
+    {
+        if (condition) return;
+        Console.WriteLine($"{name}: {what}");
+        failures++;
+    }
+
+    // a network or GZip like source or sink: no Length, no Position
+    sealed class ForwardOnlyStream : Stream
+    {
+        readonly Stream inner;
+
+        public ForwardOnlyStream(Stream inner) { this.inner = inner; }
+
+        public override bool CanRead => inner.CanRead;
+        public override bool CanSeek => false;
+        public override bool CanWrite => inner.CanWrite;
+        public override long Length => throw new NotSupportedException();
+        public override long Position { get => throw new NotSupportedException(); set => throw new NotSupportedException(); }
+        public override void Flush() => inner.Flush();
+        public override int Read(byte[] buffer, int offset, int count) => inner.Read(buffer, offset, Math.Min(count, 100000));
+        public override void Write(byte[] buffer, int offset, int count) => inner.Write(buffer, offset, count);
+        public override long Seek(long offset, SeekOrigin origin) => throw new NotSupportedException();
+        public override void SetLength(long value) => throw new NotSupportedException();
+    }
+
+    static bool Same(byte[] actual, byte[] expected, int offset, int count)
+    {
+        if (actual.Length != count) return false;
+        for (int i = 0; i < count; ++i) if (actual[i] != expected[offset + i]) return false;
+        return true;
+    }
+
+    static byte[] Edited(byte[] data)
+    {
+        byte[] edited = (byte[])data.Clone();
+        byte[] edit = System.Text.Encoding.ASCII.GetBytes("an edit in the middle of the new version");
+        Buffer.BlockCopy(edit, 0, edited, data.Length / 2, edit.Length);
+        return edited;
+    }
+
+    static MemoryStream Visible(byte[] data)
+    {
+        // publiclyVisible lets the wrapper take the buffer without a copy
+        return new MemoryStream(data, 0, data.Length, false, true);
+    }
+
+    static void CheckSignature(string name, byte[] container, char signature)
+    {
+        Check(container.Length > 4 && container[0] == 'b' && container[1] == 's' && container[2] == 'c' && container[3] == signature, name, $"expected a bsc{signature} container");
+    }
+
+    // decodes through the buffer and the stream paths of BSCDecompress
+    static void CheckDecompress(string name, byte[] container, byte[] expected)
+    {
+        using (var output = new MemoryStream())
+        {
+            int result = LibscSharp.BSCDecompress(Visible(container), output);
+            Check(result >= 0 && Same(output.ToArray(), expected, 0, expected.Length), name, $"BSCDecompress from memory failed ({result})");
+        }
+
+        using (var output = new MemoryStream())
+        {
+            int result = LibscSharp.BSCDecompress(new ForwardOnlyStream(new MemoryStream(container)), new ForwardOnlyStream(output));
+            Check(result >= 0 && Same(output.ToArray(), expected, 0, expected.Length), name, $"BSCDecompress to a forward-only stream failed ({result})");
+        }
+    }
+
+    static void TestCompress(byte[] data)
+    {
+        using (var output = new MemoryStream())
+        {
+            int result = LibscSharp.BSCCompress(Visible(data), output, 1, 0, 1024 * 1024);
+            Check(result >= 0, "BSCCompress memory", $"failed ({result})");
+            CheckSignature("BSCCompress memory", output.ToArray(), '1');
+            CheckDecompress("BSCCompress memory", output.ToArray(), data);
+        }
+
+        string path = Path.GetTempFileName();
+        try
+        {
+            File.WriteAllBytes(path, data);
+            using (var input = new FileStream(path, FileMode.Open, FileAccess.Read))
+            using (var output = new MemoryStream())
+            {
+                // a FileStream goes through CompressStream, a few blocks in memory at a time
+                int result = LibscSharp.BSCCompress(input, output, 2, 0, 512 * 1024);
+                Check(result >= 0, "BSCCompress stream", $"failed ({result})");
+                CheckDecompress("BSCCompress stream", output.ToArray(), data);
+            }
+        }
+        finally
+        {
+            File.Delete(path);
+        }
+
+        using (var output = new MemoryStream())
+        {
+            int result = LibscSharp.BSCCompress(new ForwardOnlyStream(new MemoryStream(data)), output, 3, 0, 1024 * 1024);
+            Check(result >= 0, "BSCCompress forward-only", $"failed ({result})");
+            CheckDecompress("BSCCompress forward-only", output.ToArray(), data);
+        }
+
+        using (var output = new MemoryStream())
+        {
+            // the caller knows the size, the forward-only source is streamed without a temporary file
+            int result = LibscSharp.BSCCompress(new ForwardOnlyStream(new MemoryStream(data)), data.Length, output, 1, 0, 512 * 1024, false);
+            Check(result >= 0, "BSCCompress forward-only length", $"failed ({result})");
+            CheckDecompress("BSCCompress forward-only length", output.ToArray(), data);
+        }
+
+        using (var output = new MemoryStream())
+        {
+            Check(LibscSharp.BSCCompress(new ForwardOnlyStream(new MemoryStream(data)), data.Length + 1L, output, 1, 0, 512 * 1024, false) < 0, "BSCCompress forward-only length", "source shorter than its length accepted");
+        }
+    }
+
+    static void TestDecompressRange(byte[] data)
+    {
+        foreach (bool writeIndex in new[] { false, true })
+        {
+            string name = writeIndex ? "BSCDecompressRange index" : "BSCDecompressRange";
+
+            byte[] container;
+            using (var output = new MemoryStream())
+            {
+                Check(LibscSharp.BSCCompress(Visible(data), output, 1, 0, 512 * 1024, writeIndex) >= 0, name, "BSCCompress failed");
+                container = output.ToArray();
+            }
+
+            long[][] ranges = { new long[] { 0, 1 }, new long[] { data.Length / 3 - 1000, 700000 }, new long[] { data.Length - 4096, 4096 } };
+            foreach (long[] range in ranges)
+            {
+                using (var output = new MemoryStream())
+                {
+                    int result = LibscSharp.BSCDecompressRange(new MemoryStream(container), output, range[0], range[1]);
+                    Check(result >= 0 && Same(output.ToArray(), data, (int)range[0], (int)range[1]), name, $"range {range[0]}+{range[1]} failed ({result})");
+                }
+            }
+
+            using (var output = new MemoryStream())
+            {
+                Check(LibscSharp.BSCDecompressRange(new MemoryStream(container), output, data.Length - 10, 11) < 0, name, "range past the end accepted");
+            }
+
+            bool thrown = false;
+            try { LibscSharp.BSCDecompressRange(new ForwardOnlyStream(new MemoryStream(container)), new MemoryStream(), 0, 1); }
+            catch (NotSupportedException) { thrown = true; }
+            Check(thrown, name, "forward-only input accepted");
+        }
+    }
+
+    static void TestCompressor(byte[] data)
+    {
+        using (var output = new MemoryStream())
+        {
+            int result = Compressor.CompressOmp(data, data.Length, output, 64 * 1024, 0, 16, 128, 1, 1, false, 0, true);
+            Check(result >= 0, "CompressOmp deduplicate", $"failed ({result})");
+            CheckSignature("CompressOmp deduplicate", output.ToArray(), '2');
+            CheckDecompress("CompressOmp deduplicate", output.ToArray(), data);
+        }
+
+        using (var output = new MemoryStream())
+        {
+            int result = Compressor.CompressOmp(data, data.Length, output, 1024 * 1024, 0, 16, 128, 1, 1, false, 0, false, true);
+            Check(result >= 0, "CompressOmp longRange", $"failed ({result})");
+            CheckSignature("CompressOmp longRange", output.ToArray(), '3');
+            CheckDecompress("CompressOmp longRange", output.ToArray(), data);
+        }
+
+        using (var previous = new MemoryStream())
+        using (var output = new MemoryStream())
+        {
+            byte[] edited = Edited(data);
+
+            Check(Compressor.CompressIncremental(data, data.Length, null, 0, previous, 256 * 1024, 0, 16, 128, 1, 1, 64 * 1024) >= 0, "CompressIncremental", "previous version failed");
+            byte[] previousData = previous.ToArray();
+
+            int result = Compressor.CompressIncremental(edited, edited.Length, previousData, previousData.Length, output, 256 * 1024, 0, 16, 128, 1, 1, 64 * 1024);
+            Check(result >= 0, "CompressIncremental", $"failed ({result})");
+            CheckDecompress("CompressIncremental", output.ToArray(), edited);
+        }
+
+        string inputPath = Path.GetTempFileName(), containerPath = Path.GetTempFileName(), outputPath = Path.GetTempFileName();
+        try
+        {
+            File.WriteAllBytes(inputPath, data);
+            Check(Compressor.CompressFile(inputPath, containerPath, 1024 * 1024, 0, 16, 128, 1, 1) >= 0, "CompressFile", "failed");
+            Check(Compressor.DecompressFile(containerPath, outputPath, 0) >= 0, "DecompressFile", "failed");
+            Check(Same(File.ReadAllBytes(outputPath), data, 0, data.Length), "DecompressFile", "round trip mismatch");
+        }
+        finally
+        {
+            File.Delete(inputPath); File.Delete(containerPath); File.Delete(outputPath);
+        }
+    }
+
+    public static int Run()
+    {
+        byte[] data = TestData.Generate(DataSize);
+
+        TestCompress(data);
+        TestDecompressRange(data);
+        TestCompressor(data);
+
+        Console.WriteLine(failures == 0 ? "All round trips passed." : $"{failures} check(s) failed.");
+        return failures;
+    }
+}
@@ -3,8 +3,10 @@
 #include "bscwrapperCLR.h"
 #include "libbsc.h"
 #include "filters.h"
+#include "container/container.h"
 #include "omp.h"
 #include "iostream"
+#include "vcclr.h"
 #include "msclr/marshal.h"
 
 
@@ -15,6 +17,7 @@
 #define LIBBSC_COMPLVL_OUTRANGE      -20
 #define LIBBSC_BAD_PARAM             -21
 #define LIBBSC_NOT_SEEKABLE          -23
+#define LIBBSC_STREAM_ERROR          -24
 
 using namespace System;
 using namespace System::IO;
@@ -29,6 +32,102 @@ typedef struct BSC_BLOCK_HEADER
     signed char     sortingContexts;
 } BSC_BLOCK_HEADER;
 
+// Managed output stream seen by the native container callbacks
+struct BscStreamContext
+{
+    gcroot<Stream^>                 stream;
+    gcroot<array<unsigned char>^>   buffer;
+    long long                       origin;     // position of the container in a seekable stream
+};
+
+static int BscStreamWrite(void* context, const unsigned char* data, int size)
+{
+    BscStreamContext* streamContext = (BscStreamContext*)context;
+    try
+    {
+        array<unsigned char>^ buffer = streamContext->buffer;
+        if (buffer == nullptr || buffer->Length < size)
+        {
+            buffer = gcnew array<unsigned char>(size);
+            streamContext->buffer = buffer;
+        }
+
+        Marshal::Copy(IntPtr((void*)data), buffer, 0, size);
+        streamContext->stream->Write(buffer, 0, size);
+    }
+    catch (Exception^)
+    {
+        // Never let a managed exception unwind through the OpenMP workers
+        return LIBBSC_STREAM_ERROR;
+    }
+    return LIBBSC_NO_ERROR;
+}
+
+static int BscStreamWriteAt(void* context, long long position, const unsigned char* data, int size)
+{
+    BscStreamContext* streamContext = (BscStreamContext*)context;
+    try
+    {
+        streamContext->stream->Position = streamContext->origin + position;
+    }
+    catch (Exception^)
+    {
+        return LIBBSC_STREAM_ERROR;
+    }
+    return BscStreamWrite(context, data, size);
+}
+
+static int BscStreamRead(void* context, unsigned char* data, int size)
+{
+    BscStreamContext* streamContext = (BscStreamContext*)context;
+    try
+    {
+        // Read by chunks of at most 1 MB to keep the managed staging buffer small
+        if (size > 1024 * 1024) size = 1024 * 1024;
+
+        array<unsigned char>^ buffer = streamContext->buffer;
+        if (buffer == nullptr || buffer->Length < size)
+        {
+            buffer = gcnew array<unsigned char>(size);
+            streamContext->buffer = buffer;
+        }
+
+        int read = streamContext->stream->Read(buffer, 0, size);
+        if (read > 0) Marshal::Copy(buffer, 0, IntPtr(data), read);
+        return read;
+    }
+    catch (Exception^)
+    {
+        return LIBBSC_STREAM_ERROR;
+    }
+}
+
+static int BscStreamReadAt(void* context, long long position, unsigned char* data, int size)
+{
+    BscStreamContext* streamContext = (BscStreamContext*)context;
+    try
+    {
+        streamContext->stream->Position = streamContext->origin + position;
+    }
+    catch (Exception^)
+    {
+        return LIBBSC_STREAM_ERROR;
+    }
+    return BscStreamRead(context, data, size);
+}
+
+static void BscContainerParams(bsc_container_params* params, int blockSize, int numThreads, int lzpHashSize, int lzpMinLen, int blockSorter, int coder)
+{
+    bsc_container_default_params(params);
+
+    params->blockSize = blockSize;
+    params->numThreads = numThreads;
+    params->blockSorter = blockSorter;
+    params->coder = coder;
+    if (lzpHashSize != 0) params->lzpHashSize = lzpHashSize;
+    if (lzpMinLen != 0) params->lzpMinLen = lzpMinLen;
+}
+
 
 /**
 Compress a stream of data.
@@ -37,8 +136,8 @@ Compress a stream of data.
 @param outputStream                - the output compressed data including global header + blocks headers
 @param blockSize                   - the maximum block size in Byte to compress sequentially, higher value improve ratio while consuming more RAM. Default if 25 MB.
 @param NumThreads                  - the number of threads to use if the file is multy-blocks (depend on input size and block size)
-@param lzpHashSize                 - the hash table size if LZP enabled, 0 otherwise. Must be in range [0, 10..28].
-@param lzpMinLen                   - the minimum match length if LZP enabled, 0 otherwise. Must be in range [0, 4..255].
+@param lzpHashSize                 - the hash table size if LZP enabled, 0 otherwise. Must be in range [-1, 0, 10..28], -1 sizes it per block.
+@param lzpMinLen                   - the minimum match length if LZP enabled, 0 otherwise. Must be in range [-1, 0, 4..255], -1 picks it per block and disables LZP where it does not pay.
 @param blockSorter                 - the block sorting algorithm. Must be in range [ST3..ST8, BWT].
 @param coder                       - the entropy coding algorithm. Must be in range 1..3
 @return 0 if succed, nagative value for error code
@@ -53,102 +152,265 @@ int BscDotNet::Compressor::CompressOmp(
     int lzpMinLen,
     int blockSorter,
     int coder)
+{
+    return CompressOmp(inputData, dataLength, outputStream, blockSize, NumThreads, lzpHashSize, lzpMinLen, blockSorter, coder, false);
+}
+
+/**
+Compress a stream of data, optionally followed by the block index used by DecompressRange.
+@param writeIndex                  - true to append the index footer, readers unaware of it still decompress the file
+@return 0 if succed, nagative value for error code
+*/
+int BscDotNet::Compressor::CompressOmp(
+    array<unsigned char>^ inputData,
+    long long dataLength,
+    Stream^ outputStream,
+    int blockSize,
+    int NumThreads,
+    int lzpHashSize,
+    int lzpMinLen,
+    int blockSorter,
+    int coder,
+    bool writeIndex)
+{
+    return CompressOmp(inputData, dataLength, outputStream, blockSize, NumThreads, lzpHashSize, lzpMinLen, blockSorter, coder, writeIndex, 0);
+}
+
+/**
+Compress a stream of data with content-aware block boundaries.
+@param minBlockSize                - 0 for fixed blocks of blockSize, otherwise blocks are cut where the content changes, between minBlockSize and blockSize bytes
+@return 0 if succed, nagative value for error code
+*/
+int BscDotNet::Compressor::CompressOmp(
+    array<unsigned char>^ inputData,
+    long long dataLength,
+    Stream^ outputStream,
+    int blockSize,
+    int NumThreads,
+    int lzpHashSize,
+    int lzpMinLen,
+    int blockSorter,
+    int coder,
+    bool writeIndex,
+    int minBlockSize)
+{
+    return CompressOmp(inputData, dataLength, outputStream, blockSize, NumThreads, lzpHashSize, lzpMinLen, blockSorter, coder, writeIndex, minBlockSize, false);
+}
+
+/**
+Compress a stream of data, writing repeated blocks as references to their first occurrence.
+@param deduplicate                 - true to replace repeated blocks by references, such files need a reader that knows the bsc2 signature
+@return 0 if succed, nagative value for error code
+*/
+int BscDotNet::Compressor::CompressOmp(
+    array<unsigned char>^ inputData,
+    long long dataLength,
+    Stream^ outputStream,
+    int blockSize,
+    int NumThreads,
+    int lzpHashSize,
+    int lzpMinLen,
+    int blockSorter,
+    int coder,
+    bool writeIndex,
+    int minBlockSize,
+    bool deduplicate)
+{
+    return CompressOmp(inputData, dataLength, outputStream, blockSize, NumThreads, lzpHashSize, lzpMinLen, blockSorter, coder, writeIndex, minBlockSize, deduplicate, false);
+}
+
+/**
+Compress a stream of data, writing repeats of 32KB or more anywhere in the input as references to their earlier occurrence.
+@param longRange                   - true to find repeats across block boundaries, it supersedes deduplicate. Such files need a reader that knows the bsc3 signature
+@return 0 if succed, nagative value for error code
+*/
+int BscDotNet::Compressor::CompressOmp(
+    array<unsigned char>^ inputData,
+    long long dataLength,
+    Stream^ outputStream,
+    int blockSize,
+    int NumThreads,
+    int lzpHashSize,
+    int lzpMinLen,
+    int blockSorter,
+    int coder,
+    bool writeIndex,
+    int minBlockSize,
+    bool deduplicate,
+    bool longRange)
 {
     if (inputData == nullptr || outputStream == nullptr) return LIBBSC_BAD_PARAM;
     if (!outputStream->CanWrite) return LIBBSC_BAD_PARAM;
     if (coder < 1 || coder > 3) return LIBBSC_COMPLVL_OUTRANGE;
+    if (dataLength <= 0 || dataLength > inputData->LongLength || blockSize <= 0 || minBlockSize < 0) return LIBBSC_BAD_PARAM;
 
-    if (lzpHashSize == 0) lzpHashSize = 16;
-    if (lzpMinLen == 0) lzpMinLen = 128;
-
-    int features = LIBBSC_DEFAULT_FEATURES;
-    signed char sortingContexts = LIBBSC_CONTEXTS_FOLLOWING;
+    bsc_container_params params;
+    BscContainerParams(&params, blockSize, NumThreads, lzpHashSize, lzpMinLen, blockSorter, coder);
+    params.writeIndex = writeIndex;
+    params.minBlockSize = minBlockSize;
+    params.deduplicate = deduplicate;
+    params.longRange = longRange;
 
-    if (NumThreads > 0)
-        omp_set_num_threads(NumThreads);
+    bsc_init(params.features);
 
-    bsc_init(features);
+    // Every worker compresses into its own arena, finished blocks are written in order through the callback
+    BscStreamContext context;
+    context.stream = outputStream;
 
-    // Calc block number :
-    long long fileSize = dataLength; // inputData->Length;
-    if (fileSize == 0) {
-        return LIBBSC_BAD_PARAM;
-    }
-    int nBlocks = (blockSize > 0) ? (int)((fileSize + (long long)blockSize - 1) / blockSize) : 0;
+    pin_ptr<unsigned char> pinInput = &inputData[0];
+    return bsc_container_compress(pinInput, dataLength, &params, BscStreamWrite, &context);
+}
 
-    // Write global header
-    outputStream->Write(gcnew array<Byte>{ 'b', 's', 'c', 0x31 }, 0, 4);
-    array<Byte>^ nBlocksBytes = gcnew array<Byte>(4);
-    pin_ptr<Byte> pinN = &nBlocksBytes[0];
-    *(int*)pinN = nBlocks;
-    outputStream->Write(nBlocksBytes, 0, 4);
+/**
+Compress a new version of some data, copying the compressed blocks that did not change from the container of the previous version.
+The output always carries the block hashes, so it can be the previousData of the next call.
+@param previousData                - the container of the previous version written by this function, nullptr for a first full compression
+@param previousLength              - the length of the previous container
+@param cdcBlockSize                - the average size of content-defined blocks, an edit then only changes the blocks around it. 0 for fixed blocks of blockSize
+@return 0 if succed, nagative value for error code, LIBBSC_NOT_SUPPORTED if previousData has no block hashes
+*/
+int BscDotNet::Compressor::CompressIncremental(
+    array<unsigned char>^ inputData,
+    long long dataLength,
+    array<unsigned char>^ previousData,
+    long long previousLength,
+    Stream^ outputStream,
+    int blockSize,
+    int NumThreads,
+    int lzpHashSize,
+    int lzpMinLen,
+    int blockSorter,
+    int coder,
+    int cdcBlockSize)
+{
+    if (inputData == nullptr || outputStream == nullptr) return LIBBSC_BAD_PARAM;
+    if (!outputStream->CanWrite) return LIBBSC_BAD_PARAM;
+    if (coder < 1 || coder > 3) return LIBBSC_COMPLVL_OUTRANGE;
+    if (dataLength <= 0 || dataLength > inputData->LongLength || blockSize <= 0 || cdcBlockSize < 0) return LIBBSC_BAD_PARAM;
+    if (previousData != nullptr && (previousLength <= 0 || previousLength > previousData->LongLength)) return LIBBSC_BAD_PARAM;
 
-    signed char recordSize = 1;
-    int compressionError = LIBBSC_NO_ERROR;
+    bsc_container_params params;
+    BscContainerParams(&params, blockSize, NumThreads, lzpHashSize, lzpMinLen, blockSorter, coder);
+    params.writeIndex = LIBBSC_CONTAINER_INDEX_HASHES;
+    params.cdcBlockSize = cdcBlockSize;
 
-    // Pre-allocate one temporary working buffer per thread (max block size + header + safety)
-    const int headerSize = 10;
-    const int extraSafety = 2048;
-    array<unsigned char>^ tempBuffer = gcnew array<unsigned char>(blockSize + headerSize + extraSafety);
+    bsc_init(params.features);
 
-    pin_ptr<unsigned char> pinTemp = &tempBuffer[0];
-    unsigned char* workBuffer = pinTemp;
+    BscStreamContext context;
+    context.stream = outputStream;
 
-#pragma omp parallel for schedule(dynamic) if(nBlocks > 1)
-    for (int blockIndex = 0; blockIndex < nBlocks; blockIndex++)
+    // The previous container is only read, its compressed blocks are copied while both arrays are pinned
+    pin_ptr<unsigned char> pinPrevious = nullptr;
+    if (previousData != nullptr)
     {
-        if (compressionError != LIBBSC_NO_ERROR) continue;
+        pinPrevious = &previousData[0];
+        params.previous = pinPrevious;
+        params.previousSize = previousLength;
+    }
 
-        long long blockOffset = (long long)blockIndex * blockSize;
-        int currentBlockSize = (int)System::Math::Min((long long)blockSize, fileSize - blockOffset);
+    pin_ptr<unsigned char> pinInput = &inputData[0];
+    return bsc_container_compress(pinInput, dataLength, &params, BscStreamWrite, &context);
+}
 
-        // Pin the input block directly from inputData
-        pin_ptr<unsigned char> pinInput = &inputData[(int)blockOffset];
-        unsigned char* inputPtr = pinInput;
+/**
+Compress a stream of data without loading it in memory, only NumThreads + 2 blocks are held at a time.
+Reading, compression and writing run on separate threads and overlap.
+@param inputStream                 - the input data to compress, read from its current position
+@param dataLength                  - the number of bytes to compress from inputStream
+@param outputStream                - the output compressed data including global header + blocks headers
+@param blockSize                   - the maximum block size in Byte, RAM consumption is about 2x block size per thread
+@param NumThreads                  - the number of blocks compressed concurrently (0 = all cores)
+@param lzpHashSize                 - the hash table size if LZP enabled, 0 otherwise. Must be in range [-1, 0, 10..28], -1 sizes it per block.
+@param lzpMinLen                   - the minimum match length if LZP enabled, 0 otherwise. Must be in range [-1, 0, 4..255], -1 picks it per block and disables LZP where it does not pay.
+@param blockSorter                 - the block sorting algorithm. Must be in range [ST3..ST8, BWT].
+@param coder                       - the entropy coding algorithm. Must be in range 1..3
+@return 0 if succed, nagative value for error code
+*/
+int BscDotNet::Compressor::CompressStream(
+    Stream^ inputStream,
+    long long dataLength,
+    Stream^ outputStream,
+    int blockSize,
+    int NumThreads,
+    int lzpHashSize,
+    int lzpMinLen,
+    int blockSorter,
+    int coder)
+{
+    return CompressStream(inputStream, dataLength, outputStream, blockSize, NumThreads, lzpHashSize, lzpMinLen, blockSorter, coder, false);
+}
 
-        // Copy input block to temp buffer + header space
-        // This is the ONLY copy we do per block
-        std::memcpy(workBuffer + headerSize, inputPtr, currentBlockSize);
+/**
+Compress a stream of data without loading it in memory, optionally followed by the block index used by DecompressRange.
+@param writeIndex                  - true to append the index footer, readers unaware of it still decompress the file
+@return 0 if succed, nagative value for error code
+*/
+int BscDotNet::Compressor::CompressStream(
+    Stream^ inputStream,
+    long long dataLength,
+    Stream^ outputStream,
+    int blockSize,
+    int NumThreads,
+    int lzpHashSize,
+    int lzpMinLen,
+    int blockSorter,
+    int coder,
+    bool writeIndex)
+{
+    if (inputStream == nullptr || outputStream == nullptr) return LIBBSC_BAD_PARAM;
+    if (!inputStream->CanRead || !outputStream->CanWrite) return LIBBSC_BAD_PARAM;
+    if (coder < 1 || coder > 3) return LIBBSC_COMPLVL_OUTRANGE;
+    if (dataLength <= 0 || blockSize <= 0) return LIBBSC_BAD_PARAM;
 
-        // In-place compression: input and output are the same (after header)
-        unsigned char* compressPtr = workBuffer + headerSize;
+    bsc_container_params params;
+    BscContainerParams(&params, blockSize, NumThreads, lzpHashSize, lzpMinLen, blockSorter, coder);
+    params.writeIndex = writeIndex;
 
-        int compressedSize = bsc_compress(
-            compressPtr,           // input
-            compressPtr,           // output == input → triggers in-place path
-            currentBlockSize,
-            lzpHashSize,
-            lzpMinLen,
-            blockSorter,
-            coder,
-            features);
+    bsc_init(params.features);
 
-        if (compressedSize < 0)
-        {
-#pragma omp critical(error)
-            {
-                if (compressionError == LIBBSC_NO_ERROR)
-                    compressionError = compressedSize;
-            }
-        continue;
-        }
+    BscStreamContext readContext;
+    readContext.stream = inputStream;
 
-        // Write block header
-        uint64_t offset64 = (uint64_t)blockOffset;
-        std::memcpy(workBuffer + 0, &offset64, 8);
-        workBuffer[8] = (unsigned char)recordSize;
-        workBuffer[9] = (unsigned char)sortingContexts;
+    BscStreamContext writeContext;
+    writeContext.stream = outputStream;
 
-        // Write header + compressed data in one go
-#pragma omp critical(output_stream)
-        {
-            pin_ptr<unsigned char> pinWrite = workBuffer;
-            array<Byte>^ writeArray = tempBuffer; // reuse the same array
-            outputStream->Write(writeArray, 0, headerSize + compressedSize);
-        }
-    }
+    return bsc_container_compress_stream(BscStreamRead, &readContext, dataLength, &params, BscStreamWrite, &writeContext);
+}
 
-    return compressionError != LIBBSC_NO_ERROR ? compressionError : LIBBSC_NO_ERROR;
+/**
+Compress a file into a bsc1 container file without going through managed memory.
+On Linux the input is memory mapped and every block worker reads its slice straight from the mapping.
+@param inputPath                   - the file to compress
+@param outputPath                  - the container file to create or overwrite
+@param blockSize                   - the maximum block size in Byte
+@param NumThreads                  - the number of blocks compressed concurrently (0 = all cores)
+@param lzpHashSize                 - the hash table size if LZP enabled, 0 otherwise. Must be in range [-1, 0, 10..28], -1 sizes it per block.
+@param lzpMinLen                   - the minimum match length if LZP enabled, 0 otherwise. Must be in range [-1, 0, 4..255], -1 picks it per block and disables LZP where it does not pay.
+@param blockSorter                 - the block sorting algorithm. Must be in range [ST3..ST8, BWT].
+@param coder                       - the entropy coding algorithm. Must be in range 1..3
+@return 0 if succed, nagative value for error code
+*/
+int BscDotNet::Compressor::CompressFile(
+    String^ inputPath,
+    String^ outputPath,
+    int blockSize,
+    int NumThreads,
+    int lzpHashSize,
+    int lzpMinLen,
+    int blockSorter,
+    int coder)
+{
+    if (String::IsNullOrEmpty(inputPath) || String::IsNullOrEmpty(outputPath)) return LIBBSC_BAD_PARAM;
+    if (coder < 1 || coder > 3) return LIBBSC_COMPLVL_OUTRANGE;
+    if (blockSize <= 0) return LIBBSC_BAD_PARAM;
+
+    bsc_container_params params;
+    BscContainerParams(&params, blockSize, NumThreads, lzpHashSize, lzpMinLen, blockSorter, coder);
+
+    bsc_init(params.features);
+
+    msclr::interop::marshal_context marshal;
+    return bsc_container_compress_file(marshal.marshal_as<const char*>(inputPath), marshal.marshal_as<const char*>(outputPath), &params);
 }
 
 /**
@@ -258,156 +520,87 @@ int BscDotNet::Compressor::DecompressOmp(
     if (!outputStream->CanWrite || !outputStream->CanSeek) return LIBBSC_BAD_PARAM;
 
     bsc_init(LIBBSC_DEFAULT_FEATURES);
-    int features = LIBBSC_DEFAULT_FEATURES;
 
-#ifdef _OPENMP
-    if (numThreads > 0) omp_set_num_threads(numThreads);
-#endif
+    // The block table is built in one pass (or read from the index footer) before decoding,
+    // blocks are then independent jobs and only the positioned writes are serialized
+    BscStreamContext context;
+    context.stream = outputStream;
+    context.origin = outputStream->Position;
 
     pin_ptr<unsigned char> pinInput = &inputData[0];
-    unsigned char* inputPtr = pinInput;
+    return bsc_container_decompress(pinInput, dataLength, numThreads, LIBBSC_DEFAULT_FEATURES, BscStreamWriteAt, &context);
+}
 
-    long long pos = 0;
+/**
+* Decompress a stream of data to a forward-only output (pipes, HTTP bodies...), neither stream needs to be seekable.
+* Blocks are decoded in parallel and written strictly in order, memory is bounded to about 2 blocks per thread.
+* @param inputStream                        - the compressed input data, read from its current position
+* @param outputStream                       - the output decompressed data result
+* @param numThreads                         - the number of blocks decoded concurrently (0 = all cores)
+* @return 0 if succed, nagative value for error code
+*/
+int BscDotNet::Compressor::DecompressStream(Stream^ inputStream, Stream^ outputStream, int numThreads)
+{
+    if (inputStream == nullptr || outputStream == nullptr) return LIBBSC_BAD_PARAM;
+    if (!inputStream->CanRead || !outputStream->CanWrite) return LIBBSC_BAD_PARAM;
 
-    // Global header check (single-threaded, safe)
-    if (dataLength < 8 ||
-        inputPtr[0] != 'b' || inputPtr[1] != 's' || inputPtr[2] != 'c' || inputPtr[3] != 0x31)
-        return LIBBSC_NOT_SUPPORTED;
+    bsc_init(LIBBSC_DEFAULT_FEATURES);
 
-    int nBlocks = *(int*)(inputPtr + 4);
-    if (nBlocks <= 0) return LIBBSC_DATA_CORRUPT;
+    BscStreamContext readContext;
+    readContext.stream = inputStream;
 
-    pos = 8;
+    BscStreamContext writeContext;
+    writeContext.stream = outputStream;
 
-    int decompressionError = LIBBSC_NO_ERROR;
+    return bsc_container_decompress_stream(BscStreamRead, &readContext, numThreads, LIBBSC_DEFAULT_FEATURES, BscStreamWrite, &writeContext);
+}
 
-#pragma omp parallel if(nBlocks > 1) shared(decompressionError, pos)
-    {
-        // Per-thread buffer (start with reasonable size, resize if needed)
-        array<unsigned char>^ threadBuffer = gcnew array<unsigned char>(32 * 1024 * 1024 + 4096);
-        pin_ptr<unsigned char> pinBuf = &threadBuffer[0];
-        unsigned char* buffer = pinBuf;
-        int bufferCapacity = threadBuffer->Length;
+/**
+* Decompress a byte range of the original data, only the blocks touching the range are read and decoded.
+* Uses the index footer written with writeIndex when present, otherwise walks the block headers (no decoding).
+* @param inputStream                        - the compressed input data, seekable, the container starts at its current position
+* @param offset                             - the offset in the original data of the first byte to decompress
+* @param length                             - the number of bytes to decompress
+* @param outputStream                       - the output decompressed range
+* @param numThreads                         - the number of blocks decoded concurrently (0 = all cores)
+* @return 0 if succed, nagative value for error code
+*/
+int BscDotNet::Compressor::DecompressRange(Stream^ inputStream, long long offset, long long length, Stream^ outputStream, int numThreads)
+{
+    if (inputStream == nullptr || outputStream == nullptr) return LIBBSC_BAD_PARAM;
+    if (!inputStream->CanRead || !outputStream->CanWrite) return LIBBSC_BAD_PARAM;
+    if (!inputStream->CanSeek) return LIBBSC_NOT_SEEKABLE;
+    if (offset < 0 || length < 0) return LIBBSC_BAD_PARAM;
+
+    bsc_init(LIBBSC_DEFAULT_FEATURES);
 
-        long long localHeaderPos = 0;
-        int localBlockSize = 0;  // total compressed size including LIBBSC_HEADER_SIZE
+    BscStreamContext readContext;
+    readContext.stream = inputStream;
+    readContext.origin = inputStream->Position;
 
-#pragma omp for schedule(dynamic)
-        for (int blockIndex = 0; blockIndex < nBlocks; blockIndex++)
-        {
-            if (decompressionError != LIBBSC_NO_ERROR) continue;
-
-            long long blockOffset = 0;
-            signed char recordSize = 0;
-            signed char sortingContexts = 0;
-            int dataSize = 0;
-
-            bool blockValid = false;
-
-            // === Fully atomic block header + size reading ===
-#pragma omp critical(input_reading)
-            {
-                if (pos + 10 > dataLength)
-                {
-                    decompressionError = LIBBSC_DATA_CORRUPT;
-                }
-                else
-                {
-                    unsigned char* headerPtr = inputPtr + pos;
-
-                    blockOffset = *(uint64_t*)headerPtr;
-                    recordSize = headerPtr[8];
-                    sortingContexts = headerPtr[9];
-
-                    if (recordSize < 1 ||
-                        (sortingContexts != LIBBSC_CONTEXTS_FOLLOWING && sortingContexts != LIBBSC_CONTEXTS_PRECEDING))
-                    {
-                        decompressionError = LIBBSC_NOT_SUPPORTED;
-                    }
-                    else if (pos + 10 + LIBBSC_HEADER_SIZE > dataLength)
-                    {
-                        decompressionError = LIBBSC_DATA_CORRUPT;
-                    }
-                    else
-                    {
-                        int rc = bsc_block_info(inputPtr + pos + 10, LIBBSC_HEADER_SIZE, &localBlockSize, &dataSize, features);
-                        if (rc != LIBBSC_NO_ERROR)
-                        {
-                            decompressionError = rc;
-                        }
-                        else
-                        {
-                            if (pos + 10 + localBlockSize <= dataLength)
-                            {
-                                localHeaderPos = pos;
-                                pos += 10 + localBlockSize;  // advance only if fully valid
-                                blockValid = true;
-                            }
-                        }
-                    }
-                }
-            }
-
-            if (!blockValid || decompressionError != LIBBSC_NO_ERROR) continue;
-
-            // === Safe copy into thread buffer ===
-            int needed = System::Math::Max(localBlockSize, dataSize);
-            if (needed > bufferCapacity)
-            {
-                threadBuffer = gcnew array<unsigned char>(needed + 4096);
-                pinBuf = &threadBuffer[0];
-                buffer = pinBuf;
-                bufferCapacity = threadBuffer->Length;
-            }
-
-            // This memcpy is now guaranteed safe
-            std::memcpy(buffer, inputPtr + localHeaderPos + 10, localBlockSize);
-
-            // === In-place decompression ===
-            int result = bsc_decompress(buffer, localBlockSize, buffer, dataSize, features);
-            if (result < LIBBSC_NO_ERROR)
-            {
-#pragma omp critical(error_handling)
-                if (decompressionError == LIBBSC_NO_ERROR)
-                    decompressionError = result;
-                continue;
-            }
-
-            if (sortingContexts == LIBBSC_CONTEXTS_PRECEDING)
-            {
-                result = bsc_reverse_block(buffer, dataSize, features);
-                if (result != LIBBSC_NO_ERROR)
-                {
-#pragma omp critical(error_handling)
-                    decompressionError = result;
-                }
-                continue;
-            }
-
-            if (recordSize > 1)
-            {
-                result = bsc_reorder_reverse(buffer, dataSize, recordSize, features);
-                if (result != LIBBSC_NO_ERROR)
-                {
-#pragma omp critical(error_handling)
-                    decompressionError = result;
-                }
-                continue;
-            }
-
-            // === Write output ===
-#pragma omp critical(output_stream)
-            {
-                if (decompressionError == LIBBSC_NO_ERROR)
-                {
-                    outputStream->Position = blockOffset;
-                    outputStream->Write(threadBuffer, 0, dataSize);
-                }
-            }
-        }
-    }
+    BscStreamContext writeContext;
+    writeContext.stream = outputStream;
+
+    long long size = inputStream->Length - readContext.origin;
+    return bsc_container_decompress_range(BscStreamReadAt, &readContext, size, offset, length, numThreads, LIBBSC_DEFAULT_FEATURES, BscStreamWrite, &writeContext);
+}
+
+/**
+* Decompress a bsc1 container file into a file without going through managed memory.
+* On Linux both files are memory mapped and every block is decoded in parallel straight at its offset in the output.
+* @param inputPath                          - the container file to decompress
+* @param outputPath                         - the file to create or overwrite
+* @param numThreads                         - the number of blocks decoded concurrently (0 = all cores)
+* @return 0 if succed, nagative value for error code
+*/
+int BscDotNet::Compressor::DecompressFile(String^ inputPath, String^ outputPath, int numThreads)
+{
+    if (String::IsNullOrEmpty(inputPath) || String::IsNullOrEmpty(outputPath)) return LIBBSC_BAD_PARAM;
+
+    bsc_init(LIBBSC_DEFAULT_FEATURES);
 
-    return decompressionError != LIBBSC_NO_ERROR ? decompressionError : LIBBSC_NO_ERROR;
+    msclr::interop::marshal_context marshal;
+    return bsc_container_decompress_file(marshal.marshal_as<const char*>(inputPath), marshal.marshal_as<const char*>(outputPath), numThreads, LIBBSC_DEFAULT_FEATURES);
 }
 
 /*
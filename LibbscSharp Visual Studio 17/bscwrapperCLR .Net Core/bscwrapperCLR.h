@@ -7,7 +7,18 @@ namespace BscDotNet {
     public:
         // OMP
         static int CompressOmp(array<unsigned char>^ inputData, long long dataLength, Stream^ outputStream, int blockSize, int NumThreads, int lzpHashSize, int lzpMinLen, int blockSorter, int coder);
+        static int CompressOmp(array<unsigned char>^ inputData, long long dataLength, Stream^ outputStream, int blockSize, int NumThreads, int lzpHashSize, int lzpMinLen, int blockSorter, int coder, bool writeIndex);
+        static int CompressOmp(array<unsigned char>^ inputData, long long dataLength, Stream^ outputStream, int blockSize, int NumThreads, int lzpHashSize, int lzpMinLen, int blockSorter, int coder, bool writeIndex, int minBlockSize);
+        static int CompressOmp(array<unsigned char>^ inputData, long long dataLength, Stream^ outputStream, int blockSize, int NumThreads, int lzpHashSize, int lzpMinLen, int blockSorter, int coder, bool writeIndex, int minBlockSize, bool deduplicate);
+        static int CompressOmp(array<unsigned char>^ inputData, long long dataLength, Stream^ outputStream, int blockSize, int NumThreads, int lzpHashSize, int lzpMinLen, int blockSorter, int coder, bool writeIndex, int minBlockSize, bool deduplicate, bool longRange);
+        static int CompressIncremental(array<unsigned char>^ inputData, long long dataLength, array<unsigned char>^ previousData, long long previousLength, Stream^ outputStream, int blockSize, int NumThreads, int lzpHashSize, int lzpMinLen, int blockSorter, int coder, int cdcBlockSize);
+        static int CompressStream(Stream^ inputStream, long long dataLength, Stream^ outputStream, int blockSize, int NumThreads, int lzpHashSize, int lzpMinLen, int blockSorter, int coder);
+        static int CompressStream(Stream^ inputStream, long long dataLength, Stream^ outputStream, int blockSize, int NumThreads, int lzpHashSize, int lzpMinLen, int blockSorter, int coder, bool writeIndex);
+        static int CompressFile(String^ inputPath, String^ outputPath, int blockSize, int NumThreads, int lzpHashSize, int lzpMinLen, int blockSorter, int coder);
         static int DecompressOmp(array<unsigned char>^ inputData, long long dataLength, Stream^ outputStream, int numThreads);
+        static int DecompressStream(Stream^ inputStream, Stream^ outputStream, int numThreads);
+        static int DecompressRange(Stream^ inputStream, long long offset, long long length, Stream^ outputStream, int numThreads);
+        static int DecompressFile(String^ inputPath, String^ outputPath, int numThreads);
         
         // Single block
         //static int CompressSingleBlock(Stream^ inputStream, Stream^ outputStream, int lzpHashSize, int lzpMinLen, int blockSorter, int coder);
@@ -0,0 +1,562 @@
+/*-----------------------------------------------------------*/
+/* Block Sorting, Lossless Data Compression Library.         */
+/* Native bsc command-line tool over the bsc1 container      */
+/*-----------------------------------------------------------*/
+
+/*--
+
+This file is a part of LibBSC Sharp, a .NET port of bsc and libbsc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+The command line follows the original bsc tool, files written by one are
+read by the other:
+
+    bsc e inputfile outputfile <options>    compress
+    bsc d inputfile outputfile <options>    decompress
+    bsc b inputfile <options>               benchmark in memory
+
+--*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+
+#include "libbsc.h"
+#include "filters.h"
+#include "platform/platform.h"
+#include "lzp/lzp.h"
+#include "container/container.h"
+
+typedef struct bsc_cli_buffer
+{
+    unsigned char * data;
+    long long       size;
+    long long       capacity;
+} bsc_cli_buffer;
+
+static int bsc_cli_write_buffer(void * context, const unsigned char * data, int size)
+{
+    bsc_cli_buffer * buffer = (bsc_cli_buffer *)context;
+    if (size > buffer->capacity - buffer->size)
+    {
+        return LIBBSC_UNEXPECTED_EOB;
+    }
+
+    memcpy(buffer->data + buffer->size, data, size);
+    buffer->size += size;
+
+    return LIBBSC_NO_ERROR;
+}
+
+static double bsc_cli_seconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static double bsc_cli_speed(long long size, double seconds)
+{
+    return seconds > 0 ? (double)size / seconds / (1024.0 * 1024.0) : 0.0;
+}
+
+static const char * bsc_cli_error(int result)
+{
+    switch (result)
+    {
+        case LIBBSC_BAD_PARAMETER       : return "bad parameter";
+        case LIBBSC_NOT_ENOUGH_MEMORY   : return "not enough memory";
+        case LIBBSC_NOT_SUPPORTED       : return "not a bsc1/bsc2/bsc3 container or unsupported block";
+        case LIBBSC_UNEXPECTED_EOB      : return "unexpected end of data";
+        case LIBBSC_DATA_CORRUPT        : return "data corrupted";
+        case LIBBSC_CONTAINER_IO_ERROR  : return "cannot access file";
+    }
+
+    return "unknown error";
+}
+
+static void bsc_cli_print_stats(const bsc_container_stats * stats)
+{
+    if (stats->storedBlocks > 0)
+    {
+        fprintf(stdout, "  %d blocks stored, %d skipped as incompressible (%lld bytes)\n", stats->storedBlocks, stats->skippedBlocks, stats->skippedBytes);
+    }
+
+    if (stats->dedupBlocks > 0)
+    {
+        fprintf(stdout, "  %d blocks deduplicated (%lld bytes)\n", stats->dedupBlocks, stats->dedupBytes);
+    }
+
+    if (stats->longMatches > 0)
+    {
+        fprintf(stdout, "  %d long-range matches (%lld bytes)\n", stats->longMatches, stats->longBytes);
+    }
+
+    if (stats->reusedBlocks > 0)
+    {
+        fprintf(stdout, "  %d blocks reused from the previous container (%lld bytes)\n", stats->reusedBlocks, stats->reusedBytes);
+    }
+}
+
+static void bsc_cli_usage(void)
+{
+    fprintf(stdout, "Usage: bsc <e|d> inputfile outputfile <options>\n");
+    fprintf(stdout, "       bsc b inputfile <options>\n\n");
+    fprintf(stdout, "Commands:\n");
+    fprintf(stdout, "  e  Compress inputfile into outputfile\n");
+    fprintf(stdout, "  d  Decompress inputfile into outputfile\n");
+    fprintf(stdout, "  b  Benchmark: compress, decompress and verify inputfile in memory\n\n");
+    fprintf(stdout, "Block sorting options:\n");
+    fprintf(stdout, "  -b<size> Block size in megabytes, default: -b25\n");
+    fprintf(stdout, "             minimum: -b1, maximum: -b2047\n");
+    fprintf(stdout, "  -s Enable segmentation (content-aware block boundaries, at least 1MB)\n");
+    fprintf(stdout, "  -m<algorithm> Block sorting algorithm, default: -m0\n");
+    fprintf(stdout, "             -m0 Burrows Wheeler Transform (default)\n");
+    fprintf(stdout, "             -m3..8 Sort Transform of order n\n");
+    fprintf(stdout, "  -e<algorithm> Entropy encoding algorithm, default: -e1\n");
+    fprintf(stdout, "             -e1 Static Quantized Local Frequency Coding (default)\n");
+    fprintf(stdout, "             -e2 Adaptive Quantized Local Frequency Coding (best compression)\n");
+    fprintf(stdout, "             -e3 Fast Quantized Local Frequency Coding\n");
+    fprintf(stdout, "  -c<ctx> Contexts for sorting, default: -ca\n");
+    fprintf(stdout, "             -cf Following contexts\n");
+    fprintf(stdout, "             -cp Preceding contexts\n");
+    fprintf(stdout, "             -ca Autodetect per block (default)\n\n");
+    fprintf(stdout, "Preprocessing options:\n");
+    fprintf(stdout, "  -p Disable Lempel-Ziv preprocessing\n");
+    fprintf(stdout, "  -H<size> LZP dictionary size in bits, default: -H16\n");
+    fprintf(stdout, "             minimum: -H10, maximum: -H28, -Ha Size per block\n");
+    fprintf(stdout, "  -M<size> LZP minimum match length, default: -M128\n");
+    fprintf(stdout, "             minimum: -M4, maximum: -M255\n");
+    fprintf(stdout, "             -Ma Autodetect per block, LZP is disabled where it does not pay\n");
+    fprintf(stdout, "  -B LZP with 4-way hash buckets, fewer matches lost to hash collisions\n");
+    fprintf(stdout, "  -r<size> Record size for reordering, default: -r0\n");
+    fprintf(stdout, "             -r0 Autodetect per block (default), -r1 Disable reordering\n");
+    fprintf(stdout, "             maximum: -r127\n");
+    fprintf(stdout, "  -S<entropy> Store blocks estimated above n/100 bits per byte, default: -S790\n");
+    fprintf(stdout, "             -S0 Always compress, maximum: -S800\n\n");
+    fprintf(stdout, "Container options:\n");
+    fprintf(stdout, "  -I Append the block index footer used for range decompression\n");
+    fprintf(stdout, "  -D Write repeated blocks as references (bsc2 container)\n");
+    fprintf(stdout, "  -L Write repeats of 32KB or more anywhere in the input as references\n");
+    fprintf(stdout, "             (bsc3 container, supersedes -D)\n");
+    fprintf(stdout, "  -C Content-defined blocks of 4MB on average, with block hashes\n");
+    fprintf(stdout, "             (at most a quarter of the block size)\n");
+    fprintf(stdout, "  -u<file> Incremental: copy the blocks found in a previous container\n");
+    fprintf(stdout, "             written with -C, compress only the changed ones\n\n");
+    fprintf(stdout, "Platform specific options:\n");
+    fprintf(stdout, "  -t<threads> Number of blocks processed in parallel, default: all cores\n");
+    fprintf(stdout, "  -T Disable multi-core systems support\n");
+    fprintf(stdout, "  -P Enable large RAM pages (2MB huge pages on Linux)\n");
+}
+
+static bool bsc_cli_number(const char * text, int minimum, int maximum, int * value)
+{
+    char * end = NULL;
+    long number = strtol(text, &end, 10);
+
+    if (end == text || *end != 0 || number < minimum || number > maximum)
+    {
+        return false;
+    }
+
+    *value = (int)number;
+    return true;
+}
+
+static bool bsc_cli_parse(int argc, char * argv[], int first, bsc_container_params * params, const char ** previousFile)
+{
+    bool contentDefined = false;
+
+    for (int i = first; i < argc; ++i)
+    {
+        const char * option = argv[i];
+        if (option[0] != '-' || option[1] == 0)
+        {
+            fprintf(stderr, "Unknown option: %s\n", option);
+            return false;
+        }
+
+        int value = 0;
+        switch (option[1])
+        {
+            case 'b':
+                if (!bsc_cli_number(option + 2, 1, 2047, &value)) { fprintf(stderr, "Bad block size: %s\n", option); return false; }
+                params->blockSize = value * 1024 * 1024;
+                break;
+
+            case 's':
+                params->minBlockSize = LIBBSC_CONTAINER_DEFAULT_MINBLOCKSIZE;
+                break;
+
+            case 'm':
+                if (!bsc_cli_number(option + 2, 0, 8, &value) || value == 1 || value == 2) { fprintf(stderr, "Bad block sorting algorithm: %s\n", option); return false; }
+                params->blockSorter = value == 0 ? LIBBSC_BLOCKSORTER_BWT : value;
+                break;
+
+            case 'e':
+                if (!bsc_cli_number(option + 2, 1, 3, &value)) { fprintf(stderr, "Bad entropy encoding algorithm: %s\n", option); return false; }
+                params->coder = value;
+                break;
+
+            case 'c':
+                if      (strcmp(option + 2, "f") == 0) params->sortingContexts = LIBBSC_CONTEXTS_FOLLOWING;
+                else if (strcmp(option + 2, "p") == 0) params->sortingContexts = LIBBSC_CONTEXTS_PRECEDING;
+                else if (strcmp(option + 2, "a") == 0) params->sortingContexts = LIBBSC_CONTAINER_CONTEXTS_AUTODETECT;
+                else { fprintf(stderr, "Bad contexts for sorting: %s\n", option); return false; }
+                break;
+
+            case 'p':
+                params->lzpHashSize = 0;
+                params->lzpMinLen   = 0;
+                break;
+
+            case 'H':
+                if (strcmp(option + 2, "a") == 0) { params->lzpHashSize = LIBBSC_CONTAINER_LZP_AUTODETECT; break; }
+                if (!bsc_cli_number(option + 2, 10, 28, &value)) { fprintf(stderr, "Bad LZP dictionary size: %s\n", option); return false; }
+                params->lzpHashSize = value;
+                break;
+
+            case 'M':
+                if (strcmp(option + 2, "a") == 0) { params->lzpMinLen = LIBBSC_CONTAINER_LZP_AUTODETECT; break; }
+                if (!bsc_cli_number(option + 2, 4, 255, &value)) { fprintf(stderr, "Bad LZP minimum match length: %s\n", option); return false; }
+                params->lzpMinLen = value;
+                break;
+
+            case 'B':
+                params->features   |= LIBBSC_FEATURE_LZPBUCKETS;
+                break;
+
+            case 'r':
+                if (!bsc_cli_number(option + 2, 0, LIBBSC_CONTAINER_MAX_RECORDSIZE, &value)) { fprintf(stderr, "Bad record size: %s\n", option); return false; }
+                params->recordSize = value;
+                break;
+
+            case 'S':
+                if (!bsc_cli_number(option + 2, 0, 800, &value)) { fprintf(stderr, "Bad store threshold: %s\n", option); return false; }
+                params->storeThreshold = value;
+                break;
+
+            case 'I':
+                params->writeIndex = 1;
+                break;
+
+            case 'D':
+                params->deduplicate = 1;
+                break;
+
+            case 'L':
+                params->longRange = 1;
+                break;
+
+            case 'C':
+                contentDefined = true;
+                break;
+
+            case 'u':
+                if (option[2] == 0) { fprintf(stderr, "Bad previous container: %s\n", option); return false; }
+                *previousFile = option + 2;
+                break;
+
+            case 't':
+                if (!bsc_cli_number(option + 2, 0, 1024, &value)) { fprintf(stderr, "Bad number of threads: %s\n", option); return false; }
+                params->numThreads = value;
+                break;
+
+            case 'T':
+                params->numThreads  = 1;
+                params->features   &= ~LIBBSC_FEATURE_MULTITHREADING;
+                break;
+
+            case 'P':
+                params->features   |= LIBBSC_FEATURE_LARGEPAGES;
+                break;
+
+            default:
+                fprintf(stderr, "Unknown option: %s\n", option);
+                return false;
+        }
+    }
+
+    if ((params->lzpHashSize == 0) != (params->lzpMinLen == 0))
+    {
+        fprintf(stderr, "-H and -M cannot be used together with -p\n");
+        return false;
+    }
+
+    // Applied once the block size is known, whatever the order of the options
+    if (contentDefined)
+    {
+        if (params->minBlockSize > 0)
+        {
+            fprintf(stderr, "-C cannot be used together with -s\n");
+            return false;
+        }
+
+        params->cdcBlockSize    = params->blockSize / 4 < LIBBSC_CONTAINER_DEFAULT_CDCBLOCKSIZE ? params->blockSize / 4 : LIBBSC_CONTAINER_DEFAULT_CDCBLOCKSIZE;
+        params->writeIndex      = LIBBSC_CONTAINER_INDEX_HASHES;
+    }
+
+    return true;
+}
+
+/**
+* Reads a whole file into memory, used for the previous container of an incremental compression.
+* @return true if no error occurred, the error is reported otherwise.
+*/
+static bool bsc_cli_load(const char * fileName, unsigned char ** data, long long * n)
+{
+    FILE * file = fopen(fileName, "rb");
+    if (file == NULL)
+    {
+        fprintf(stderr, "Can't open input file: %s!\n", fileName);
+        return false;
+    }
+
+    fseek(file, 0, SEEK_END); *n = (long long)ftell(file); fseek(file, 0, SEEK_SET);
+
+    if (*n <= 0)
+    {
+        fprintf(stderr, "Input file is empty: %s!\n", fileName);
+        fclose(file); return false;
+    }
+
+    *data = (unsigned char *)malloc((size_t)*n);
+    if (*data == NULL)
+    {
+        fprintf(stderr, "Not enough memory!\n");
+        fclose(file); return false;
+    }
+
+    bool loaded = fread(*data, 1, (size_t)*n, file) == (size_t)*n; fclose(file);
+    if (!loaded)
+    {
+        fprintf(stderr, "I/O error on file: %s!\n", fileName);
+        free(*data); *data = NULL; return false;
+    }
+
+    return true;
+}
+
+static const char * bsc_cli_cpu_features(int cpuFeatures)
+{
+    if (cpuFeatures >= LIBBSC_CPU_FEATURE_AVX512BW) return "AVX-512";
+    if (cpuFeatures >= LIBBSC_CPU_FEATURE_AVX2)     return "AVX2";
+    if (cpuFeatures >= LIBBSC_CPU_FEATURE_SSE2)     return "SSE2";
+
+    return "generic";
+}
+
+static void bsc_cli_benchmark_lzp(const unsigned char * input, long long n, const bsc_container_params * params)
+{
+    // LZP alone on the first block and on one thread, once per code path the CPU supports
+    int blockSize = n < params->blockSize ? (int)n : params->blockSize;
+
+    unsigned char * output = (unsigned char *)malloc((size_t)blockSize);
+    if (output == NULL)
+    {
+        return;
+    }
+
+    // Levels above the CPU fall back to the detected path, a build without dispatch always reports its single path
+    static const int levels[] = { LIBBSC_CPU_FEATURE_SSE2, LIBBSC_CPU_FEATURE_AVX2, LIBBSC_CPU_FEATURE_AVX512BW };
+
+    int previous = -1, detected = bsc_lzp_set_cpu_features(-1);
+    for (int level = 0; level < (int)(sizeof(levels) / sizeof(levels[0])); ++level)
+    {
+        int path = bsc_lzp_set_cpu_features(levels[level]);
+        if (path == previous) continue;
+
+        double bestSeconds = 0; int result = LIBBSC_NO_ERROR;
+        for (int run = 0; run < 5 && result >= LIBBSC_NOT_COMPRESSIBLE; ++run)
+        {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            result = bsc_lzp_compress(input, output, blockSize, params->lzpHashSize, params->lzpMinLen, params->features & ~LIBBSC_FEATURE_MULTITHREADING, NULL);
+
+            double seconds = bsc_cli_seconds(start);
+            if (run == 0 || seconds < bestSeconds) bestSeconds = seconds;
+        }
+
+        if (result < LIBBSC_NOT_COMPRESSIBLE)
+        {
+            break;
+        }
+
+        fprintf(stdout, "  lzp %-7s%8.3f sec, %8.2f MB/s (first block, one thread%s)\n", bsc_cli_cpu_features(path), bestSeconds, bsc_cli_speed(blockSize, bestSeconds), path == detected ? ", in use" : "");
+
+        previous = path;
+    }
+
+    bsc_lzp_set_cpu_features(-1);
+
+    free(output);
+}
+
+static int bsc_cli_benchmark(const char * inputFile, const bsc_container_params * params)
+{
+    FILE * file = fopen(inputFile, "rb");
+    if (file == NULL)
+    {
+        fprintf(stderr, "Can't open input file: %s!\n", inputFile);
+        return 1;
+    }
+
+    fseek(file, 0, SEEK_END); long long n = (long long)ftell(file); fseek(file, 0, SEEK_SET);
+    if (n <= 0)
+    {
+        fprintf(stderr, "Input file is empty: %s!\n", inputFile);
+        fclose(file); return 1;
+    }
+
+    bsc_cli_buffer compressed = { NULL, 0, bsc_container_compress_bound(n, params) };
+
+    unsigned char * input   = (unsigned char *)malloc((size_t)n);
+    unsigned char * output  = (unsigned char *)malloc((size_t)n);
+    compressed.data         = (unsigned char *)malloc((size_t)compressed.capacity);
+
+    if (input == NULL || output == NULL || compressed.data == NULL)
+    {
+        fprintf(stderr, "Not enough memory!\n");
+        free(input); free(output); free(compressed.data); fclose(file); return 2;
+    }
+
+    bool loaded = fread(input, 1, (size_t)n, file) == (size_t)n; fclose(file);
+    if (!loaded)
+    {
+        fprintf(stderr, "I/O error on file: %s!\n", inputFile);
+        free(input); free(output); free(compressed.data); return 1;
+    }
+
+    bsc_container_stats     stats;
+    bsc_container_params    benchmarkParams = *params; benchmarkParams.stats = &stats;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    int result = bsc_container_compress(input, n, &benchmarkParams, bsc_cli_write_buffer, &compressed);
+    double compressSeconds = bsc_cli_seconds(start);
+
+    double decompressSeconds = 0;
+    if (result == LIBBSC_NO_ERROR)
+    {
+        start = std::chrono::steady_clock::now();
+        result = bsc_container_decompress_buffer(compressed.data, compressed.size, output, n, params->numThreads, params->features);
+        decompressSeconds = bsc_cli_seconds(start);
+    }
+
+    if (result == LIBBSC_NO_ERROR && memcmp(input, output, (size_t)n) != 0)
+    {
+        result = LIBBSC_DATA_CORRUPT;
+    }
+
+    if (result == LIBBSC_NO_ERROR)
+    {
+        fprintf(stdout, "%s: %lld => %lld bytes, %.3f bpc, %d blocks\n", inputFile, n, compressed.size, 8.0 * compressed.size / n, stats.nBlocks);
+        bsc_cli_print_stats(&stats);
+        fprintf(stdout, "  compress   %8.3f sec, %8.2f MB/s\n", compressSeconds, bsc_cli_speed(n, compressSeconds));
+        fprintf(stdout, "  decompress %8.3f sec, %8.2f MB/s\n", decompressSeconds, bsc_cli_speed(n, decompressSeconds));
+
+        if (params->lzpHashSize > 0 && params->lzpMinLen > 0)
+        {
+            bsc_cli_benchmark_lzp(input, n, params);
+        }
+
+        if (params->features & LIBBSC_FEATURE_LARGEPAGES)
+        {
+            fprintf(stdout, "  %lld bytes allocated on large pages, %lld bytes advised for transparent huge pages\n", bsc_get_large_page_bytes(), bsc_get_transparent_large_page_bytes());
+        }
+    }
+    else
+    {
+        fprintf(stderr, "Benchmark failed: %s (%d)!\n", bsc_cli_error(result), result);
+    }
+
+    free(input); free(output); free(compressed.data);
+
+    return result == LIBBSC_NO_ERROR ? 0 : 2;
+}
+
+int main(int argc, char * argv[])
+{
+    fprintf(stdout, "This is bsc, Block Sorting Compressor. Version %s (LibBSC Sharp native tool).\n\n", LIBBSC_VERSION_STRING);
+
+    if (argc < 3 || strlen(argv[1]) != 1 || strchr("edb", argv[1][0]) == NULL)
+    {
+        bsc_cli_usage();
+        return 0;
+    }
+
+    char command = argv[1][0];
+    if (command != 'b' && argc < 4)
+    {
+        bsc_cli_usage();
+        return 0;
+    }
+
+    bsc_container_params params;
+    bsc_container_default_params(&params);
+
+    const char * previousFile = NULL;
+    if (!bsc_cli_parse(argc, argv, command == 'b' ? 3 : 4, &params, &previousFile))
+    {
+        return 1;
+    }
+
+    unsigned char * previous = NULL;
+    if (previousFile != NULL && command != 'd')
+    {
+        if (!bsc_cli_load(previousFile, &previous, &params.previousSize))
+        {
+            return 1;
+        }
+
+        params.previous = previous;
+    }
+
+    if (bsc_init(params.features) != LIBBSC_NO_ERROR)
+    {
+        fprintf(stderr, "Library initialization failed!\n");
+        free(previous); return 2;
+    }
+
+    if (command == 'b')
+    {
+        int status = bsc_cli_benchmark(argv[2], &params);
+
+        free(previous); return status;
+    }
+
+    bsc_container_stats stats;
+    memset(&stats, 0, sizeof(stats)); params.stats = &stats;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    int result = command == 'e'
+        ? bsc_container_compress_file(argv[2], argv[3], &params)
+        : bsc_container_decompress_file(argv[2], argv[3], params.numThreads, params.features);
+
+    free(previous);
+
+    if (result != LIBBSC_NO_ERROR)
+    {
+        fprintf(stderr, "%s failed: %s (%d)!\n", command == 'e' ? "Compression" : "Decompression", bsc_cli_error(result), result);
+        return result == LIBBSC_CONTAINER_IO_ERROR ? 1 : 2;
+    }
+
+    fprintf(stdout, "%s %s into %s in %.3f seconds.\n", argv[2], command == 'e' ? "compressed" : "decompressed", argv[3], bsc_cli_seconds(start));
+    bsc_cli_print_stats(&stats);
+
+    return 0;
+}
+
+/*-----------------------------------------------------------*/
+/* End                                               bsc.cpp */
+/*-----------------------------------------------------------*/
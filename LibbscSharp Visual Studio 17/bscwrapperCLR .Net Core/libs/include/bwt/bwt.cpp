@@ -175,7 +175,7 @@ int bsc_bwt_gpu_encode(unsigned char * T, int n, unsigned char * num_indexes, in
 }
 
 
-int bsc_bwt_encode(unsigned char * T, int n, unsigned char * num_indexes, int * indexes, int features)
+int bsc_bwt_encode(unsigned char * T, int n, unsigned char * num_indexes, int * indexes, int features, bsc_context * context)
 {
     int index = bsc_bwt_gpu_encode(T, n, num_indexes, indexes, features);
     if (index >= 0)
@@ -183,8 +183,11 @@ int bsc_bwt_encode(unsigned char * T, int n, unsigned char * num_indexes, int *
         return index;
     }
 
-    if (int * RESTRICT A = (int *)bsc_malloc(n * sizeof(int)))
+    if (int * RESTRICT A = (int *)bsc_context_malloc(context, n * sizeof(int)))
     {
+        // libsais takes no context, its own buckets and thread states come from the current one
+        bsc_context * previous = bsc_context_set_current(context);
+
         if (num_indexes != NULL && indexes != NULL)
         {
             int I[256];
@@ -217,7 +220,8 @@ int bsc_bwt_encode(unsigned char * T, int n, unsigned char * num_indexes, int *
 #endif
         }
 
-        bsc_free(A);
+        bsc_context_set_current(previous);
+        bsc_context_free(context, A);
 
         switch (index)
         {
@@ -280,7 +284,7 @@ int bsc_bwt_gpu_decode(unsigned char * T, int n, int index, int features)
     return result;
 }
 
-int bsc_bwt_decode(unsigned char * T, int n, int index, unsigned char num_indexes, int * indexes, int features)
+int bsc_bwt_decode(unsigned char * T, int n, int index, unsigned char num_indexes, int * indexes, int features, bsc_context * context)
 {
     if ((T == NULL) || (n < 0) || (index <= 0) || (index > n))
     {
@@ -290,8 +294,10 @@ int bsc_bwt_decode(unsigned char * T, int n, int index, unsigned char num_indexe
     {
         return LIBBSC_NO_ERROR;
     }
-    if (int * P = (int *)bsc_malloc((n + 1) * sizeof(int)))
+    if (int * P = (int *)bsc_context_malloc(context, (n + 1) * sizeof(int)))
     {
+        bsc_context * previous = bsc_context_set_current(context);
+
         int mod = n / 8;
         {
             mod |= mod >> 1;  mod |= mod >> 2;
@@ -318,7 +324,8 @@ int bsc_bwt_decode(unsigned char * T, int n, int index, unsigned char num_indexe
 #endif
         }
 
-        bsc_free(P);
+        bsc_context_set_current(previous);
+        bsc_context_free(context, P);
 
         switch (index)
         {
@@ -33,6 +33,8 @@ See also the bsc and libbsc web site:
 #ifndef _LIBBSC_BWT_H
 #define _LIBBSC_BWT_H
 
+#include "../platform/platform.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -51,9 +53,10 @@ extern "C" {
     * @param num_indexes    - the length of secondary indexes array, can be NULL.
     * @param indexes        - the secondary indexes array, can be NULL.
     * @param features       - the set of additional features.
+    * @param context        - the context that owns the scratch buffers, can be NULL.
     * @return the primary index if no error occurred, error code otherwise.
     */
-    int bsc_bwt_encode(unsigned char * T, int n, unsigned char * num_indexes, int * indexes, int features);
+    int bsc_bwt_encode(unsigned char * T, int n, unsigned char * num_indexes, int * indexes, int features, bsc_context * context);
 
     /**
     * Reconstructs the original string from burrows wheeler transformed string.
@@ -63,9 +66,10 @@ extern "C" {
     * @param num_indexes    - the length of secondary indexes array, can be 0.
     * @param indexes        - the secondary indexes array, can be NULL.
     * @param features       - the set of additional features.
+    * @param context        - the context that owns the scratch buffers, can be NULL.
     * @return LIBBSC_NO_ERROR if no error occurred, error code otherwise.
     */
-    int bsc_bwt_decode(unsigned char * T, int n, int index, unsigned char num_indexes, int * indexes, int features);
+    int bsc_bwt_decode(unsigned char * T, int n, int index, unsigned char num_indexes, int * indexes, int features, bsc_context * context);
 
 #ifdef __cplusplus
 }
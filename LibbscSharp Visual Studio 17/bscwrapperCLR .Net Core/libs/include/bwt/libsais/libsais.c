@@ -25,6 +25,7 @@ Please see the file LICENSE for full copyright information.
 
 Changes made to the original file:
   - July 14, 2021 Switched to internal bsc malloc / free functions.
+  - Allocations go through the bsc context current on the calling thread.
 
 --*/
 
@@ -193,7 +194,7 @@ static void * libsais_align_up(const void * address, size_t alignment)
 
 static void * libsais_alloc_aligned(size_t size, size_t alignment)
 {
-    void * address = bsc_malloc(size + sizeof(short) + alignment - 1);
+    void * address = bsc_current_malloc(size + sizeof(short) + alignment - 1);
     if (address != NULL)
     {
         void * aligned_address = libsais_align_up((void *)((ptrdiff_t)address + (ptrdiff_t)(sizeof(short))), alignment);
@@ -209,7 +210,7 @@ static void libsais_free_aligned(void * aligned_address)
 {
     if (aligned_address != NULL)
     {
-        bsc_free((void *)((ptrdiff_t)aligned_address - ((short *)aligned_address)[-1]));
+        bsc_current_free((void *)((ptrdiff_t)aligned_address - ((short *)aligned_address)[-1]));
     }
 }
 
@@ -49,8 +49,17 @@ int bsc_coder_init(int features)
     return result;
 }
 
-static INLINE int bsc_coder_num_blocks(int n)
+#define LIBBSC_CODER_MIN_SUBBLOCK_SIZE  (256 * 1024)
+
+static INLINE int bsc_coder_num_blocks(int n, int features)
 {
+    // An explicit count is kept to sub-blocks large enough for the adaptive models to settle
+    if (int maxBlocks = LIBBSC_FEATURE_SUBBLOCKS_COUNT(features))
+    {
+        int nBlocks = n / LIBBSC_CODER_MIN_SUBBLOCK_SIZE;
+        return nBlocks < 1 ? 1 : (nBlocks < maxBlocks ? nBlocks : maxBlocks);
+    }
+
     if (n <       256 * 1024)   return 1;
     if (n <  4 * 1024 * 1024)   return 2;
     if (n < 16 * 1024 * 1024)   return 4;
@@ -58,11 +67,11 @@ static INLINE int bsc_coder_num_blocks(int n)
     return 8;
 }
 
-int bsc_coder_encode_block(const unsigned char * input, unsigned char * output, int inputSize, int outputSize, int coder)
+int bsc_coder_encode_block(const unsigned char * input, unsigned char * output, int inputSize, int outputSize, int coder, bsc_context * context)
 {
-    if (coder == LIBBSC_CODER_QLFC_STATIC)   return bsc_qlfc_static_encode_block  (input, output, inputSize, outputSize);
-    if (coder == LIBBSC_CODER_QLFC_ADAPTIVE) return bsc_qlfc_adaptive_encode_block(input, output, inputSize, outputSize);
-    if (coder == LIBBSC_CODER_QLFC_FAST)     return bsc_qlfc_fast_encode_block    (input, output, inputSize, outputSize);
+    if (coder == LIBBSC_CODER_QLFC_STATIC)   return bsc_qlfc_static_encode_block  (input, output, inputSize, outputSize, context);
+    if (coder == LIBBSC_CODER_QLFC_ADAPTIVE) return bsc_qlfc_adaptive_encode_block(input, output, inputSize, outputSize, context);
+    if (coder == LIBBSC_CODER_QLFC_FAST)     return bsc_qlfc_fast_encode_block    (input, output, inputSize, outputSize, context);
 
     return LIBBSC_BAD_PARAMETER;
 }
@@ -108,11 +117,11 @@ void bsc_coder_split_blocks(const unsigned char * input, int n, int nBlocks, int
     }
 }
 
-int bsc_coder_compress_serial(const unsigned char * input, unsigned char * output, int n, int coder)
+int bsc_coder_compress_serial(const unsigned char * input, unsigned char * output, int n, int coder, int nBlocks, bsc_context * context)
 {
-    if (bsc_coder_num_blocks(n) == 1)
+    if (nBlocks == 1)
     {
-        int result = bsc_coder_encode_block(input, output + 1, n, n - 1, coder);
+        int result = bsc_coder_encode_block(input, output + 1, n, n - 1, coder, context);
         if (result >= LIBBSC_NO_ERROR) result = (output[0] = 1, result + 1);
 
         return result;
@@ -121,7 +130,6 @@ int bsc_coder_compress_serial(const unsigned char * input, unsigned char * outpu
     int compressedStart[ALPHABET_SIZE];
     int compressedSize[ALPHABET_SIZE];
 
-    int nBlocks   = bsc_coder_num_blocks(n);
     int outputPtr = 1 + 8 * nBlocks;
 
     bsc_coder_split_blocks(input, n, nBlocks, compressedStart, compressedSize);
@@ -133,7 +141,7 @@ int bsc_coder_compress_serial(const unsigned char * input, unsigned char * outpu
         int inputSize   = compressedSize[blockId];
         int outputSize  = inputSize; if (outputSize > n - outputPtr) outputSize = n - outputPtr;
 
-        int result = bsc_coder_encode_block(input + inputStart, output + outputPtr, inputSize, outputSize, coder);
+        int result = bsc_coder_encode_block(input + inputStart, output + outputPtr, inputSize, outputSize, coder, context);
         if (result < LIBBSC_NO_ERROR)
         {
             if (outputPtr + inputSize >= n) return LIBBSC_NOT_COMPRESSIBLE;
@@ -151,15 +159,14 @@ int bsc_coder_compress_serial(const unsigned char * input, unsigned char * outpu
 
 #ifdef LIBBSC_OPENMP
 
-int bsc_coder_compress_parallel(const unsigned char * input, unsigned char * output, int n, int coder)
+int bsc_coder_compress_parallel(const unsigned char * input, unsigned char * output, int n, int coder, int nBlocks, bsc_context * context)
 {
-    if (unsigned char * buffer = (unsigned char *)bsc_malloc(n * sizeof(unsigned char)))
+    if (unsigned char * buffer = (unsigned char *)bsc_context_malloc(context, n * sizeof(unsigned char)))
     {
         int compressionResult[ALPHABET_SIZE];
         int compressedStart[ALPHABET_SIZE];
         int compressedSize[ALPHABET_SIZE];
 
-        int nBlocks = bsc_coder_num_blocks(n);
         int result  = LIBBSC_NO_ERROR;
 
         int numThreads = omp_get_max_threads();
@@ -170,7 +177,7 @@ int bsc_coder_compress_parallel(const unsigned char * input, unsigned char * out
         {
             if (omp_get_num_threads() == 1)
             {
-                result = bsc_coder_compress_serial(input, output, n, coder);
+                result = bsc_coder_compress_serial(input, output, n, coder, nBlocks, context);
             }
             else
             {
@@ -185,7 +192,7 @@ int bsc_coder_compress_parallel(const unsigned char * input, unsigned char * out
                     int blockStart   = compressedStart[blockId];
                     int blockSize    = compressedSize[blockId];
 
-                    compressionResult[blockId] = bsc_coder_encode_block(input + blockStart, buffer + blockStart, blockSize, blockSize, coder);
+                    compressionResult[blockId] = bsc_coder_encode_block(input + blockStart, buffer + blockStart, blockSize, blockSize, coder, context);
                     if (compressionResult[blockId] < LIBBSC_NO_ERROR) compressionResult[blockId] = blockSize;
 
                     memcpy(output + 1 + 8 * blockId + 0, &blockSize, sizeof(int));
@@ -227,7 +234,7 @@ int bsc_coder_compress_parallel(const unsigned char * input, unsigned char * out
             }
         }
 
-        bsc_free(buffer);
+        bsc_context_free(context, buffer);
 
         return result;
     }
@@ -236,36 +243,38 @@ int bsc_coder_compress_parallel(const unsigned char * input, unsigned char * out
 
 #endif
 
-int bsc_coder_compress(const unsigned char * input, unsigned char * output, int n, int coder, int features)
+int bsc_coder_compress(const unsigned char * input, unsigned char * output, int n, int coder, int features, bsc_context * context)
 {
     if ((coder != LIBBSC_CODER_QLFC_STATIC) && (coder != LIBBSC_CODER_QLFC_ADAPTIVE) && (coder != LIBBSC_CODER_QLFC_FAST))
     {
         return LIBBSC_BAD_PARAMETER;
     }
 
+    int nBlocks = bsc_coder_num_blocks(n, features);
+
 #ifdef LIBBSC_OPENMP
 
-    if ((bsc_coder_num_blocks(n) != 1) && (features & LIBBSC_FEATURE_MULTITHREADING))
+    if ((nBlocks != 1) && (features & LIBBSC_FEATURE_MULTITHREADING))
     {
-        return bsc_coder_compress_parallel(input, output, n, coder);
+        return bsc_coder_compress_parallel(input, output, n, coder, nBlocks, context);
     }
 
 #endif
 
-    return bsc_coder_compress_serial(input, output, n, coder);
+    return bsc_coder_compress_serial(input, output, n, coder, nBlocks, context);
 }
 
 
-int bsc_coder_decode_block(const unsigned char * input, unsigned char * output, int coder)
+int bsc_coder_decode_block(const unsigned char * input, unsigned char * output, int coder, bsc_context * context)
 {
-    if (coder == LIBBSC_CODER_QLFC_STATIC)   return bsc_qlfc_static_decode_block  (input, output);
-    if (coder == LIBBSC_CODER_QLFC_ADAPTIVE) return bsc_qlfc_adaptive_decode_block(input, output);
-    if (coder == LIBBSC_CODER_QLFC_FAST)     return bsc_qlfc_fast_decode_block    (input, output);
+    if (coder == LIBBSC_CODER_QLFC_STATIC)   return bsc_qlfc_static_decode_block  (input, output, context);
+    if (coder == LIBBSC_CODER_QLFC_ADAPTIVE) return bsc_qlfc_adaptive_decode_block(input, output, context);
+    if (coder == LIBBSC_CODER_QLFC_FAST)     return bsc_qlfc_fast_decode_block    (input, output, context);
 
     return LIBBSC_BAD_PARAMETER;
 }
 
-int bsc_coder_decompress(const unsigned char * input, unsigned char * output, int coder, int features)
+int bsc_coder_decompress(const unsigned char * input, unsigned char * output, int coder, int features, bsc_context * context)
 {
     if ((coder != LIBBSC_CODER_QLFC_STATIC) && (coder != LIBBSC_CODER_QLFC_ADAPTIVE) && (coder != LIBBSC_CODER_QLFC_FAST))
     {
@@ -275,7 +284,7 @@ int bsc_coder_decompress(const unsigned char * input, unsigned char * output, in
     int nBlocks = input[0];
     if (nBlocks == 1)
     {
-        return bsc_coder_decode_block(input + 1, output, coder);
+        return bsc_coder_decode_block(input + 1, output, coder, context);
     }
 
     int decompressionResult[ALPHABET_SIZE];
@@ -305,7 +314,7 @@ int bsc_coder_decompress(const unsigned char * input, unsigned char * output, in
 
             if (inputSize != outputSize)
             {
-                decompressionResult[blockId] = bsc_coder_decode_block(input + inputPtr, output + outputPtr, coder);
+                decompressionResult[blockId] = bsc_coder_decode_block(input + inputPtr, output + outputPtr, coder, context);
             }
             else
             {
@@ -338,7 +347,7 @@ int bsc_coder_decompress(const unsigned char * input, unsigned char * output, in
 
             if (inputSize != outputSize)
             {
-                decompressionResult[blockId] = bsc_coder_decode_block(input + inputPtr, output + outputPtr, coder);
+                decompressionResult[blockId] = bsc_coder_decode_block(input + inputPtr, output + outputPtr, coder, context);
             }
             else
             {
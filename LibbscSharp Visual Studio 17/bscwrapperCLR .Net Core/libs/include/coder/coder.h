@@ -33,6 +33,8 @@ See also the bsc and libbsc web site:
 #ifndef _LIBBSC_CODER_H
 #define _LIBBSC_CODER_H
 
+#include "../platform/platform.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -51,9 +53,10 @@ extern "C" {
     * @param n          - the length of the input memory block.
     * @param coder      - the entropy coding algorithm.
     * @param features   - the set of additional features.
+    * @param context    - the context that owns the scratch buffers, can be NULL.
     * @return the length of compressed memory block if no error occurred, error code otherwise.
     */
-    int bsc_coder_compress(const unsigned char * input, unsigned char * output, int n, int coder, int features);
+    int bsc_coder_compress(const unsigned char * input, unsigned char * output, int n, int coder, int features, bsc_context * context);
 
     /**
     * Decompress a memory block using Quantized Local Frequency Coding.
@@ -61,9 +64,10 @@ extern "C" {
     * @param output     - the output memory block.
     * @param coder      - the entropy coding algorithm.
     * @param features   - the set of additional features.
+    * @param context    - the context that owns the scratch buffers, can be NULL.
     * @return the length of decompressed memory block if no error occurred, error code otherwise.
     */
-    int bsc_coder_decompress(const unsigned char * input, unsigned char * output, int coder, int features);
+    int bsc_coder_decompress(const unsigned char * input, unsigned char * output, int coder, int features, bsc_context * context);
 
 #ifdef __cplusplus
 }
@@ -2215,90 +2215,90 @@ int bsc_qlfc_init(int features)
     return bsc_qlfc_init_static_model();
 }
 
-int bsc_qlfc_static_encode_block(const unsigned char * input, unsigned char * output, int inputSize, int outputSize)
+int bsc_qlfc_static_encode_block(const unsigned char * input, unsigned char * output, int inputSize, int outputSize, bsc_context * context)
 {
-    if (QlfcStatisticalModel1 * model = (QlfcStatisticalModel1 *)bsc_malloc(sizeof(QlfcStatisticalModel1)))
+    if (QlfcStatisticalModel1 * model = (QlfcStatisticalModel1 *)bsc_context_malloc(context, sizeof(QlfcStatisticalModel1)))
     {
-        if (unsigned char * buffer = (unsigned char *)bsc_malloc(inputSize * sizeof(unsigned char)))
+        if (unsigned char * buffer = (unsigned char *)bsc_context_malloc(context, inputSize * sizeof(unsigned char)))
         {
             int result = bsc_qlfc_static_encode(input, output, buffer, inputSize, outputSize, model);
 
-            bsc_free(buffer); bsc_free(model);
+            bsc_context_free(context, buffer); bsc_context_free(context, model);
 
             return result;
         };
-        bsc_free(model);
+        bsc_context_free(context, model);
     };
     return LIBBSC_NOT_ENOUGH_MEMORY;
 }
 
-int bsc_qlfc_adaptive_encode_block(const unsigned char * input, unsigned char * output, int inputSize, int outputSize)
+int bsc_qlfc_adaptive_encode_block(const unsigned char * input, unsigned char * output, int inputSize, int outputSize, bsc_context * context)
 {
-    if (QlfcStatisticalModel1 * model = (QlfcStatisticalModel1 *)bsc_malloc(sizeof(QlfcStatisticalModel1)))
+    if (QlfcStatisticalModel1 * model = (QlfcStatisticalModel1 *)bsc_context_malloc(context, sizeof(QlfcStatisticalModel1)))
     {
-        if (unsigned char * buffer = (unsigned char *)bsc_malloc(inputSize * sizeof(unsigned char)))
+        if (unsigned char * buffer = (unsigned char *)bsc_context_malloc(context, inputSize * sizeof(unsigned char)))
         {
             int result = bsc_qlfc_adaptive_encode(input, output, buffer, inputSize, outputSize, model);
 
-            bsc_free(buffer); bsc_free(model);
+            bsc_context_free(context, buffer); bsc_context_free(context, model);
 
             return result;
         };
-        bsc_free(model);
+        bsc_context_free(context, model);
     };
     return LIBBSC_NOT_ENOUGH_MEMORY;
 }
 
-int bsc_qlfc_fast_encode_block(const unsigned char * input, unsigned char * output, int inputSize, int outputSize)
+int bsc_qlfc_fast_encode_block(const unsigned char * input, unsigned char * output, int inputSize, int outputSize, bsc_context * context)
 {
-    if (QlfcStatisticalModel2 * model = (QlfcStatisticalModel2 *)bsc_malloc(sizeof(QlfcStatisticalModel2)))
+    if (QlfcStatisticalModel2 * model = (QlfcStatisticalModel2 *)bsc_context_malloc(context, sizeof(QlfcStatisticalModel2)))
     {
-        if (unsigned char * buffer = (unsigned char *)bsc_malloc(inputSize * sizeof(unsigned char)))
+        if (unsigned char * buffer = (unsigned char *)bsc_context_malloc(context, inputSize * sizeof(unsigned char)))
         {
             int result = bsc_qlfc_fast_encode(input, output, buffer, inputSize, outputSize, model);
 
-            bsc_free(buffer); bsc_free(model);
+            bsc_context_free(context, buffer); bsc_context_free(context, model);
 
             return result;
         };
-        bsc_free(model);
+        bsc_context_free(context, model);
     };
     return LIBBSC_NOT_ENOUGH_MEMORY;
 }
 
-int bsc_qlfc_static_decode_block(const unsigned char * input, unsigned char * output)
+int bsc_qlfc_static_decode_block(const unsigned char * input, unsigned char * output, bsc_context * context)
 {
-    if (QlfcStatisticalModel1 * model = (QlfcStatisticalModel1 *)bsc_malloc(sizeof(QlfcStatisticalModel1)))
+    if (QlfcStatisticalModel1 * model = (QlfcStatisticalModel1 *)bsc_context_malloc(context, sizeof(QlfcStatisticalModel1)))
     {
         int result = bsc_qlfc_static_decode(input, output, model);
 
-        bsc_free(model);
+        bsc_context_free(context, model);
 
         return result;
     };
     return LIBBSC_NOT_ENOUGH_MEMORY;
 }
 
-int bsc_qlfc_adaptive_decode_block(const unsigned char * input, unsigned char * output)
+int bsc_qlfc_adaptive_decode_block(const unsigned char * input, unsigned char * output, bsc_context * context)
 {
-    if (QlfcStatisticalModel1 * model = (QlfcStatisticalModel1 *)bsc_malloc(sizeof(QlfcStatisticalModel1)))
+    if (QlfcStatisticalModel1 * model = (QlfcStatisticalModel1 *)bsc_context_malloc(context, sizeof(QlfcStatisticalModel1)))
     {
         int result = bsc_qlfc_adaptive_decode(input, output, model);
 
-        bsc_free(model);
+        bsc_context_free(context, model);
 
         return result;
     };
     return LIBBSC_NOT_ENOUGH_MEMORY;
 }
 
-int bsc_qlfc_fast_decode_block(const unsigned char * input, unsigned char * output)
+int bsc_qlfc_fast_decode_block(const unsigned char * input, unsigned char * output, bsc_context * context)
 {
-    if (QlfcStatisticalModel2 * model = (QlfcStatisticalModel2 *)bsc_malloc(sizeof(QlfcStatisticalModel2)))
+    if (QlfcStatisticalModel2 * model = (QlfcStatisticalModel2 *)bsc_context_malloc(context, sizeof(QlfcStatisticalModel2)))
     {
         int result = bsc_qlfc_fast_decode(input, output, model);
 
-        bsc_free(model);
+        bsc_context_free(context, model);
 
         return result;
     };
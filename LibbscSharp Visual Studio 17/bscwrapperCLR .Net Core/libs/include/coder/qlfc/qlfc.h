@@ -33,6 +33,8 @@ See also the bsc and libbsc web site:
 #ifndef _LIBBSC_QLFC_H
 #define _LIBBSC_QLFC_H
 
+#include "../../platform/platform.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -50,9 +52,10 @@ extern "C" {
     * @param output     - the output memory block of n bytes.
     * @param inputSize  - the length of the input memory block.
     * @param outputSize - the length of the output memory block.
+    * @param context    - the context that owns the scratch buffers, can be NULL.
     * @return the length of compressed memory block if no error occurred, error code otherwise.
     */
-    int bsc_qlfc_static_encode_block(const unsigned char * input, unsigned char * output, int inputSize, int outputSize);
+    int bsc_qlfc_static_encode_block(const unsigned char * input, unsigned char * output, int inputSize, int outputSize, bsc_context * context);
 
     /**
     * Decompress a memory block using Quantized Local Frequency Coding algorithm.
@@ -60,9 +63,10 @@ extern "C" {
     * @param output     - the output memory block of n bytes.
     * @param inputSize  - the length of the input memory block.
     * @param outputSize - the length of the output memory block.
+    * @param context    - the context that owns the scratch buffers, can be NULL.
     * @return the length of decompressed memory block if no error occurred, error code otherwise.
     */
-    int bsc_qlfc_adaptive_encode_block(const unsigned char * input, unsigned char * output, int inputSize, int outputSize);
+    int bsc_qlfc_adaptive_encode_block(const unsigned char * input, unsigned char * output, int inputSize, int outputSize, bsc_context * context);
 
     /**
     * Decompress a memory block using Quantized Local Frequency Coding algorithm.
@@ -70,33 +74,37 @@ extern "C" {
     * @param output     - the output memory block of n bytes.
     * @param inputSize  - the length of the input memory block.
     * @param outputSize - the length of the output memory block.
+    * @param context    - the context that owns the scratch buffers, can be NULL.
     * @return the length of decompressed memory block if no error occurred, error code otherwise.
     */
-    int bsc_qlfc_fast_encode_block(const unsigned char * input, unsigned char * output, int inputSize, int outputSize);
+    int bsc_qlfc_fast_encode_block(const unsigned char * input, unsigned char * output, int inputSize, int outputSize, bsc_context * context);
 
     /**
     * Compress a memory block using Quantized Local Frequency Coding algorithm.
     * @param input      - the input memory block of n bytes.
     * @param output     - the output memory block of n bytes.
+    * @param context    - the context that owns the scratch buffers, can be NULL.
     * @return the length of compressed memory block if no error occurred, error code otherwise.
     */
-    int bsc_qlfc_static_decode_block(const unsigned char * input, unsigned char * output);
+    int bsc_qlfc_static_decode_block(const unsigned char * input, unsigned char * output, bsc_context * context);
 
     /**
     * Decompress a memory block using Quantized Local Frequency Coding algorithm.
     * @param input      - the input memory block of n bytes.
     * @param output     - the output memory block of n bytes.
+    * @param context    - the context that owns the scratch buffers, can be NULL.
     * @return the length of decompressed memory block if no error occurred, error code otherwise.
     */
-    int bsc_qlfc_adaptive_decode_block(const unsigned char * input, unsigned char * output);
+    int bsc_qlfc_adaptive_decode_block(const unsigned char * input, unsigned char * output, bsc_context * context);
 
     /**
     * Decompress a memory block using Quantized Local Frequency Coding algorithm.
     * @param input      - the input memory block of n bytes.
     * @param output     - the output memory block of n bytes.
+    * @param context    - the context that owns the scratch buffers, can be NULL.
     * @return the length of decompressed memory block if no error occurred, error code otherwise.
     */
-    int bsc_qlfc_fast_decode_block(const unsigned char * input, unsigned char * output);
+    int bsc_qlfc_fast_decode_block(const unsigned char * input, unsigned char * output, bsc_context * context);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,222 @@
+/*-----------------------------------------------------------*/
+/* Block Sorting, Lossless Data Compression Library.         */
+/* Plain C ABI over the bsc1 container (bscx shared library) */
+/*-----------------------------------------------------------*/
+
+/*--
+
+This file is a part of LibBSC Sharp, a .NET port of bsc and libbsc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+--*/
+
+#include <limits.h>
+#include <string.h>
+
+#include <mutex>
+
+#include "bscx.h"
+#include "container.h"
+
+#include "../libbsc.h"
+
+typedef struct bscx_output
+{
+    unsigned char * data;
+    long long       capacity;
+    long long       size;
+} bscx_output;
+
+static int bscx_write_output(void * context, const unsigned char * data, int size)
+{
+    bscx_output * output = (bscx_output *)context;
+    if (size > output->capacity - output->size)
+    {
+        return LIBBSC_UNEXPECTED_EOB;
+    }
+
+    memcpy(output->data + output->size, data, size);
+    output->size += size;
+
+    return LIBBSC_NO_ERROR;
+}
+
+static std::once_flag   bscx_init_flag;
+static int              bscx_init_result = LIBBSC_NO_ERROR;
+
+static void bscx_init_core(int features)
+{
+    bscx_init_result = bsc_init(features);
+}
+
+/**
+* Initializes the core once for the whole process, concurrent callers wait for the first one.
+* The features of the first call decide the process-wide ones (large pages), later calls only read its result.
+*/
+static int bscx_init(int features)
+{
+    std::call_once(bscx_init_flag, bscx_init_core, features);
+
+    return bscx_init_result;
+}
+
+static void bscx_container_params(const bscx_params * params, bsc_container_params * containerParams)
+{
+    bsc_container_default_params(containerParams);
+    if (params != NULL)
+    {
+        containerParams->blockSize       = params->blockSize;
+        containerParams->numThreads      = params->numThreads;
+        containerParams->lzpHashSize     = params->lzpHashSize;
+        containerParams->lzpMinLen       = params->lzpMinLen;
+        containerParams->blockSorter     = params->blockSorter;
+        containerParams->coder           = params->coder;
+        containerParams->features        = params->features;
+        containerParams->writeIndex      = params->writeIndex;
+        containerParams->sortingContexts = params->sortingContexts;
+        containerParams->recordSize      = params->recordSize;
+        containerParams->minBlockSize    = params->minBlockSize;
+        containerParams->storeThreshold  = params->storeThreshold;
+        containerParams->deduplicate     = params->deduplicate;
+        containerParams->cdcBlockSize    = params->cdcBlockSize;
+        containerParams->longRange       = params->longRange;
+    }
+}
+
+void bscx_default_params(bscx_params * params)
+{
+    if (params == NULL)
+    {
+        return;
+    }
+
+    bsc_container_params containerParams;
+    bsc_container_default_params(&containerParams);
+
+    params->blockSize       = containerParams.blockSize;
+    params->numThreads      = containerParams.numThreads;
+    params->lzpHashSize     = containerParams.lzpHashSize;
+    params->lzpMinLen       = containerParams.lzpMinLen;
+    params->blockSorter     = containerParams.blockSorter;
+    params->coder           = containerParams.coder;
+    params->features        = containerParams.features;
+    params->writeIndex      = containerParams.writeIndex;
+    params->sortingContexts = containerParams.sortingContexts;
+    params->recordSize      = containerParams.recordSize;
+    params->minBlockSize    = containerParams.minBlockSize;
+    params->storeThreshold  = containerParams.storeThreshold;
+    params->deduplicate     = containerParams.deduplicate;
+    params->cdcBlockSize    = containerParams.cdcBlockSize;
+    params->longRange       = containerParams.longRange;
+}
+
+int64_t bscx_compress_bound(size_t inputSize, const bscx_params * params)
+{
+    if ((unsigned long long)inputSize > (unsigned long long)LLONG_MAX / 2)
+    {
+        return LIBBSC_BAD_PARAMETER;
+    }
+
+    bsc_container_params containerParams;
+    bscx_container_params(params, &containerParams);
+
+    return bsc_container_compress_bound((long long)inputSize, &containerParams);
+}
+
+int64_t bscx_compress_container(const uint8_t * input, size_t inputSize, uint8_t * output, size_t outputCapacity, const bscx_params * params)
+{
+    return bscx_compress_incremental(input, inputSize, NULL, 0, output, outputCapacity, params);
+}
+
+int64_t bscx_compress_incremental(const uint8_t * input, size_t inputSize, const uint8_t * previous, size_t previousSize, uint8_t * output, size_t outputCapacity, const bscx_params * params)
+{
+    if (input == NULL || output == NULL || inputSize == 0 || (unsigned long long)inputSize > (unsigned long long)LLONG_MAX / 2)
+    {
+        return LIBBSC_BAD_PARAMETER;
+    }
+
+    if ((previous == NULL && previousSize > 0) || (unsigned long long)previousSize > (unsigned long long)LLONG_MAX)
+    {
+        return LIBBSC_BAD_PARAMETER;
+    }
+
+    bsc_container_params containerParams;
+    bscx_container_params(params, &containerParams);
+
+    // An empty previous container is a full compression, bindings pass empty spans that way
+    containerParams.previous        = previousSize > 0 ? previous : NULL;
+    containerParams.previousSize    = (long long)previousSize;
+
+    int result = bscx_init(containerParams.features);
+    if (result != LIBBSC_NO_ERROR)
+    {
+        return result;
+    }
+
+    // Blocks are written in order, so the output is filled front to back without intermediate buffering
+    bscx_output container = { output, outputCapacity > (size_t)LLONG_MAX ? LLONG_MAX : (long long)outputCapacity, 0 };
+
+    result = bsc_container_compress(input, (long long)inputSize, &containerParams, bscx_write_output, &container);
+
+    return result == LIBBSC_NO_ERROR ? container.size : result;
+}
+
+int64_t bscx_decompressed_size(const uint8_t * input, size_t inputSize)
+{
+    if (input == NULL || (unsigned long long)inputSize > (unsigned long long)LLONG_MAX)
+    {
+        return LIBBSC_BAD_PARAMETER;
+    }
+
+    long long dataSize = 0;
+
+    int result = bsc_container_data_size(input, (long long)inputSize, LIBBSC_DEFAULT_FEATURES, &dataSize);
+
+    return result == LIBBSC_NO_ERROR ? dataSize : result;
+}
+
+int64_t bscx_decompress_container(const uint8_t * input, size_t inputSize, uint8_t * output, size_t outputCapacity, int32_t numThreads)
+{
+    if (input == NULL || output == NULL || (unsigned long long)inputSize > (unsigned long long)LLONG_MAX)
+    {
+        return LIBBSC_BAD_PARAMETER;
+    }
+
+    int result = bscx_init(LIBBSC_DEFAULT_FEATURES);
+    if (result != LIBBSC_NO_ERROR)
+    {
+        return result;
+    }
+
+    long long dataSize = 0;
+
+    result = bsc_container_data_size(input, (long long)inputSize, LIBBSC_DEFAULT_FEATURES, &dataSize);
+    if (result != LIBBSC_NO_ERROR)
+    {
+        return result;
+    }
+
+    if ((unsigned long long)dataSize > (unsigned long long)outputCapacity)
+    {
+        return LIBBSC_UNEXPECTED_EOB;
+    }
+
+    result = bsc_container_decompress_buffer(input, (long long)inputSize, output, dataSize, numThreads, LIBBSC_DEFAULT_FEATURES);
+
+    return result == LIBBSC_NO_ERROR ? dataSize : result;
+}
+
+/*-----------------------------------------------------------*/
+/* End                                              bscx.cpp */
+/*-----------------------------------------------------------*/
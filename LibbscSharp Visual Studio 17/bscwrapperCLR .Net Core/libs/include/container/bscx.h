@@ -0,0 +1,164 @@
+/*-----------------------------------------------------------*/
+/* Block Sorting, Lossless Data Compression Library.         */
+/* Plain C ABI over the bsc1 container (bscx shared library) */
+/*-----------------------------------------------------------*/
+
+/*--
+
+This file is a part of LibBSC Sharp, a .NET port of bsc and libbsc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+This header only depends on the C standard headers, so it can be used from
+C, from P/Invoke or from any FFI without the libbsc headers. Buffers are
+owned by the caller: the functions compress into and decompress to the
+memory they are given, nothing is allocated on the caller's behalf.
+
+Sizes are returned as int64_t, a negative value is one of the error codes
+below, which are the libbsc ones.
+
+Every function can be called from any thread, the core is initialized once
+by the first call.
+
+--*/
+
+#ifndef _LIBBSC_BSCX_H
+#define _LIBBSC_BSCX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define BSCX_NO_ERROR               0
+#define BSCX_BAD_PARAMETER         -1
+#define BSCX_NOT_ENOUGH_MEMORY     -2
+#define BSCX_NOT_SUPPORTED         -4
+#define BSCX_UNEXPECTED_EOB        -5
+#define BSCX_DATA_CORRUPT          -6
+
+#define BSCX_INDEX_HASHES           2
+#define BSCX_LZP_AUTODETECT        -1
+
+#ifndef BSCX_API
+  #ifdef _WIN32
+    #ifdef BSCX_EXPORTS
+      #define BSCX_API __declspec(dllexport)
+    #else
+      #define BSCX_API __declspec(dllimport)
+    #endif
+  #elif defined(__GNUC__)
+    #define BSCX_API __attribute__((visibility("default")))
+  #else
+    #define BSCX_API
+  #endif
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    /**
+    * Parameters of the container compressor, initialize them with @ref bscx_default_params.
+    * The layout is fixed, every field is a 32-bit integer.
+    */
+    typedef struct bscx_params
+    {
+        int32_t blockSize;       /* the maximum size of a block in bytes.                                  */
+        int32_t numThreads;      /* the number of blocks compressed concurrently, 0 for all cores.         */
+        int32_t lzpHashSize;     /* the hash table size if LZP enabled, 0 otherwise, BSCX_LZP_AUTODETECT
+                                    to size it per block.                                                  */
+        int32_t lzpMinLen;       /* the minimum match length if LZP enabled, 0 otherwise, BSCX_LZP_AUTODETECT
+                                    to pick it per block, LZP is then disabled where it does not pay.      */
+        int32_t blockSorter;     /* the block sorting algorithm, 1 for BWT, 3..8 for ST.                   */
+        int32_t coder;           /* the entropy coding algorithm, 1 static, 2 adaptive, 3 fast QLFC.       */
+        int32_t features;        /* the set of additional libbsc features.                                 */
+        int32_t writeIndex;      /* non-zero to append the index footer, BSCX_INDEX_HASHES with hashes.    */
+        int32_t sortingContexts; /* 1 following, 2 preceding, 3 to detect the order of contexts per block. */
+        int32_t recordSize;      /* the record size for reordering, 1 to disable, 0 to detect per block.   */
+        int32_t minBlockSize;    /* the minimum size of content-aware blocks, 0 for fixed-size blocks.     */
+        int32_t storeThreshold;  /* store blocks estimated above this many 1/100 bits per byte, 0 never.   */
+        int32_t deduplicate;     /* non-zero to write repeated blocks as references, in a bsc2 container.  */
+        int32_t cdcBlockSize;    /* the average size of content-defined blocks, 0 for fixed-size blocks.   */
+        int32_t longRange;       /* non-zero to write repeats of 32KB or more anywhere in the input as
+                                    references, in a bsc3 container, supersedes deduplicate.               */
+    } bscx_params;
+
+    /**
+    * Fills the parameters with the defaults of the bsc command-line tool.
+    * @param params     - the parameters to initialize.
+    */
+    BSCX_API void bscx_default_params(bscx_params * params);
+
+    /**
+    * Computes the output capacity that is always enough for @ref bscx_compress_container.
+    * @param inputSize  - the length of the input.
+    * @param params     - the compression parameters, NULL for the defaults.
+    * @return the capacity in bytes if no error occurred, error code otherwise.
+    */
+    BSCX_API int64_t bscx_compress_bound(size_t inputSize, const bscx_params * params);
+
+    /**
+    * Compresses a memory buffer into a bsc1 container written straight into the caller's memory.
+    * @param input          - the input memory block of inputSize bytes.
+    * @param inputSize      - the length of the input.
+    * @param output         - the output memory block of outputCapacity bytes.
+    * @param outputCapacity - the capacity of the output, see @ref bscx_compress_bound.
+    * @param params         - the compression parameters, NULL for the defaults.
+    * @return the length of the container if no error occurred, error code otherwise.
+    *         BSCX_UNEXPECTED_EOB if the container does not fit in the output.
+    */
+    BSCX_API int64_t bscx_compress_container(const uint8_t * input, size_t inputSize, uint8_t * output, size_t outputCapacity, const bscx_params * params);
+
+    /**
+    * Compresses a new version of an input, copying the blocks found by hash in the container of a previous version
+    * instead of compressing them again. The output always gets the block hashes, size it with @ref bscx_compress_bound
+    * and writeIndex set to BSCX_INDEX_HASHES. Use cdcBlockSize for both versions so an edit only changes a few blocks.
+    * @param input          - the input memory block of inputSize bytes.
+    * @param inputSize      - the length of the input.
+    * @param previous       - the previous container of previousSize bytes, written with BSCX_INDEX_HASHES.
+    * @param previousSize   - the length of the previous container.
+    * @param output         - the output memory block of outputCapacity bytes.
+    * @param outputCapacity - the capacity of the output.
+    * @param params         - the compression parameters, NULL for the defaults.
+    * @return the length of the container if no error occurred, error code otherwise.
+    *         BSCX_NOT_SUPPORTED if the previous container has no block hashes.
+    */
+    BSCX_API int64_t bscx_compress_incremental(const uint8_t * input, size_t inputSize, const uint8_t * previous, size_t previousSize, uint8_t * output, size_t outputCapacity, const bscx_params * params);
+
+    /**
+    * Reads the length of the data stored in a bsc1 container.
+    * @param input      - the container of inputSize bytes.
+    * @param inputSize  - the length of the container.
+    * @return the decompressed length if no error occurred, error code otherwise.
+    */
+    BSCX_API int64_t bscx_decompressed_size(const uint8_t * input, size_t inputSize);
+
+    /**
+    * Decompresses a bsc1 container straight into the caller's memory, blocks are decoded in parallel.
+    * @param input          - the container of inputSize bytes.
+    * @param inputSize      - the length of the container.
+    * @param output         - the output memory block of outputCapacity bytes.
+    * @param outputCapacity - the capacity of the output, see @ref bscx_decompressed_size.
+    * @param numThreads     - the number of blocks decoded concurrently, 0 for all cores.
+    * @return the decompressed length if no error occurred, error code otherwise.
+    */
+    BSCX_API int64_t bscx_decompress_container(const uint8_t * input, size_t inputSize, uint8_t * output, size_t outputCapacity, int32_t numThreads);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/*-----------------------------------------------------------*/
+/* End                                                bscx.h */
+/*-----------------------------------------------------------*/
@@ -0,0 +1,3433 @@
+/*-----------------------------------------------------------*/
+/* Block Sorting, Lossless Data Compression Library.         */
+/* Block-parallel bsc1 container functions                   */
+/*-----------------------------------------------------------*/
+
+/*--
+
+This file is a part of LibBSC Sharp, a .NET port of bsc and libbsc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+--*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <memory.h>
+
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <thread>
+
+#include "container.h"
+
+#include "../platform/platform.h"
+#include "../libbsc.h"
+#include "../filters.h"
+#include "../filters/tables.h"
+
+#ifdef LIBBSC_CONTEXT_SUPPORT
+  #include "../lzp/lzp.h"
+#endif
+
+#if defined(__linux__) && defined(LIBBSC_OPENMP)
+  #include <sched.h>
+  #include <stdio.h>
+  #include <stdint.h>
+  #include <unistd.h>
+  #include <sys/syscall.h>
+
+  #define LIBBSC_CONTAINER_NUMA
+#endif
+
+void bsc_container_default_params(bsc_container_params * params)
+{
+    params->blockSize       = LIBBSC_CONTAINER_DEFAULT_BLOCKSIZE;
+    params->numThreads      = 0;
+    params->lzpHashSize     = 16;
+    params->lzpMinLen       = 128;
+    params->blockSorter     = LIBBSC_BLOCKSORTER_BWT;
+    params->coder           = LIBBSC_CODER_QLFC_STATIC;
+    params->features        = LIBBSC_DEFAULT_FEATURES;
+    params->writeIndex      = 0;
+    params->sortingContexts = LIBBSC_CONTAINER_CONTEXTS_AUTODETECT;
+    params->recordSize      = LIBBSC_CONTAINER_RECORDSIZE_AUTODETECT;
+    params->minBlockSize    = 0;
+    params->storeThreshold  = LIBBSC_CONTAINER_DEFAULT_STORETHRESHOLD;
+    params->deduplicate     = 0;
+    params->cdcBlockSize    = 0;
+    params->longRange       = 0;
+    params->stats           = NULL;
+    params->previous        = NULL;
+    params->previousSize    = 0;
+    params->malloc          = NULL;
+    params->free            = NULL;
+    params->allocatorUser   = NULL;
+}
+
+static void bsc_container_write_block_header(unsigned char * header, long long blockOffset, int recordSize, int sortingContexts)
+{
+    memcpy(header, &blockOffset, sizeof(long long));
+    header[8] = (unsigned char)(signed char)recordSize;
+    header[9] = (unsigned char)(signed char)sortingContexts;
+}
+
+static void bsc_container_write_reference(unsigned char * record, long long blockOffset, long long sourceOffset, int dataSize, int flags)
+{
+    bsc_container_write_block_header(record, blockOffset, 0, flags);
+    memcpy(record + LIBBSC_CONTAINER_BLOCK_HEADER_SIZE + 0, &sourceOffset, sizeof(long long));
+    memcpy(record + LIBBSC_CONTAINER_BLOCK_HEADER_SIZE + 8, &dataSize, sizeof(int));
+}
+
+static int bsc_container_write_header(int nBlocks, int version, bsc_container_write_fn write, void * context)
+{
+    unsigned char header[LIBBSC_CONTAINER_HEADER_SIZE] = { 'b', 's', 'c', (unsigned char)(0x30 + version) };
+    memcpy(header + 4, &nBlocks, sizeof(int));
+
+    return write(context, header, LIBBSC_CONTAINER_HEADER_SIZE);
+}
+
+typedef struct bsc_container_index_entry
+{
+    long long   blockOffset;
+    long long   position;
+    int         size;
+    int         dataSize;
+    long long   sourceOffset;   /* the offset of the data repeated, blockOffset unless a reference.          */
+    long long   sourceBlock;    /* the offset of the block holding that data, once references are linked.    */
+    int         sourceSize;     /* the length of the data of that block.                                     */
+} bsc_container_index_entry;
+
+#define LIBBSC_CONTAINER_INDEX_CHUNK    256
+
+static int bsc_container_write_index(const bsc_container_index_entry * index, int nBlocks, long long position, bsc_container_write_fn write, void * context)
+{
+    unsigned char buffer[LIBBSC_CONTAINER_INDEX_CHUNK * LIBBSC_CONTAINER_INDEX_ENTRY_SIZE];
+
+    for (int firstBlock = 0; firstBlock < nBlocks; firstBlock += LIBBSC_CONTAINER_INDEX_CHUNK)
+    {
+        int count = nBlocks - firstBlock < LIBBSC_CONTAINER_INDEX_CHUNK ? nBlocks - firstBlock : LIBBSC_CONTAINER_INDEX_CHUNK;
+        for (int entryIndex = 0; entryIndex < count; ++entryIndex)
+        {
+            const bsc_container_index_entry * entry = &index[firstBlock + entryIndex];
+            unsigned char * record = buffer + entryIndex * LIBBSC_CONTAINER_INDEX_ENTRY_SIZE;
+
+            memcpy(record +  0, &entry->blockOffset, sizeof(long long));
+            memcpy(record +  8, &entry->position, sizeof(long long));
+            memcpy(record + 16, &entry->size, sizeof(int));
+            memcpy(record + 20, &entry->dataSize, sizeof(int));
+        }
+
+        int result = write(context, buffer, count * LIBBSC_CONTAINER_INDEX_ENTRY_SIZE);
+        if (result != LIBBSC_NO_ERROR) return result;
+    }
+
+    unsigned char trailer[LIBBSC_CONTAINER_INDEX_TRAILER_SIZE];
+    memcpy(trailer + 0, &position, sizeof(long long));
+    memcpy(trailer + 8, &nBlocks, sizeof(int));
+    trailer[12] = 'b'; trailer[13] = 's'; trailer[14] = 'c'; trailer[15] = 'i';
+
+    return write(context, trailer, LIBBSC_CONTAINER_INDEX_TRAILER_SIZE);
+}
+
+static inline unsigned long long bsc_container_rotl64(unsigned long long x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline unsigned long long bsc_container_fmix64(unsigned long long k)
+{
+    k ^= k >> 33; k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33; k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+
+    return k;
+}
+
+/**
+* MurmurHash3 x64 128-bit of a block (little-endian reading), it runs at several GB/s so hashing every block costs
+* next to nothing compared to sorting it.
+*/
+static void bsc_container_hash128(const unsigned char * data, int n, unsigned long long * hash)
+{
+    const unsigned long long c1 = 0x87c37b91114253d5ULL, c2 = 0x4cf5ad432745937fULL;
+
+    unsigned long long h1 = 0, h2 = 0, k1 = 0, k2 = 0;
+
+    int nChunks = n / 16;
+    for (int chunk = 0; chunk < nChunks; ++chunk)
+    {
+        memcpy(&k1, data + (size_t)chunk * 16 + 0, sizeof(k1));
+        memcpy(&k2, data + (size_t)chunk * 16 + 8, sizeof(k2));
+
+        k1 *= c1; k1 = bsc_container_rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+        h1 = bsc_container_rotl64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+
+        k2 *= c2; k2 = bsc_container_rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+        h2 = bsc_container_rotl64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+    }
+
+    const unsigned char * tail = data + (size_t)nChunks * 16;
+
+    int nTail = n & 15; k1 = k2 = 0;
+    for (int i = nTail - 1; i >= 8; --i) k2 ^= (unsigned long long)tail[i] << ((i - 8) * 8);
+    for (int i = (nTail < 8 ? nTail : 8) - 1; i >= 0; --i) k1 ^= (unsigned long long)tail[i] << (i * 8);
+
+    if (nTail > 8) { k2 *= c2; k2 = bsc_container_rotl64(k2, 33); k2 *= c1; h2 ^= k2; }
+    if (nTail > 0) { k1 *= c1; k1 = bsc_container_rotl64(k1, 31); k1 *= c2; h1 ^= k1; }
+
+    h1 ^= (unsigned long long)n; h2 ^= (unsigned long long)n;
+    h1 += h2; h2 += h1;
+    h1 = bsc_container_fmix64(h1); h2 = bsc_container_fmix64(h2);
+    h1 += h2; h2 += h1;
+
+    hash[0] = h1; hash[1] = h2;
+}
+
+static int bsc_container_write_hashes(const unsigned long long * hashes, int nBlocks, long long position, bsc_container_write_fn write, void * context)
+{
+    unsigned char buffer[LIBBSC_CONTAINER_INDEX_CHUNK * LIBBSC_CONTAINER_HASH_ENTRY_SIZE];
+
+    for (int firstBlock = 0; firstBlock < nBlocks; firstBlock += LIBBSC_CONTAINER_INDEX_CHUNK)
+    {
+        int count = nBlocks - firstBlock < LIBBSC_CONTAINER_INDEX_CHUNK ? nBlocks - firstBlock : LIBBSC_CONTAINER_INDEX_CHUNK;
+
+        memcpy(buffer, hashes + 2 * (size_t)firstBlock, (size_t)count * LIBBSC_CONTAINER_HASH_ENTRY_SIZE);
+
+        int result = write(context, buffer, count * LIBBSC_CONTAINER_HASH_ENTRY_SIZE);
+        if (result != LIBBSC_NO_ERROR) return result;
+    }
+
+    unsigned char trailer[LIBBSC_CONTAINER_HASH_TRAILER_SIZE];
+    memcpy(trailer + 0, &position, sizeof(long long));
+    memcpy(trailer + 8, &nBlocks, sizeof(int));
+    trailer[12] = 'b'; trailer[13] = 's'; trailer[14] = 'c'; trailer[15] = 'h';
+
+    return write(context, trailer, LIBBSC_CONTAINER_HASH_TRAILER_SIZE);
+}
+
+#ifdef LIBBSC_OPENMP
+
+static int bsc_container_num_threads(int numThreads, int nBlocks)
+{
+    if (numThreads <= 0) numThreads = omp_get_max_threads();
+
+    return numThreads < nBlocks ? numThreads : nBlocks;
+}
+
+#endif
+
+/**
+* Thread budget of a block-parallel loop. Every block processed concurrently gets one thread, the threads left over
+* go inside the blocks (libsais, LZP and QLFC sub-blocks), so a single block uses every core and many blocks use one
+* core each. Inner regions then run nested in the loop, nesting is enabled for the loop and restored afterwards.
+*/
+typedef struct bsc_container_budget
+{
+    int outer;      // blocks processed concurrently
+    int inner;      // threads inside a block
+    int features;   // the features blocks are processed with
+    int levels;     // the nesting to restore, 0 if unchanged
+} bsc_container_budget;
+
+#define LIBBSC_CONTAINER_DEFAULT_SUBBLOCKS  8
+
+static void bsc_container_budget_init(bsc_container_budget * budget, int numThreads, int nBlocks, int features, bool compress)
+{
+    budget->outer       = 1;
+    budget->inner       = 1;
+    budget->features    = features & ~LIBBSC_FEATURE_MULTITHREADING;
+    budget->levels      = 0;
+
+#ifdef LIBBSC_OPENMP
+
+    int total = numThreads > 0 ? numThreads : omp_get_max_threads();
+
+    budget->outer = total < nBlocks ? total : nBlocks; if (budget->outer < 1) budget->outer = 1;
+    budget->inner = (features & LIBBSC_FEATURE_MULTITHREADING) ? total / budget->outer : 1;
+
+    if (budget->inner > 1)
+    {
+        budget->features = features;
+
+        // Up to 8 sub-blocks the stream stays the one any machine writes, more is only asked for when the cores are there
+        if (compress && budget->inner > LIBBSC_CONTAINER_DEFAULT_SUBBLOCKS && LIBBSC_FEATURE_SUBBLOCKS_COUNT(features) == 0)
+        {
+            budget->features |= LIBBSC_FEATURE_SUBBLOCKS(budget->inner < LIBBSC_MAX_SUBBLOCKS ? budget->inner : LIBBSC_MAX_SUBBLOCKS);
+        }
+
+        if (budget->outer > 1)
+        {
+
+#if defined(_OPENMP) && (_OPENMP >= 200805)
+            if (omp_get_max_active_levels() < 2) { budget->levels = omp_get_max_active_levels() + 1; omp_set_max_active_levels(2); }
+#else
+            if (!omp_get_nested()) { budget->levels = 1; omp_set_nested(1); }
+#endif
+
+        }
+    }
+
+#else
+
+    (void)numThreads; (void)nBlocks; (void)compress;
+
+#endif
+}
+
+/**
+* Sizes the inner regions of the calling thread, call it from every thread of the loop before processing blocks.
+*/
+static void bsc_container_budget_enter(const bsc_container_budget * budget)
+{
+#ifdef LIBBSC_OPENMP
+    if (budget->inner > 1) omp_set_num_threads(budget->inner);
+#else
+    (void)budget;
+#endif
+}
+
+static void bsc_container_budget_done(bsc_container_budget * budget)
+{
+#ifdef LIBBSC_OPENMP
+
+#if defined(_OPENMP) && (_OPENMP >= 200805)
+    if (budget->levels > 0) omp_set_max_active_levels(budget->levels - 1);
+#else
+    if (budget->levels > 0) omp_set_nested(0);
+#endif
+
+#endif
+
+    budget->levels = 0;
+}
+
+#ifndef LIBBSC_CONTEXT_SUPPORT
+
+// The prebuilt core has no contexts, every call then allocates its own buffers
+#define bsc_context_compress(context, ...)              bsc_compress(__VA_ARGS__)
+#define bsc_context_decompress(context, ...)            bsc_decompress(__VA_ARGS__)
+#define bsc_context_detect_segments(context, ...)       bsc_detect_segments(__VA_ARGS__)
+#define bsc_context_detect_contextsorder(context, ...)  bsc_detect_contextsorder(__VA_ARGS__)
+#define bsc_context_detect_recordsize(context, ...)     bsc_detect_recordsize(__VA_ARGS__)
+#define bsc_context_reorder_forward(context, ...)       bsc_reorder_forward(__VA_ARGS__)
+#define bsc_context_reorder_reverse(context, ...)       bsc_reorder_reverse(__VA_ARGS__)
+#define bsc_context_malloc(context, size)               bsc_malloc(size)
+#define bsc_context_zero_malloc(context, size)          bsc_zero_malloc(size)
+#define bsc_context_free(context, address)              bsc_free(address)
+#define bsc_context_lzp_compress(context, ...)          bsc_lzp_compress(__VA_ARGS__)
+
+// The prebuilt core exports LZP without the context argument, lzp/lzp.h declares the newer entry point
+extern "C" int bsc_lzp_compress(const unsigned char * input, unsigned char * output, int n, int hashSize, int minLen, int features);
+
+#else
+
+#define bsc_context_lzp_compress(context, ...)          bsc_lzp_compress(__VA_ARGS__, context)
+
+#endif
+
+/**
+* Creates the scratch memory of one compressing or decoding thread, so LZP, sorting, coding and detectors buffers
+* are allocated once per thread instead of once per block. A core built without contexts (the prebuilt libbsc.lib)
+* gets NULL, as does a failed allocation, and blocks then allocate their buffers as before.
+* @param params     - the compression parameters holding the allocator, NULL for bsc_malloc.
+*/
+static bsc_context * bsc_container_create_scratch(const bsc_container_params * params, int features)
+{
+#ifdef LIBBSC_CONTEXT_SUPPORT
+    if (params != NULL && params->malloc != NULL)
+    {
+        return bsc_context_create_full(features, params->malloc, NULL, params->free, params->allocatorUser);
+    }
+
+    return bsc_context_create(features);
+#else
+    (void)params; (void)features; return NULL;
+#endif
+}
+
+static void bsc_container_destroy_scratch(bsc_context * scratch)
+{
+#ifdef LIBBSC_CONTEXT_SUPPORT
+    bsc_context_destroy(scratch);
+#else
+    (void)scratch;
+#endif
+}
+
+/**
+* Allocates memory of a compression that is not per-thread scratch (block plans, slot buffers, indexes), with the
+* allocator of the parameters when they have one so it bounds the whole compression, bsc_malloc otherwise.
+*/
+static void * bsc_container_malloc(const bsc_container_params * params, size_t size)
+{
+    return params->malloc != NULL ? params->malloc(params->allocatorUser, size) : bsc_malloc(size);
+}
+
+static void * bsc_container_zero_malloc(const bsc_container_params * params, size_t size)
+{
+    if (params->malloc == NULL)
+    {
+        return bsc_zero_malloc(size);
+    }
+
+    void * address = params->malloc(params->allocatorUser, size);
+    if (address != NULL) memset(address, 0, size);
+
+    return address;
+}
+
+static void bsc_container_free(const bsc_container_params * params, void * address)
+{
+    if (address == NULL)
+    {
+        return;
+    }
+
+    if (params->malloc != NULL) params->free(params->allocatorUser, address); else bsc_free(address);
+}
+
+static int bsc_container_thread_index()
+{
+#ifdef LIBBSC_OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+#define LIBBSC_CONTAINER_MAX_NODES      64
+#define LIBBSC_CONTAINER_NODE_SAMPLES   16
+
+/**
+* NUMA placement of the block-parallel loops over memory. Every worker is bound to the CPUs of one node and takes the
+* blocks whose pages sit on that node first, then helps the other nodes. Its scratch context is created once bound,
+* so suffix arrays and coder buffers are first touched locally. Placement is on only on Linux, with OpenMP, when
+* the threads the process may run on span two nodes or more, otherwise nNodes is 1 and the loops are unchanged.
+*/
+typedef struct bsc_container_numa
+{
+    int         nNodes;
+
+#ifdef LIBBSC_CONTAINER_NUMA
+    int         ids[LIBBSC_CONTAINER_MAX_NODES];
+    cpu_set_t   cpus[LIBBSC_CONTAINER_MAX_NODES];
+    bool        bind;
+#endif
+
+} bsc_container_numa;
+
+typedef struct bsc_container_numa_binding
+{
+    bool        restore;
+
+#ifdef LIBBSC_CONTAINER_NUMA
+    cpu_set_t   saved;
+#endif
+
+} bsc_container_numa_binding;
+
+#ifdef LIBBSC_CONTAINER_NUMA
+
+static bool bsc_container_numa_parse_cpus(const char * list, cpu_set_t * cpus)
+{
+    CPU_ZERO(cpus);
+
+    for (const char * cursor = list; *cursor != 0 && *cursor != '\n'; )
+    {
+        char * end = NULL;
+
+        long first = strtol(cursor, &end, 10); if (end == cursor || first < 0) return false;
+        long last  = first;
+
+        cursor = end;
+        if (*cursor == '-')
+        {
+            last = strtol(cursor + 1, &end, 10); if (end == cursor + 1 || last < first) return false;
+            cursor = end;
+        }
+
+        for (long cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu) CPU_SET((int)cpu, cpus);
+
+        if (*cursor == ',') cursor++;
+    }
+
+    return true;
+}
+
+/**
+* Reads the nodes that have CPUs from sysfs.
+*/
+static bool bsc_container_numa_load(bsc_container_numa * topology)
+{
+    topology->nNodes = 0; topology->bind = false;
+
+    char list[4096];
+
+    // The online list has the same format as a CPU list, a cpu_set_t then holds the node ids
+    cpu_set_t online;
+
+    FILE * file = fopen("/sys/devices/system/node/online", "r");
+    if (file == NULL) return false;
+
+    bool parsed = fgets(list, sizeof(list), file) != NULL && bsc_container_numa_parse_cpus(list, &online);
+    fclose(file);
+
+    if (!parsed) return false;
+
+    for (int id = 0; id < CPU_SETSIZE && topology->nNodes < LIBBSC_CONTAINER_MAX_NODES; ++id)
+    {
+        if (!CPU_ISSET(id, &online)) continue;
+
+        char path[64];
+
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", id);
+        file = fopen(path, "r"); if (file == NULL) continue;
+
+        parsed = fgets(list, sizeof(list), file) != NULL && bsc_container_numa_parse_cpus(list, &topology->cpus[topology->nNodes]);
+        fclose(file);
+
+        if (parsed && CPU_COUNT(&topology->cpus[topology->nNodes]) > 0)
+        {
+            topology->ids[topology->nNodes++] = id;
+        }
+    }
+
+    return true;
+}
+
+static const bsc_container_numa * bsc_container_numa_topology()
+{
+    // Loaded once per process, the initialization of a local static is thread-safe
+    static bsc_container_numa   topology;
+    static bool                 loaded = bsc_container_numa_load(&topology);
+
+    (void)loaded; return &topology;
+}
+
+#endif
+
+/**
+* Sets up the placement of a parallel loop, restricted to the CPUs the calling thread may run on.
+*/
+static void bsc_container_numa_init(bsc_container_numa * numa, int numThreads)
+{
+    numa->nNodes = 1;
+
+#ifdef LIBBSC_CONTAINER_NUMA
+
+    cpu_set_t allowed;
+    if (numThreads <= 1 || sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+    {
+        return;
+    }
+
+    const bsc_container_numa * topology = bsc_container_numa_topology();
+
+    int nNodes = 0;
+    for (int node = 0; node < topology->nNodes; ++node)
+    {
+        CPU_AND(&numa->cpus[nNodes], &topology->cpus[node], &allowed);
+        if (CPU_COUNT(&numa->cpus[nNodes]) > 0)
+        {
+            numa->ids[nNodes++] = topology->ids[node];
+        }
+    }
+
+    if (nNodes > 1)
+    {
+        numa->nNodes = nNodes;
+
+        // Threads the user already bound through OMP_PROC_BIND or OMP_PLACES are left where they are
+#if defined(_OPENMP) && (_OPENMP >= 201307)
+        numa->bind = omp_get_proc_bind() == omp_proc_bind_false;
+#else
+        numa->bind = true;
+#endif
+    }
+
+#else
+
+    (void)numThreads;
+
+#endif
+}
+
+/**
+* Finds the node holding most of the sampled pages of a memory range.
+* @return the node index in the placement, -1 if unknown.
+*/
+static int bsc_container_numa_locate(const bsc_container_numa * numa, const unsigned char * data, long long size)
+{
+#ifdef LIBBSC_CONTAINER_NUMA
+
+    if (numa->nNodes <= 1 || size <= 0)
+    {
+        return -1;
+    }
+
+    static const long pageSize = sysconf(_SC_PAGESIZE);
+
+    void *  pages[LIBBSC_CONTAINER_NODE_SAMPLES];
+    int     status[LIBBSC_CONTAINER_NODE_SAMPLES];
+    int     nPages = 0;
+
+    for (int sample = 0; sample < LIBBSC_CONTAINER_NODE_SAMPLES; ++sample)
+    {
+        void * page = (void *)((uintptr_t)(data + size * sample / LIBBSC_CONTAINER_NODE_SAMPLES) & ~(uintptr_t)(pageSize - 1));
+        if (nPages == 0 || pages[nPages - 1] != page) pages[nPages++] = page;
+    }
+
+    // move_pages without target nodes only reports where the pages are, pages never touched report an error
+    if (syscall(SYS_move_pages, 0, (unsigned long)nPages, pages, NULL, status, 0) != 0)
+    {
+        return -1;
+    }
+
+    int votes[LIBBSC_CONTAINER_MAX_NODES] = { 0 }, best = -1;
+    for (int page = 0; page < nPages; ++page)
+    {
+        for (int node = 0; node < numa->nNodes; ++node)
+        {
+            if (status[page] == numa->ids[node] && ++votes[node] > (best >= 0 ? votes[best] : 0)) best = node;
+        }
+    }
+
+    return best;
+
+#else
+
+    (void)numa; (void)data; (void)size; return -1;
+
+#endif
+}
+
+/**
+* Binds the calling thread of a parallel loop to its node, threads are spread over the nodes in contiguous groups.
+* @return the node of the thread, -1 if placement is off.
+*/
+static int bsc_container_numa_enter(const bsc_container_numa * numa, int thread, int nThreads, bsc_container_numa_binding * binding)
+{
+    binding->restore = false;
+
+#ifdef LIBBSC_CONTAINER_NUMA
+
+    if (numa->nNodes <= 1)
+    {
+        return -1;
+    }
+
+    if (!numa->bind)
+    {
+        int cpu = sched_getcpu();
+        for (int node = 0; node < numa->nNodes; ++node)
+        {
+            if (cpu >= 0 && CPU_ISSET(cpu, &numa->cpus[node])) return node;
+        }
+
+        return -1;
+    }
+
+    int node = (int)((long long)thread * numa->nNodes / (nThreads > 0 ? nThreads : 1));
+
+    // OpenMP threads are pooled, the previous mask is restored once the loop is over
+    if (sched_getaffinity(0, sizeof(binding->saved), &binding->saved) == 0 && sched_setaffinity(0, sizeof(numa->cpus[node]), &numa->cpus[node]) == 0)
+    {
+        binding->restore = true;
+    }
+
+    return node;
+
+#else
+
+    (void)numa; (void)thread; (void)nThreads; return -1;
+
+#endif
+}
+
+static void bsc_container_numa_leave(bsc_container_numa_binding * binding)
+{
+#ifdef LIBBSC_CONTAINER_NUMA
+    if (binding->restore) sched_setaffinity(0, sizeof(binding->saved), &binding->saved);
+#endif
+
+    binding->restore = false;
+}
+
+#define LIBBSC_CONTAINER_SAMPLE_WINDOWS         32
+#define LIBBSC_CONTAINER_SAMPLE_WINDOW_SIZE     4096
+#define LIBBSC_CONTAINER_ORDER1_MARGIN          10
+
+/**
+* Estimates the order-0 and order-1 entropy of a block from 32 windows of 4KB spread over it, or from the whole
+* block when it is smaller. A sample underestimates sparse contexts, so both are Miller-Madow corrected.
+* @param order0     - receives the order-0 entropy in 1/100 bits per byte.
+* @param order1     - receives the order-1 entropy in 1/100 bits per byte.
+* @return LIBBSC_NO_ERROR if no error occurred, error code otherwise.
+*/
+static int bsc_container_estimate_entropy(bsc_context * scratch, const unsigned char * input, int n, int * order0, int * order1)
+{
+    *order0 = *order1 = 0;
+    if (n < 2)
+    {
+        return LIBBSC_NO_ERROR;
+    }
+
+    int * frequencies = (int *)bsc_context_zero_malloc(scratch, ALPHABET_SIZE * ALPHABET_SIZE * sizeof(int));
+    if (frequencies == NULL)
+    {
+        return LIBBSC_NOT_ENOUGH_MEMORY;
+    }
+
+    int nWindows    = n > LIBBSC_CONTAINER_SAMPLE_WINDOWS * LIBBSC_CONTAINER_SAMPLE_WINDOW_SIZE ? LIBBSC_CONTAINER_SAMPLE_WINDOWS : 1;
+    int windowSize  = nWindows > 1 ? LIBBSC_CONTAINER_SAMPLE_WINDOW_SIZE : n;
+    int stride      = nWindows > 1 ? (n - windowSize) / (nWindows - 1) : 0;
+    int total       = 0;
+
+    for (int window = 0; window < nWindows; ++window)
+    {
+        const unsigned char * sample = input + (size_t)window * stride;
+
+        unsigned char C0 = sample[0];
+        for (int i = 1; i < windowSize; ++i)
+        {
+            unsigned char C1 = sample[i];
+            frequencies[(C0 << 8) | C1]++;
+            C0 = C1;
+        }
+
+        total += windowSize - 1;
+    }
+
+    // The bias correction of a context with k symbols is (k - 1) / (2 ln 2) bits, here in 1/65536 bits
+    const long long correction = 47274;
+
+    int         counts[ALPHABET_SIZE] = { 0 };
+    long long   entropy1 = 0;
+
+    for (int context = 0; context < ALPHABET_SIZE; ++context)
+    {
+        int count = 0, symbols = 0;
+        for (int symbol = 0; symbol < ALPHABET_SIZE; ++symbol)
+        {
+            int frequency = frequencies[(context << 8) | symbol];
+            if (frequency > 0)
+            {
+                count += frequency; symbols++; counts[symbol] += frequency;
+                entropy1 -= bsc_entropy(frequency);
+            }
+        }
+
+        if (count > 0)
+        {
+            entropy1 += bsc_entropy(count) + (symbols - 1) * correction;
+        }
+    }
+
+    long long entropy0 = bsc_entropy(total);
+    int symbols0 = 0;
+    for (int symbol = 0; symbol < ALPHABET_SIZE; ++symbol)
+    {
+        if (counts[symbol] > 0)
+        {
+            entropy0 -= bsc_entropy(counts[symbol]); symbols0++;
+        }
+    }
+    entropy0 += (symbols0 - 1) * correction;
+
+    bsc_context_free(scratch, frequencies);
+
+    *order0 = (int)(entropy0 * 100 / 65536 / total);
+    *order1 = (int)(entropy1 * 100 / 65536 / total);
+
+    return LIBBSC_NO_ERROR;
+}
+
+/**
+* Tells whether a block looks incompressible: uniform bytes with no order-1 structure either. Only blocks large
+* enough for the full sample are estimated, so the order-1 margin for the remaining sampling bias is a constant.
+* Long repeats of incompressible data inside the block cannot be seen from a sample, a threshold of 0 disables
+* the estimator for such inputs.
+*/
+static bool bsc_container_incompressible(bsc_context * scratch, const unsigned char * input, int n, int threshold)
+{
+    if (threshold <= 0 || n < LIBBSC_CONTAINER_SAMPLE_WINDOWS * LIBBSC_CONTAINER_SAMPLE_WINDOW_SIZE)
+    {
+        return false;
+    }
+
+    int order0 = 0, order1 = 0;
+    if (bsc_container_estimate_entropy(scratch, input, n, &order0, &order1) != LIBBSC_NO_ERROR)
+    {
+        return false;
+    }
+
+    return order0 >= threshold && order1 >= threshold - LIBBSC_CONTAINER_ORDER1_MARGIN;
+}
+
+#define LIBBSC_CONTAINER_DETECTORS_MIN_SIZE 64
+
+#define LIBBSC_CONTAINER_LZP_SAMPLE_WINDOWS     4
+#define LIBBSC_CONTAINER_LZP_SAMPLE_WINDOW_SIZE (1024 * 1024)
+#define LIBBSC_CONTAINER_LZP_MIN_GAIN           10
+#define LIBBSC_CONTAINER_LZP_MAX_HASH_SIZE      28
+
+/**
+* Resolves the automatic LZP parameters of a block. The hash table gets at least 16 bytes of input per slot, up
+* to the maximum 2^28 slots. The minimum match length comes from LZP runs with 64 and 128 over 4 windows of 1MB
+* (the whole block when smaller): LZP is disabled when it removes less than 10% of the sample, as it then costs
+* more in sorting contexts and time than it saves, and 64 is kept only when it leaves 1.5 times less to sort.
+* @param lzpHashSize    - the hash table size or LIBBSC_CONTAINER_LZP_AUTODETECT, receives the one to use.
+* @param lzpMinLen      - the minimum match length or LIBBSC_CONTAINER_LZP_AUTODETECT, receives the one to use.
+* @return LIBBSC_NO_ERROR if no error occurred, error code otherwise.
+*/
+static int bsc_container_detect_lzp(bsc_context * scratch, const unsigned char * input, int n, int features, int * lzpHashSize, int * lzpMinLen)
+{
+    if (*lzpHashSize == 0 || *lzpMinLen == 0)
+    {
+        *lzpHashSize = *lzpMinLen = 0; return LIBBSC_NO_ERROR;
+    }
+
+    if (*lzpHashSize == LIBBSC_CONTAINER_LZP_AUTODETECT)
+    {
+        int hashSize = 10; while (hashSize < LIBBSC_CONTAINER_LZP_MAX_HASH_SIZE && (1 << (hashSize + 4)) < n) { hashSize++; }
+
+        *lzpHashSize = hashSize;
+    }
+
+    if (*lzpMinLen != LIBBSC_CONTAINER_LZP_AUTODETECT)
+    {
+        return LIBBSC_NO_ERROR;
+    }
+
+    if (n < LIBBSC_CONTAINER_DETECTORS_MIN_SIZE)
+    {
+        *lzpHashSize = *lzpMinLen = 0; return LIBBSC_NO_ERROR;
+    }
+
+    int nWindows    = n > LIBBSC_CONTAINER_LZP_SAMPLE_WINDOWS * LIBBSC_CONTAINER_LZP_SAMPLE_WINDOW_SIZE ? LIBBSC_CONTAINER_LZP_SAMPLE_WINDOWS : 1;
+    int windowSize  = nWindows > 1 ? LIBBSC_CONTAINER_LZP_SAMPLE_WINDOW_SIZE : n;
+    int stride      = nWindows > 1 ? (n - windowSize) / (nWindows - 1) : 0;
+
+    unsigned char * buffer = (unsigned char *)bsc_context_malloc(scratch, windowSize);
+    if (buffer == NULL)
+    {
+        return LIBBSC_NOT_ENOUGH_MEMORY;
+    }
+
+    long long total = 0, remaining64 = 0, remaining128 = 0;
+    for (int window = 0; window < nWindows; ++window)
+    {
+        const unsigned char * sample = input + (size_t)window * stride;
+
+        int result64 = bsc_context_lzp_compress(scratch, sample, buffer, windowSize, *lzpHashSize, 64, features & ~LIBBSC_FEATURE_MULTITHREADING);
+        if (result64 < LIBBSC_NO_ERROR && result64 != LIBBSC_NOT_COMPRESSIBLE) { bsc_context_free(scratch, buffer); return result64; }
+
+        int result128 = bsc_context_lzp_compress(scratch, sample, buffer, windowSize, *lzpHashSize, 128, features & ~LIBBSC_FEATURE_MULTITHREADING);
+        if (result128 < LIBBSC_NO_ERROR && result128 != LIBBSC_NOT_COMPRESSIBLE) { bsc_context_free(scratch, buffer); return result128; }
+
+        total        += windowSize;
+        remaining64  += result64  > 0 ? result64  : windowSize;
+        remaining128 += result128 > 0 ? result128 : windowSize;
+    }
+
+    bsc_context_free(scratch, buffer);
+
+    long long remaining = remaining64 < remaining128 ? remaining64 : remaining128;
+    if ((total - remaining) * 100 < total * LIBBSC_CONTAINER_LZP_MIN_GAIN)
+    {
+        *lzpHashSize = *lzpMinLen = 0; return LIBBSC_NO_ERROR;
+    }
+
+    *lzpMinLen = remaining128 * 2 >= remaining64 * 3 ? 64 : 128;
+
+    return LIBBSC_NO_ERROR;
+}
+
+/**
+* Compresses one block of the container into the worker arena. Record reordering and reversed contexts are
+* applied to a copy of the block in the arena when configured or detected, the decoder undoes them in the
+* opposite order (contexts first, then records) as the original bsc tool does.
+* @param input      - the input block of n bytes.
+* @param arena      - the worker arena of LIBBSC_CONTAINER_BLOCK_HEADER_SIZE + n + LIBBSC_HEADER_SIZE bytes.
+* @param skipped    - set when the block was stored right away by the entropy estimator.
+* @param scratch    - the scratch memory of the calling thread, can be NULL.
+* @return the size of block header + compressed block if no error occurred, error code otherwise.
+*/
+static int bsc_container_compress_block(const unsigned char * input, int n, long long blockOffset, unsigned char * arena, const bsc_container_params * params, bool * skipped, bsc_context * scratch)
+{
+    unsigned char *         block           = arena + LIBBSC_CONTAINER_BLOCK_HEADER_SIZE;
+    const unsigned char *   data            = input;
+    int                     recordSize      = params->recordSize;
+    int                     sortingContexts = params->sortingContexts;
+    int                     lzpHashSize     = params->lzpHashSize;
+    int                     lzpMinLen       = params->lzpMinLen;
+
+    // Already compressed or encrypted data would go through LZP, sorting and coding only to be stored afterwards
+    *skipped = bsc_container_incompressible(scratch, input, n, params->storeThreshold);
+    if (*skipped)
+    {
+        bsc_container_write_block_header(arena, blockOffset, 1, LIBBSC_CONTEXTS_FOLLOWING);
+
+        return LIBBSC_CONTAINER_BLOCK_HEADER_SIZE + bsc_store(input, block, n, params->features);
+    }
+
+    // Detectors are run per block by the worker owning it, tiny blocks have too little context to be worth it
+    if (recordSize == LIBBSC_CONTAINER_RECORDSIZE_AUTODETECT)
+    {
+        recordSize = n >= LIBBSC_CONTAINER_DETECTORS_MIN_SIZE ? bsc_context_detect_recordsize(scratch, data, n, params->features) : 1;
+        if (recordSize < LIBBSC_NO_ERROR) return recordSize;
+    }
+
+    if (recordSize > 1)
+    {
+        memcpy(block, input, n); data = block;
+
+        int result = bsc_context_reorder_forward(scratch, block, n, recordSize, params->features);
+        if (result != LIBBSC_NO_ERROR) return result;
+    }
+
+    if (sortingContexts == LIBBSC_CONTAINER_CONTEXTS_AUTODETECT)
+    {
+        sortingContexts = n >= LIBBSC_CONTAINER_DETECTORS_MIN_SIZE ? bsc_context_detect_contextsorder(scratch, data, n, params->features) : LIBBSC_CONTEXTS_FOLLOWING;
+        if (sortingContexts < LIBBSC_NO_ERROR) return sortingContexts;
+    }
+
+    if (sortingContexts == LIBBSC_CONTEXTS_PRECEDING)
+    {
+        if (data != block) { memcpy(block, input, n); data = block; }
+
+        int result = bsc_reverse_block(block, n, params->features);
+        if (result != LIBBSC_NO_ERROR) return result;
+    }
+
+    // Sampled after the transforms, LZP runs on the data as they leave it, the choice is recorded in the block mode
+    if (lzpHashSize == LIBBSC_CONTAINER_LZP_AUTODETECT || lzpMinLen == LIBBSC_CONTAINER_LZP_AUTODETECT)
+    {
+        int result = bsc_container_detect_lzp(scratch, data, n, params->features, &lzpHashSize, &lzpMinLen);
+        if (result != LIBBSC_NO_ERROR) return result;
+    }
+
+    // A transformed block already sits in the arena and is compressed in place, when that does not pay off
+    // the arena content is lost and the untouched input is stored instead, as the original bsc tool does
+    int result = bsc_context_compress(scratch, data, block, n, lzpHashSize, lzpMinLen, params->blockSorter, params->coder, params->features);
+    if (result == LIBBSC_NOT_COMPRESSIBLE && data == block)
+    {
+        recordSize = 1; sortingContexts = LIBBSC_CONTEXTS_FOLLOWING;
+        result = bsc_store(input, block, n, params->features);
+    }
+
+    if (result < LIBBSC_NO_ERROR)
+    {
+        return result;
+    }
+
+    bsc_container_write_block_header(arena, blockOffset, recordSize, sortingContexts);
+
+    return LIBBSC_CONTAINER_BLOCK_HEADER_SIZE + result;
+}
+
+static int bsc_container_read_block(bsc_container_read_fn read, void * context, unsigned char * buffer, int size)
+{
+    for (int position = 0; position < size; )
+    {
+        int result = read(context, buffer + position, size - position);
+        if (result <= 0)
+        {
+            return result < LIBBSC_NO_ERROR ? result : LIBBSC_UNEXPECTED_EOB;
+        }
+
+        position += result;
+    }
+
+    return LIBBSC_NO_ERROR;
+}
+
+/*
+* Compression pipeline: a reader stage fills a ring of slots, compressor workers claim blocks in order and a
+* writer stage drains them in order. Block b always lives in slot b % nSlots and every slot carries a ticket:
+* 3 * b when the slot is free for block b, 3 * b + 1 once loaded and 3 * b + 2 once compressed, the writer
+* then hands the slot over to block b + nSlots. Stages only ever wait on tickets, no lock is taken.
+*/
+typedef struct bsc_container_pipeline
+{
+    bsc_container_read_fn           read;
+    void *                          readContext;
+    const unsigned char *           input;
+    long long                       n;
+    const bsc_container_params *    params;
+    bsc_container_write_fn          write;
+    void *                          writeContext;
+
+    int                             nBlocks;
+    long long *                     offsets;
+    long long *                     sources;
+    unsigned char *                 flags;
+    unsigned long long *            hashes;
+    int *                           reuse;
+    const bsc_container_index_entry * previousIndex;
+    int                             nSlots;
+    int                             inputSize;
+    int                             arenaSize;
+    unsigned char **                buffers;
+    int *                           results;
+    bool *                          skipped;
+    std::atomic<long long> *        tickets;
+    std::atomic<int>                nextBlock;
+    std::atomic<int>                result;
+
+    bsc_container_numa              numa;
+    int *                           nodes;
+    std::atomic<bool> *             claimed;
+    const bsc_container_budget *    budget;
+
+    bsc_container_index_entry *     index;
+    long long                       position;
+    bsc_container_stats             stats;
+} bsc_container_pipeline;
+
+static void bsc_container_pipeline_fail(bsc_container_pipeline * pipeline, int result)
+{
+    int expected = LIBBSC_NO_ERROR;
+    pipeline->result.compare_exchange_strong(expected, result);
+}
+
+/**
+* Waits until the ticket of a slot reaches the given value.
+* @return true when reached, false if another stage failed meanwhile.
+*/
+static bool bsc_container_pipeline_wait(bsc_container_pipeline * pipeline, int slot, long long ticket)
+{
+    for (int spin = 0; pipeline->tickets[slot].load(std::memory_order_acquire) != ticket; ++spin)
+    {
+        if (pipeline->result.load(std::memory_order_relaxed) != LIBBSC_NO_ERROR)
+        {
+            return false;
+        }
+
+        // Stages wait for whole blocks, so back off to sleeping quickly instead of burning a core
+        if (spin < 64) std::this_thread::yield(); else std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+
+    return true;
+}
+
+static long long bsc_container_pipeline_offset(const bsc_container_pipeline * pipeline, int block)
+{
+    return pipeline->offsets != NULL ? pipeline->offsets[block] : (long long)block * pipeline->params->blockSize;
+}
+
+static int bsc_container_pipeline_size(const bsc_container_pipeline * pipeline, int block)
+{
+    if (pipeline->offsets != NULL)
+    {
+        return (int)(pipeline->offsets[block + 1] - pipeline->offsets[block]);
+    }
+
+    long long blockOffset = bsc_container_pipeline_offset(pipeline, block);
+    return (int)(pipeline->n - blockOffset < pipeline->params->blockSize ? pipeline->n - blockOffset : pipeline->params->blockSize);
+}
+
+static int bsc_container_pipeline_load(bsc_container_pipeline * pipeline, int block)
+{
+    if (pipeline->read == NULL)
+    {
+        return LIBBSC_NO_ERROR;
+    }
+
+    return bsc_container_read_block(pipeline->read, pipeline->readContext, pipeline->buffers[block % pipeline->nSlots], bsc_container_pipeline_size(pipeline, block));
+}
+
+static void bsc_container_pipeline_compress(bsc_container_pipeline * pipeline, int block, bsc_context * scratch)
+{
+    int                     slot    = block % pipeline->nSlots;
+    long long               offset  = bsc_container_pipeline_offset(pipeline, block);
+    const unsigned char *   input   = pipeline->read != NULL ? pipeline->buffers[slot] : pipeline->input + offset;
+    unsigned char *         arena   = pipeline->buffers[slot] + pipeline->inputSize;
+
+    // A repeated block only costs its reference record, the reader copies the data of its earlier occurrence
+    if (pipeline->sources != NULL && pipeline->sources[block] >= 0)
+    {
+        bsc_container_write_reference(arena, offset, pipeline->sources[block], bsc_container_pipeline_size(pipeline, block), pipeline->flags[block]);
+
+        pipeline->results[slot] = LIBBSC_CONTAINER_REFERENCE_SIZE; pipeline->skipped[slot] = false;
+        return;
+    }
+
+    // Memory inputs are hashed upfront for planning, a stream is hashed by the worker that holds the block
+    if (pipeline->hashes != NULL && pipeline->read != NULL)
+    {
+        bsc_container_hash128(input, bsc_container_pipeline_size(pipeline, block), pipeline->hashes + 2 * (size_t)block);
+    }
+
+    // A block the previous container already holds keeps its compressed bytes, only its offset changes
+    if (pipeline->reuse != NULL && pipeline->reuse[block] >= 0)
+    {
+        const bsc_container_index_entry *   entry   = &pipeline->previousIndex[pipeline->reuse[block]];
+        const unsigned char *               record  = pipeline->params->previous + entry->position;
+
+        // The previous container is input too, its sizes must fit the block and the arena before anything is copied
+        if (entry->dataSize != bsc_container_pipeline_size(pipeline, block) || entry->size < LIBBSC_CONTAINER_BLOCK_HEADER_SIZE || entry->size > pipeline->arenaSize)
+        {
+            pipeline->results[slot] = LIBBSC_DATA_CORRUPT; pipeline->skipped[slot] = false;
+            return;
+        }
+
+        bsc_container_write_block_header(arena, offset, (signed char)record[8], (signed char)(record[9] & ~(LIBBSC_CONTAINER_BLOCK_REFERENCED | LIBBSC_CONTAINER_REFERENCE_LAST)));
+        memcpy(arena + LIBBSC_CONTAINER_BLOCK_HEADER_SIZE, record + LIBBSC_CONTAINER_BLOCK_HEADER_SIZE, (size_t)entry->size - LIBBSC_CONTAINER_BLOCK_HEADER_SIZE);
+
+        pipeline->results[slot] = entry->size; pipeline->skipped[slot] = false;
+        arena[9] |= pipeline->flags != NULL ? pipeline->flags[block] : 0;
+        return;
+    }
+
+    pipeline->results[slot] = bsc_container_compress_block(input, bsc_container_pipeline_size(pipeline, block), offset, arena, pipeline->params, &pipeline->skipped[slot], scratch);
+    if (pipeline->flags != NULL && pipeline->results[slot] >= LIBBSC_NO_ERROR)
+    {
+        arena[9] |= pipeline->flags[block];
+    }
+}
+
+static int bsc_container_pipeline_store(bsc_container_pipeline * pipeline, int block)
+{
+    int slot = block % pipeline->nSlots;
+    int size = pipeline->results[slot];
+
+    if (size < LIBBSC_NO_ERROR)
+    {
+        return size;
+    }
+
+    if (pipeline->index != NULL)
+    {
+        pipeline->index[block].blockOffset  = bsc_container_pipeline_offset(pipeline, block);
+        pipeline->index[block].position     = pipeline->position;
+        pipeline->index[block].size         = size;
+        pipeline->index[block].dataSize     = bsc_container_pipeline_size(pipeline, block);
+        pipeline->index[block].sourceOffset = pipeline->sources != NULL && pipeline->sources[block] >= 0 ? pipeline->sources[block] : bsc_container_pipeline_offset(pipeline, block);
+    }
+
+    pipeline->position += size;
+
+    pipeline->stats.nBlocks++;
+    if (pipeline->sources != NULL && pipeline->sources[block] >= 0 && pipeline->params->longRange)
+    {
+        pipeline->stats.longMatches++;
+        pipeline->stats.longBytes += bsc_container_pipeline_size(pipeline, block);
+    }
+    else if (pipeline->sources != NULL && pipeline->sources[block] >= 0)
+    {
+        pipeline->stats.dedupBlocks++;
+        pipeline->stats.dedupBytes += bsc_container_pipeline_size(pipeline, block);
+    }
+    else
+    {
+        // The mode of a stored libbsc block is 0, whichever way it came to be stored
+        int mode = 0; memcpy(&mode, pipeline->buffers[slot] + pipeline->inputSize + LIBBSC_CONTAINER_BLOCK_HEADER_SIZE + 8, sizeof(int));
+        if (mode == 0) pipeline->stats.storedBlocks++;
+    }
+
+    if (pipeline->reuse != NULL && pipeline->reuse[block] >= 0)
+    {
+        pipeline->stats.reusedBlocks++;
+        pipeline->stats.reusedBytes += bsc_container_pipeline_size(pipeline, block);
+    }
+
+    if (pipeline->skipped[slot])
+    {
+        pipeline->stats.skippedBlocks++;
+        pipeline->stats.skippedBytes += bsc_container_pipeline_size(pipeline, block);
+    }
+
+    return pipeline->write(pipeline->writeContext, pipeline->buffers[slot] + pipeline->inputSize, size);
+}
+
+static void bsc_container_pipeline_reader(bsc_container_pipeline * pipeline)
+{
+    for (int block = 0; block < pipeline->nBlocks; ++block)
+    {
+        int slot = block % pipeline->nSlots;
+        if (!bsc_container_pipeline_wait(pipeline, slot, 3LL * block)) return;
+
+        int result = bsc_container_pipeline_load(pipeline, block);
+        if (result != LIBBSC_NO_ERROR) { bsc_container_pipeline_fail(pipeline, result); return; }
+
+        pipeline->tickets[slot].store(3LL * block + 1, std::memory_order_release);
+    }
+}
+
+/**
+* Claims the next block of a worker. With NUMA placement, a worker takes the first loaded block of its node among the
+* next nSlots ones, or the first loaded block of any node when its node has none, so no block is ever left behind.
+* @return the block, -1 when every block is claimed or another stage failed.
+*/
+static int bsc_container_pipeline_next(bsc_container_pipeline * pipeline, int node)
+{
+    if (pipeline->claimed == NULL)
+    {
+        int block = pipeline->nextBlock.fetch_add(1);
+        return block < pipeline->nBlocks ? block : -1;
+    }
+
+    for (int spin = 0; pipeline->result.load(std::memory_order_relaxed) == LIBBSC_NO_ERROR; ++spin)
+    {
+        int first = pipeline->nextBlock.load(std::memory_order_relaxed);
+        while (first < pipeline->nBlocks && pipeline->claimed[first].load(std::memory_order_acquire)) first++;
+
+        if (first >= pipeline->nBlocks)
+        {
+            return -1;
+        }
+
+        int hint = pipeline->nextBlock.load(std::memory_order_relaxed);
+        while (hint < first && !pipeline->nextBlock.compare_exchange_weak(hint, first)) { }
+
+        int last = first + pipeline->nSlots < pipeline->nBlocks ? first + pipeline->nSlots : pipeline->nBlocks;
+        int local = -1, any = -1;
+
+        for (int block = first; block < last && local < 0; ++block)
+        {
+            if (pipeline->claimed[block].load(std::memory_order_relaxed)) continue;
+            if (pipeline->tickets[block % pipeline->nSlots].load(std::memory_order_acquire) != 3LL * block + 1) continue;
+
+            if (pipeline->nodes[block] == node) local = block;
+            if (any < 0) any = block;
+        }
+
+        int block = local >= 0 ? local : any;
+        if (block >= 0)
+        {
+            bool expected = false;
+            if (pipeline->claimed[block].compare_exchange_strong(expected, true)) return block;
+
+            spin = 0; continue;
+        }
+
+        if (spin < 64) std::this_thread::yield(); else std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+
+    return -1;
+}
+
+static void bsc_container_pipeline_worker(bsc_container_pipeline * pipeline, int worker, int nWorkers)
+{
+    bsc_container_numa_binding binding;
+
+    // Scratch is created once the worker is bound, so its buffers are first touched on the node it runs on
+    int             node    = bsc_container_numa_enter(&pipeline->numa, worker, nWorkers, &binding);
+    bsc_context *   scratch = bsc_container_create_scratch(pipeline->params, pipeline->params->features);
+
+    bsc_container_budget_enter(pipeline->budget);
+
+    for (int block = bsc_container_pipeline_next(pipeline, node); block >= 0; block = bsc_container_pipeline_next(pipeline, node))
+    {
+        int slot = block % pipeline->nSlots;
+        if (!bsc_container_pipeline_wait(pipeline, slot, 3LL * block + 1)) break;
+
+        bsc_container_pipeline_compress(pipeline, block, scratch);
+
+        pipeline->tickets[slot].store(3LL * block + 2, std::memory_order_release);
+    }
+
+    bsc_container_destroy_scratch(scratch);
+    bsc_container_numa_leave(&binding);
+}
+
+static void bsc_container_pipeline_writer(bsc_container_pipeline * pipeline)
+{
+    for (int block = 0; block < pipeline->nBlocks; ++block)
+    {
+        int slot = block % pipeline->nSlots;
+        if (!bsc_container_pipeline_wait(pipeline, slot, 3LL * block + 2)) return;
+
+        int result = bsc_container_pipeline_store(pipeline, block);
+        if (result != LIBBSC_NO_ERROR) { bsc_container_pipeline_fail(pipeline, result); return; }
+
+        pipeline->tickets[slot].store(3LL * (block + pipeline->nSlots), std::memory_order_release);
+    }
+}
+
+#define LIBBSC_CONTAINER_MAX_SEGMENTS   256
+
+/**
+* Plans content-aware blocks over an input held in memory. The input is cut in windows of blockSize bytes, segments
+* are detected in every window in parallel, then segments are merged into blocks of minBlockSize to blockSize bytes
+* that end at a content change whenever possible. Window edges are not content changes, a segment running across
+* one is merged with the segment that continues it.
+* @param offsets    - receives nBlocks + 1 offsets of the blocks in the input, the last one is n. Free with bsc_container_free.
+* @return LIBBSC_NO_ERROR if no error occurred, error code otherwise.
+*/
+static int bsc_container_plan_blocks(const unsigned char * input, long long n, const bsc_container_params * params, long long ** offsets, int * nBlocks)
+{
+    long long   maxBlockSize    = params->blockSize;
+    long long   minBlockSize    = params->minBlockSize < params->blockSize ? params->minBlockSize : params->blockSize;
+    long long   nWindows64      = (n + maxBlockSize - 1) / maxBlockSize;
+    long long   maxBlocks       = n / minBlockSize + 1;
+
+    if (nWindows64 > 0x7fffffff || maxBlocks >= 0x7fffffff)
+    {
+        return LIBBSC_BAD_PARAMETER;
+    }
+
+    int     nWindows    = (int)nWindows64;
+    int *   segments    = (int *)bsc_container_malloc(params, (size_t)nWindows * LIBBSC_CONTAINER_MAX_SEGMENTS * sizeof(int));
+    int *   nSegments   = (int *)bsc_container_malloc(params, (size_t)nWindows * sizeof(int));
+
+    *offsets = (long long *)bsc_container_malloc(params, (size_t)(maxBlocks + 1) * sizeof(long long));
+    if (segments == NULL || nSegments == NULL || *offsets == NULL)
+    {
+        bsc_container_free(params, segments); bsc_container_free(params, nSegments); bsc_container_free(params, *offsets); *offsets = NULL;
+        return LIBBSC_NOT_ENOUGH_MEMORY;
+    }
+
+#ifdef LIBBSC_OPENMP
+
+    int numThreads = bsc_container_num_threads(params->numThreads, nWindows);
+
+    #pragma omp parallel num_threads(numThreads) if(numThreads > 1)
+
+#endif
+
+    {
+        bsc_context * scratch = bsc_container_create_scratch(params, params->features);
+
+#ifdef LIBBSC_OPENMP
+        #pragma omp for schedule(dynamic, 1)
+#endif
+        for (int window = 0; window < nWindows; ++window)
+        {
+            long long   windowOffset    = (long long)window * maxBlockSize;
+            int         windowSize      = (int)(n - windowOffset < maxBlockSize ? n - windowOffset : maxBlockSize);
+
+            nSegments[window] = bsc_context_detect_segments(scratch, input + windowOffset, windowSize, segments + (size_t)window * LIBBSC_CONTAINER_MAX_SEGMENTS, LIBBSC_CONTAINER_MAX_SEGMENTS, params->features);
+        }
+
+        bsc_container_destroy_scratch(scratch);
+    }
+
+    int result = LIBBSC_NO_ERROR;
+
+    long long blockOffset = 0, blockSize = 0; *nBlocks = 0;
+    for (int window = 0; window < nWindows && result == LIBBSC_NO_ERROR; ++window)
+    {
+        if (nSegments[window] < LIBBSC_NO_ERROR) { result = nSegments[window]; break; }
+
+        for (int segment = 0; segment < nSegments[window]; ++segment)
+        {
+            long long   length      = segments[(size_t)window * LIBBSC_CONTAINER_MAX_SEGMENTS + segment];
+            bool        last        = window + 1 == nWindows && segment + 1 == nSegments[window];
+            bool        boundary    = segment + 1 < nSegments[window] || last;
+
+            // A block that cannot take the whole segment is filled up to the maximum size and cut there
+            while (blockSize + length > maxBlockSize)
+            {
+                length -= maxBlockSize - blockSize;
+
+                (*offsets)[(*nBlocks)++] = blockOffset; blockOffset += maxBlockSize; blockSize = 0;
+            }
+
+            blockSize += length;
+            if (blockSize > 0 && boundary && (blockSize >= minBlockSize || last))
+            {
+                (*offsets)[(*nBlocks)++] = blockOffset; blockOffset += blockSize; blockSize = 0;
+            }
+        }
+    }
+
+    (*offsets)[*nBlocks] = n;
+
+    bsc_container_free(params, nSegments); bsc_container_free(params, segments);
+
+    if (result == LIBBSC_NO_ERROR && blockOffset != n)
+    {
+        result = LIBBSC_DATA_CORRUPT;
+    }
+
+    if (result != LIBBSC_NO_ERROR)
+    {
+        bsc_container_free(params, *offsets); *offsets = NULL;
+    }
+
+    return result;
+}
+
+#define LIBBSC_CONTAINER_CDC_WINDOW    64
+
+/**
+* Fills the Gear table of the rolling hash from a fixed splitmix64 sequence.
+* The table is part of the format in effect: other values would cut elsewhere and defeat incremental reuse.
+*/
+static void bsc_container_gear_init(unsigned long long * gear)
+{
+    unsigned long long seed = 0x62736367656172ULL;
+    for (int symbol = 0; symbol < ALPHABET_SIZE; ++symbol)
+    {
+        unsigned long long z = (seed += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        gear[symbol] = z ^ (z >> 31);
+    }
+}
+
+/**
+* Finds the next cut of content-defined chunking in data, a Gear rolling hash over the last 64 bytes is tested
+* from minSize on, against a strict mask up to the average size and a loose one after it (normalized chunking),
+* which keeps most block sizes close to the average.
+* @return the length of the block starting at data.
+*/
+static long long bsc_container_find_cut(const unsigned char * data, long long n, long long minSize, long long averageSize, long long maxSize, const unsigned long long * gear, unsigned long long strictMask, unsigned long long looseMask)
+{
+    if (n <= minSize)
+    {
+        return n;
+    }
+
+    long long end       = n < maxSize ? n : maxSize;
+    long long normal    = averageSize < end ? averageSize : end;
+
+    // Shifted out bits are lost, so the hash at any position only depends on the 64 bytes ending there
+    unsigned long long hash = 0;
+    for (long long i = minSize - LIBBSC_CONTAINER_CDC_WINDOW; i < minSize; ++i)
+    {
+        hash = (hash << 1) + gear[data[i]];
+    }
+
+    for (long long i = minSize; i < normal; ++i)
+    {
+        hash = (hash << 1) + gear[data[i]];
+        if ((hash & strictMask) == 0) return i + 1;
+    }
+
+    for (long long i = normal; i < end; ++i)
+    {
+        hash = (hash << 1) + gear[data[i]];
+        if ((hash & looseMask) == 0) return i + 1;
+    }
+
+    return end;
+}
+
+/**
+* Plans content-defined blocks over an input held in memory, between cdcBlockSize / 4 and min(8 * cdcBlockSize,
+* blockSize) bytes. A cut only depends on the bytes right before it, so an insertion or a deletion in the input
+* moves the cuts around the edit and the following blocks come out the same as before it.
+* @param offsets    - receives nBlocks + 1 offsets of the blocks in the input, the last one is n. Free with bsc_container_free.
+* @return LIBBSC_NO_ERROR if no error occurred, error code otherwise.
+*/
+static int bsc_container_plan_chunks(const unsigned char * input, long long n, const bsc_container_params * params, long long ** offsets, int * nBlocks)
+{
+    long long   averageSize = params->cdcBlockSize;
+    long long   minSize     = averageSize / 4;
+    long long   maxSize     = 8 * averageSize < params->blockSize ? 8 * averageSize : params->blockSize;
+    long long   maxBlocks   = n / minSize + 1;
+
+    if (maxBlocks >= 0x7fffffff)
+    {
+        return LIBBSC_BAD_PARAMETER;
+    }
+
+    *offsets = (long long *)bsc_container_malloc(params, (size_t)(maxBlocks + 1) * sizeof(long long));
+    if (*offsets == NULL)
+    {
+        return LIBBSC_NOT_ENOUGH_MEMORY;
+    }
+
+    unsigned long long gear[ALPHABET_SIZE]; bsc_container_gear_init(gear);
+
+    int bits = 0; while ((2LL << bits) <= averageSize) bits++;
+
+    // The high bits of a Gear hash mix the most bytes, so masks test them
+    unsigned long long strictMask  = ~0ULL << (64 - (bits + 2));
+    unsigned long long looseMask   = ~0ULL << (64 - (bits - 2));
+
+    long long blockOffset = 0; *nBlocks = 0;
+    while (blockOffset < n)
+    {
+        (*offsets)[(*nBlocks)++] = blockOffset;
+        blockOffset += bsc_container_find_cut(input + blockOffset, n - blockOffset, minSize, averageSize, maxSize, gear, strictMask, looseMask);
+    }
+
+    (*offsets)[*nBlocks] = n;
+
+    return LIBBSC_NO_ERROR;
+}
+
+#define LIBBSC_CONTAINER_LONG_ANCHOR_BITS   12
+#define LIBBSC_CONTAINER_LONG_MIN_HASH_BITS 10
+#define LIBBSC_CONTAINER_LONG_MAX_HASH_BITS 24
+
+typedef struct bsc_container_long_match
+{
+    long long   target;
+    long long   source;
+    long long   length;
+} bsc_container_long_match;
+
+/**
+* Finds the last of n sorted offsets that is not above position.
+* @return its index, -1 if every offset is above position.
+*/
+static int bsc_container_find_offset(const long long * offsets, int n, long long position)
+{
+    int low = 0, high = n;
+    while (low < high)
+    {
+        int middle = low + (high - low) / 2;
+        if (offsets[middle] <= position) low = middle + 1; else high = middle;
+    }
+
+    return low - 1;
+}
+
+/**
+* Same as @ref bsc_container_find_offset over the targets of the long-range matches.
+*/
+static int bsc_container_find_long_match(const bsc_container_long_match * matches, int n, long long position)
+{
+    int low = 0, high = n;
+    while (low < high)
+    {
+        int middle = low + (high - low) / 2;
+        if (matches[middle].target <= position) low = middle + 1; else high = middle;
+    }
+
+    return low - 1;
+}
+
+/**
+* Counts the leading bytes equal in left and right, up to n, comparing eight bytes at a time.
+*/
+static long long bsc_container_common_length(const unsigned char * left, const unsigned char * right, long long n)
+{
+    long long length = 0;
+    for (; length + 8 <= n; length += 8)
+    {
+        unsigned long long l, r; memcpy(&l, left + length, 8); memcpy(&r, right + length, 8);
+        if (l != r) break;
+    }
+
+    while (length < n && left[length] == right[length]) length++;
+
+    return length;
+}
+
+/**
+* Finds repeats of LIBBSC_CONTAINER_LONG_MIN_MATCH bytes or more over a whole input held in memory and cuts each of
+* them into a block of its own, written as a reference to its earlier occurrence. Anchors are the positions where a
+* Gear hash of the last 64 bytes has its top 12 bits clear, about one every 4KB whatever the alignment of the data,
+* plus the start of every planned block, and a direct-mapped table keeps the last position of every anchor hash. A match is verified and extended both ways
+* byte for byte, so a hash collision only costs a missed match. Its source stays inside one planned block and out of
+* every other match, so a decoder copies a reference from a single decoded block.
+* @param offsets    - the planned blocks, NULL for fixed-size ones, receives the blocks cut around the matches.
+* @param nBlocks    - the number of planned blocks, receives the number of blocks after cutting.
+* @param sources    - receives for every block the offset in the input of its source, -1 for a block compressed normally.
+* @param flags      - receives LIBBSC_CONTAINER_BLOCK_REFERENCED for source blocks and LIBBSC_CONTAINER_REFERENCE_LAST
+*                     for the last reference to each of them.
+* @param version    - receives 3 if a source is not a whole block, 2 otherwise.
+* @return the number of references if no error occurred, error code otherwise.
+*/
+static int bsc_container_plan_long_range(const unsigned char * input, long long n, const bsc_container_params * params, long long ** offsets, int * nBlocks, long long ** sources, unsigned char ** flags, int * version)
+{
+    long long * blocks = *offsets; int nPlanned = *nBlocks;
+    if (blocks == NULL)
+    {
+        blocks = (long long *)bsc_container_malloc(params, (size_t)(nPlanned + 1) * sizeof(long long));
+        if (blocks == NULL)
+        {
+            return LIBBSC_NOT_ENOUGH_MEMORY;
+        }
+
+        for (int block = 0; block < nPlanned; ++block) blocks[block] = (long long)block * params->blockSize;
+        blocks[nPlanned] = n;
+    }
+
+    // About two slots per anchor, positions are stored plus one so a zeroed slot is empty
+    int bits = LIBBSC_CONTAINER_LONG_MIN_HASH_BITS;
+    while (bits < LIBBSC_CONTAINER_LONG_MAX_HASH_BITS && (1LL << (bits + LIBBSC_CONTAINER_LONG_ANCHOR_BITS - 1)) < n) bits++;
+
+    long long maxMatches = n / LIBBSC_CONTAINER_LONG_MIN_MATCH + 1;
+
+    long long *                 table   = (long long *)bsc_container_zero_malloc(params, sizeof(long long) << bits);
+    bsc_container_long_match *  matches = (bsc_container_long_match *)bsc_container_malloc(params, (size_t)maxMatches * sizeof(bsc_container_long_match));
+    if (table == NULL || matches == NULL)
+    {
+        bsc_container_free(params, matches); bsc_container_free(params, table); if (blocks != *offsets) bsc_container_free(params, blocks);
+        return LIBBSC_NOT_ENOUGH_MEMORY;
+    }
+
+    unsigned long long gear[ALPHABET_SIZE]; bsc_container_gear_init(gear);
+    unsigned long long anchorMask = ~0ULL << (64 - LIBBSC_CONTAINER_LONG_ANCHOR_BITS);
+
+    int nMatches = 0, nextBlock = 0; long long covered = 0; unsigned long long hash = 0;
+    for (long long i = 0; i < n; ++i)
+    {
+        hash = (hash << 1) + gear[input[i]];
+
+        // The first window of every planned block is an anchor too, so repeated blocks are found whatever their
+        // content, runs of a single byte included
+        while (nextBlock < nPlanned && blocks[nextBlock] + LIBBSC_CONTAINER_CDC_WINDOW - 1 < i) nextBlock++;
+
+        bool boundary = nextBlock < nPlanned && blocks[nextBlock] + LIBBSC_CONTAINER_CDC_WINDOW - 1 == i;
+        if ((hash & anchorMask) != 0 && !boundary) continue;
+
+        size_t      slot        = (size_t)(bsc_container_fmix64(hash) >> (64 - bits));
+        long long   candidate   = table[slot] - 1;
+        long long   back        = 0;
+        long long   length      = 0;
+
+        int match = candidate >= 0 ? bsc_container_find_long_match(matches, nMatches, candidate) : -1;
+        if (candidate >= 0 && (match < 0 || candidate >= matches[match].target + matches[match].length))
+        {
+            // The source must not leave its planned block nor run into a match, whose data is not in the container
+            int         block   = bsc_container_find_offset(blocks, nPlanned, candidate);
+            long long   low     = match >= 0 && matches[match].target + matches[match].length > blocks[block] ? matches[match].target + matches[match].length : blocks[block];
+            long long   high    = match + 1 < nMatches && matches[match + 1].target < blocks[block + 1] ? matches[match + 1].target : blocks[block + 1];
+
+            while (candidate - back >= low && i - back >= covered && input[candidate - back] == input[i - back]) back++;
+
+            if (back > 0)
+            {
+                long long forward = high - candidate - 1 < n - i - 1 ? high - candidate - 1 : n - i - 1;
+
+                length = back + bsc_container_common_length(input + candidate + 1, input + i + 1, forward);
+
+                // The source ends where the match starts at the latest, the decoder has it by then
+                if (length > i - candidate) length = i - candidate;
+            }
+        }
+
+        if (length < LIBBSC_CONTAINER_LONG_MIN_MATCH)
+        {
+            table[slot] = i + 1;
+            continue;
+        }
+
+        matches[nMatches].target = i - back + 1;
+        matches[nMatches].source = candidate - back + 1;
+        matches[nMatches].length = length;
+
+        covered = matches[nMatches++].target + length;
+
+        // Resume right after the match, with the hash of the 64 bytes before it
+        hash = 0; i = covered - 1;
+        for (long long k = covered > LIBBSC_CONTAINER_CDC_WINDOW ? covered - LIBBSC_CONTAINER_CDC_WINDOW : 0; k < covered; ++k)
+        {
+            hash = (hash << 1) + gear[input[k]];
+        }
+    }
+
+    bsc_container_free(params, table);
+
+    // Every match adds its own block and splits at most one planned block in two
+    long long maxBlocks = nPlanned + 2LL * nMatches;
+
+    long long *     pieces      = maxBlocks < 0x7fffffff ? (long long *)bsc_container_malloc(params, (size_t)(maxBlocks + 1) * sizeof(long long)) : NULL;
+    long long *     pieceSource = pieces != NULL ? (long long *)bsc_container_malloc(params, (size_t)maxBlocks * sizeof(long long)) : NULL;
+    unsigned char * pieceFlags  = pieceSource != NULL ? (unsigned char *)bsc_container_zero_malloc(params, (size_t)maxBlocks * sizeof(unsigned char)) : NULL;
+    if (pieceFlags == NULL)
+    {
+        bsc_container_free(params, pieceSource); bsc_container_free(params, pieces); bsc_container_free(params, matches); if (blocks != *offsets) bsc_container_free(params, blocks);
+        return maxBlocks < 0x7fffffff ? LIBBSC_NOT_ENOUGH_MEMORY : LIBBSC_BAD_PARAMETER;
+    }
+
+    int nPieces = 0, block = 0, match = 0;
+    for (long long position = 0; position < n; ++nPieces)
+    {
+        pieces[nPieces] = position;
+        if (match < nMatches && matches[match].target == position)
+        {
+            pieceSource[nPieces] = matches[match].source; position += matches[match++].length;
+            continue;
+        }
+
+        while (blocks[block + 1] <= position) block++;
+
+        pieceSource[nPieces] = -1;
+        position = match < nMatches && matches[match].target < blocks[block + 1] ? matches[match].target : blocks[block + 1];
+    }
+
+    pieces[nPieces] = n;
+
+    // Walking backwards, the first reference met for a source is its last one in the container
+    *version = 2;
+    for (int piece = nPieces - 1; piece >= 0; --piece)
+    {
+        if (pieceSource[piece] < 0) continue;
+
+        int source = bsc_container_find_offset(pieces, nPieces, pieceSource[piece]);
+        if ((pieceFlags[source] & LIBBSC_CONTAINER_BLOCK_REFERENCED) == 0)
+        {
+            pieceFlags[source] |= LIBBSC_CONTAINER_BLOCK_REFERENCED;
+            pieceFlags[piece]  |= LIBBSC_CONTAINER_REFERENCE_LAST;
+        }
+
+        if (pieces[source] != pieceSource[piece] || pieces[source + 1] - pieces[source] != pieces[piece + 1] - pieces[piece])
+        {
+            *version = 3;
+        }
+    }
+
+    bsc_container_free(params, matches); bsc_container_free(params, blocks);
+
+    *offsets = pieces; *nBlocks = nPieces; *sources = pieceSource; *flags = pieceFlags;
+
+    return nMatches;
+}
+
+typedef struct bsc_container_block_hash
+{
+    unsigned long long  hash[2];
+    int                 size;
+    int                 block;
+} bsc_container_block_hash;
+
+static int bsc_container_compare_hash_keys(const void * left, const void * right)
+{
+    const bsc_container_block_hash * l = (const bsc_container_block_hash *)left;
+    const bsc_container_block_hash * r = (const bsc_container_block_hash *)right;
+
+    if (l->hash[0] != r->hash[0]) return l->hash[0] < r->hash[0] ? -1 : 1;
+    if (l->hash[1] != r->hash[1]) return l->hash[1] < r->hash[1] ? -1 : 1;
+
+    return l->size < r->size ? -1 : (l->size > r->size ? 1 : 0);
+}
+
+static int bsc_container_compare_hashes(const void * left, const void * right)
+{
+    int result = bsc_container_compare_hash_keys(left, right);
+    if (result != 0) return result;
+
+    int l = ((const bsc_container_block_hash *)left)->block, r = ((const bsc_container_block_hash *)right)->block;
+
+    return l < r ? -1 : (l > r ? 1 : 0);
+}
+
+/**
+* Hashes every block of an input held in memory in parallel, two 64-bit words per block.
+*/
+static void bsc_container_hash_blocks(const bsc_container_pipeline * pipeline, unsigned long long * hashes)
+{
+
+#ifdef LIBBSC_OPENMP
+
+    int numThreads = bsc_container_num_threads(pipeline->params->numThreads, pipeline->nBlocks);
+
+    #pragma omp parallel for schedule(dynamic, 1) num_threads(numThreads) if(numThreads > 1)
+
+#endif
+
+    for (int block = 0; block < pipeline->nBlocks; ++block)
+    {
+        bsc_container_hash128(pipeline->input + bsc_container_pipeline_offset(pipeline, block), bsc_container_pipeline_size(pipeline, block), hashes + 2 * (size_t)block);
+    }
+}
+
+/**
+* Finds the blocks of an input held in memory that repeat an earlier block. Block hashes are sorted, every candidate is then compared byte for byte with the first block of its run, so a hash collision can
+* only cost a missed reference, never a wrong one.
+* @param sources    - receives for every block the offset in the input of its first occurrence, -1 for a block compressed normally.
+* @param flags      - receives LIBBSC_CONTAINER_BLOCK_REFERENCED for first occurrences and LIBBSC_CONTAINER_REFERENCE_LAST
+*                     for the last reference to each of them.
+* @return the number of references if no error occurred, error code otherwise.
+*/
+static int bsc_container_plan_references(const bsc_container_pipeline * pipeline, long long * sources, unsigned char * flags)
+{
+    int nBlocks = pipeline->nBlocks;
+
+    bsc_container_block_hash * hashes = (bsc_container_block_hash *)bsc_container_malloc(pipeline->params, (size_t)nBlocks * sizeof(bsc_container_block_hash));
+    if (hashes == NULL)
+    {
+        return LIBBSC_NOT_ENOUGH_MEMORY;
+    }
+
+    for (int block = 0; block < nBlocks; ++block)
+    {
+        hashes[block].hash[0]   = pipeline->hashes[2 * (size_t)block + 0];
+        hashes[block].hash[1]   = pipeline->hashes[2 * (size_t)block + 1];
+        hashes[block].size      = bsc_container_pipeline_size(pipeline, block);
+        hashes[block].block     = block;
+    }
+
+    qsort(hashes, nBlocks, sizeof(bsc_container_block_hash), bsc_container_compare_hashes);
+
+    for (int block = 0; block < nBlocks; ++block) { sources[block] = -1; flags[block] = 0; }
+
+    int nReferences = 0;
+    for (int first = 0, next = 1; first < nBlocks; first = next++)
+    {
+        const bsc_container_block_hash * source = &hashes[first];
+        const unsigned char *            data   = pipeline->input + bsc_container_pipeline_offset(pipeline, source->block);
+
+        int last = -1;
+        for (; next < nBlocks && hashes[next].hash[0] == source->hash[0] && hashes[next].hash[1] == source->hash[1] && hashes[next].size == source->size; ++next)
+        {
+            int block = hashes[next].block;
+            if (memcmp(pipeline->input + bsc_container_pipeline_offset(pipeline, block), data, source->size) == 0)
+            {
+                sources[block] = bsc_container_pipeline_offset(pipeline, source->block); last = block; nReferences++;
+            }
+        }
+
+        // Runs are sorted by block, so the last match in the run is also the last reference in the container
+        if (last >= 0)
+        {
+            flags[source->block] = LIBBSC_CONTAINER_BLOCK_REFERENCED;
+            flags[last]          = LIBBSC_CONTAINER_REFERENCE_LAST;
+        }
+    }
+
+    bsc_container_free(pipeline->params, hashes);
+
+    return nReferences;
+}
+
+/**
+* Finds the blocks of an input held in memory that the previous container already holds, by hash and size as the
+* data of the previous version is not at hand. MurmurHash3 is not collision resistant: a previous container must
+* not come from someone who could craft inputs against the data being compressed. Only whole blocks of the previous
+* container are candidates, a reference to a range of a larger block is skipped.
+* @param previousHashes - the hashes of the nPrevious blocks of the previous container, in container order.
+* @param reuse          - receives for every block the index of its entry in the previous table, -1 to compress it.
+* @return the number of reused blocks if no error occurred, error code otherwise.
+*/
+static int bsc_container_plan_reuse(const bsc_container_pipeline * pipeline, const bsc_container_index_entry * previousIndex, const unsigned char * previousHashes, int nPrevious, int * reuse)
+{
+    bsc_container_block_hash * hashes = (bsc_container_block_hash *)bsc_container_malloc(pipeline->params, (size_t)nPrevious * sizeof(bsc_container_block_hash));
+    if (hashes == NULL)
+    {
+        return LIBBSC_NOT_ENOUGH_MEMORY;
+    }
+
+    // A long-range reference repeats a range of its source block, whose compressed bytes hold more than that range
+    int nCandidates = 0;
+    for (int block = 0; block < nPrevious; ++block)
+    {
+        const bsc_container_index_entry * entry = &previousIndex[block];
+        if (entry->sourceOffset != entry->sourceBlock || entry->sourceSize != entry->dataSize) continue;
+
+        memcpy(hashes[nCandidates].hash, previousHashes + (size_t)block * LIBBSC_CONTAINER_HASH_ENTRY_SIZE, LIBBSC_CONTAINER_HASH_ENTRY_SIZE);
+        hashes[nCandidates].size  = entry->dataSize;
+        hashes[nCandidates].block = block;
+        nCandidates++;
+    }
+
+    qsort(hashes, nCandidates, sizeof(bsc_container_block_hash), bsc_container_compare_hashes);
+
+    int nReused = 0;
+    for (int block = 0; block < pipeline->nBlocks; ++block)
+    {
+        reuse[block] = -1;
+        if (pipeline->sources != NULL && pipeline->sources[block] >= 0) continue;
+
+        bsc_container_block_hash key;
+
+        key.hash[0] = pipeline->hashes[2 * (size_t)block + 0];
+        key.hash[1] = pipeline->hashes[2 * (size_t)block + 1];
+        key.size    = bsc_container_pipeline_size(pipeline, block);
+        key.block   = 0;
+
+        const bsc_container_block_hash * found = (const bsc_container_block_hash *)bsearch(&key, hashes, nCandidates, sizeof(bsc_container_block_hash), bsc_container_compare_hash_keys);
+        if (found != NULL)
+        {
+            reuse[block] = found->block; nReused++;
+        }
+    }
+
+    bsc_container_free(pipeline->params, hashes);
+
+    return nReused;
+}
+
+// Defined with the index readers below
+static int bsc_container_load_previous(const unsigned char * previous, long long previousSize, int features, bsc_container_index_entry ** index, const unsigned char ** hashes, int * nBlocks);
+
+/**
+* Compresses n bytes, taken from input memory when read is NULL or pulled from the read callback otherwise,
+* with one reader, one writer and numThreads compressor threads overlapping I/O with compression.
+*/
+static int bsc_container_compress_pipeline(bsc_container_read_fn read, void * readContext, const unsigned char * input, long long n, const bsc_container_params * params, bsc_container_write_fn write, void * writeContext)
+{
+    if (n <= 0 || params == NULL || write == NULL || params->blockSize <= 0)
+    {
+        return LIBBSC_BAD_PARAMETER;
+    }
+
+    if (params->recordSize < 0 || params->recordSize > LIBBSC_CONTAINER_MAX_RECORDSIZE)
+    {
+        return LIBBSC_BAD_PARAMETER;
+    }
+
+    if (params->sortingContexts != LIBBSC_CONTEXTS_FOLLOWING && params->sortingContexts != LIBBSC_CONTEXTS_PRECEDING && params->sortingContexts != LIBBSC_CONTAINER_CONTEXTS_AUTODETECT)
+    {
+        return LIBBSC_BAD_PARAMETER;
+    }
+
+    if (params->minBlockSize < 0 || params->cdcBlockSize < 0)
+    {
+        return LIBBSC_BAD_PARAMETER;
+    }
+
+    if (params->cdcBlockSize > 0 && (params->cdcBlockSize < LIBBSC_CONTAINER_MIN_CDCBLOCKSIZE || params->cdcBlockSize > params->blockSize || params->minBlockSize > 0))
+    {
+        return LIBBSC_BAD_PARAMETER;
+    }
+
+    if (params->previous != NULL && params->previousSize <= 0)
+    {
+        return LIBBSC_BAD_PARAMETER;
+    }
+
+    if ((params->malloc == NULL) != (params->free == NULL))
+    {
+        return LIBBSC_BAD_PARAMETER;
+    }
+
+#ifndef LIBBSC_CONTEXT_SUPPORT
+
+    // Without contexts the allocator could not reach the core, silently using bsc_malloc would break memory limits
+    if (params->malloc != NULL)
+    {
+        return LIBBSC_NOT_SUPPORTED;
+    }
+
+#endif
+
+    long long nBlocks64 = (n + params->blockSize - 1) / params->blockSize;
+    if (nBlocks64 > 0x7fffffff)
+    {
+        return LIBBSC_BAD_PARAMETER;
+    }
+
+    bsc_container_pipeline pipeline;
+
+    pipeline.offsets        = NULL;
+    pipeline.sources        = NULL;
+    pipeline.flags          = NULL;
+    pipeline.hashes         = NULL;
+    pipeline.reuse          = NULL;
+    pipeline.previousIndex  = NULL;
+    pipeline.nodes          = NULL;
+    pipeline.claimed        = NULL;
+
+    // Only an input held in memory can be planned, the block count of a stream is written before it is read
+    if (read == NULL && (params->minBlockSize > 0 || params->cdcBlockSize > 0))
+    {
+        long long * offsets = NULL; int nBlocks = 0;
+
+        int result = params->cdcBlockSize > 0
+            ? bsc_container_plan_chunks(input, n, params, &offsets, &nBlocks)
+            : bsc_container_plan_blocks(input, n, params, &offsets, &nBlocks);
+        if (result != LIBBSC_NO_ERROR)
+        {
+            return result;
+        }
+
+        pipeline.offsets = offsets; nBlocks64 = nBlocks;
+    }
+
+    // Long-range matches cut the planned blocks further, references need every block upfront and only a container
+    // that holds some is signed with a new version
+    int version = 1;
+    if (read == NULL && params->longRange)
+    {
+        long long * offsets = pipeline.offsets; int nBlocks = (int)nBlocks64;
+
+        int nReferences = bsc_container_plan_long_range(input, n, params, &offsets, &nBlocks, &pipeline.sources, &pipeline.flags, &version);
+        if (nReferences < LIBBSC_NO_ERROR)
+        {
+            bsc_container_free(params, pipeline.offsets);
+            return nReferences;
+        }
+
+        if (nReferences == 0) version = 1;
+
+        pipeline.offsets = offsets; nBlocks64 = nBlocks;
+    }
+
+    bsc_container_budget budget;
+    bsc_container_budget_init(&budget, params->numThreads, (int)nBlocks64, params->features, true);
+
+    // Blocks are compressed with the features of the budget, every other parameter is the caller's
+    bsc_container_params blockParams = *params; blockParams.features = budget.features;
+
+    pipeline.read           = read;
+    pipeline.readContext    = readContext;
+    pipeline.input          = input;
+    pipeline.n              = n;
+    pipeline.params         = &blockParams;
+    pipeline.budget         = &budget;
+    pipeline.write          = write;
+    pipeline.writeContext   = writeContext;
+    pipeline.nBlocks        = (int)nBlocks64;
+    pipeline.inputSize      = read != NULL ? (int)(n < params->blockSize ? n : params->blockSize) : 0;
+    pipeline.arenaSize      = LIBBSC_CONTAINER_BLOCK_HEADER_SIZE + (int)(n < params->blockSize ? n : params->blockSize) + LIBBSC_HEADER_SIZE;
+    pipeline.index          = NULL;
+    pipeline.position       = LIBBSC_CONTAINER_HEADER_SIZE;
+    memset(&pipeline.stats, 0, sizeof(pipeline.stats));
+    pipeline.nextBlock      = 0;
+    pipeline.result         = LIBBSC_NO_ERROR;
+
+    int numThreads = budget.outer;
+
+    // Every compressor can hold a block while the reader prepares the next one and the writer drains the previous one
+    pipeline.nSlots         = numThreads + 2 < pipeline.nBlocks ? numThreads + 2 : pipeline.nBlocks;
+    pipeline.buffers        = (unsigned char **)bsc_container_malloc(params, pipeline.nSlots * sizeof(unsigned char *));
+    pipeline.results        = (int *)bsc_container_malloc(params, pipeline.nSlots * sizeof(int));
+    pipeline.skipped        = (bool *)bsc_container_malloc(params, pipeline.nSlots * sizeof(bool));
+    pipeline.tickets        = new (std::nothrow) std::atomic<long long>[pipeline.nSlots];
+
+    // Blocks of an input held in memory go to the workers of the node their pages sit on
+    bsc_container_numa_init(&pipeline.numa, read == NULL ? numThreads : 1);
+    if (pipeline.numa.nNodes > 1)
+    {
+        pipeline.nodes      = (int *)bsc_container_malloc(params, (size_t)pipeline.nBlocks * sizeof(int));
+        pipeline.claimed    = pipeline.nodes != NULL ? new (std::nothrow) std::atomic<bool>[pipeline.nBlocks] : NULL;
+
+        if (pipeline.claimed != NULL)
+        {
+            for (int block = 0; block < pipeline.nBlocks; ++block)
+            {
+                pipeline.nodes[block] = bsc_container_numa_locate(&pipeline.numa, input + bsc_container_pipeline_offset(&pipeline, block), bsc_container_pipeline_size(&pipeline, block));
+                pipeline.claimed[block].store(false);
+            }
+        }
+    }
+
+    int result = pipeline.buffers != NULL && pipeline.results != NULL && pipeline.skipped != NULL && pipeline.tickets != NULL ? LIBBSC_NO_ERROR : LIBBSC_NOT_ENOUGH_MEMORY;
+    if (result == LIBBSC_NO_ERROR)
+    {
+        memset(pipeline.buffers, 0, pipeline.nSlots * sizeof(unsigned char *));
+        for (int slot = 0; slot < pipeline.nSlots; ++slot)
+        {
+            pipeline.tickets[slot].store(3LL * slot);
+            pipeline.buffers[slot] = (unsigned char *)bsc_container_malloc(params, (size_t)pipeline.inputSize + pipeline.arenaSize);
+            if (pipeline.buffers[slot] == NULL) result = LIBBSC_NOT_ENOUGH_MEMORY;
+        }
+    }
+
+    // An incremental compression always writes the hashes, so its output can be the previous container of the next one
+    bool incremental    = read == NULL && params->previous != NULL;
+    bool deduplicate    = read == NULL && params->deduplicate && !params->longRange && pipeline.nBlocks > 1;
+    int  writeIndex     = incremental ? LIBBSC_CONTAINER_INDEX_HASHES : params->writeIndex;
+
+    if (result == LIBBSC_NO_ERROR && writeIndex)
+    {
+        pipeline.index = (bsc_container_index_entry *)bsc_container_malloc(params, (size_t)pipeline.nBlocks * sizeof(bsc_container_index_entry));
+        if (pipeline.index == NULL) result = LIBBSC_NOT_ENOUGH_MEMORY;
+    }
+
+    if (result == LIBBSC_NO_ERROR && (writeIndex == LIBBSC_CONTAINER_INDEX_HASHES || deduplicate || incremental))
+    {
+        pipeline.hashes = (unsigned long long *)bsc_container_malloc(params, (size_t)pipeline.nBlocks * LIBBSC_CONTAINER_HASH_ENTRY_SIZE);
+        if (pipeline.hashes == NULL) result = LIBBSC_NOT_ENOUGH_MEMORY;
+        if (pipeline.hashes != NULL && read == NULL) bsc_container_hash_blocks(&pipeline, pipeline.hashes);
+    }
+
+    if (result == LIBBSC_NO_ERROR && deduplicate)
+    {
+        pipeline.sources    = (long long *)bsc_container_malloc(params, (size_t)pipeline.nBlocks * sizeof(long long));
+        pipeline.flags      = (unsigned char *)bsc_container_malloc(params, (size_t)pipeline.nBlocks * sizeof(unsigned char));
+
+        int nReferences = pipeline.sources != NULL && pipeline.flags != NULL ? bsc_container_plan_references(&pipeline, pipeline.sources, pipeline.flags) : LIBBSC_NOT_ENOUGH_MEMORY;
+        if (nReferences < LIBBSC_NO_ERROR) result = nReferences;
+        if (nReferences > 0) version = 2;
+    }
+
+    bsc_container_index_entry * previousIndex = NULL;
+    if (result == LIBBSC_NO_ERROR && incremental)
+    {
+        const unsigned char * previousHashes = NULL; int nPrevious = 0;
+
+        result = bsc_container_load_previous(params->previous, params->previousSize, params->features, &previousIndex, &previousHashes, &nPrevious);
+        if (result == LIBBSC_NO_ERROR)
+        {
+            pipeline.reuse          = (int *)bsc_container_malloc(params, (size_t)pipeline.nBlocks * sizeof(int));
+            pipeline.previousIndex  = previousIndex;
+
+            int nReused = pipeline.reuse != NULL ? bsc_container_plan_reuse(&pipeline, previousIndex, previousHashes, nPrevious, pipeline.reuse) : LIBBSC_NOT_ENOUGH_MEMORY;
+            if (nReused < LIBBSC_NO_ERROR) result = nReused;
+        }
+    }
+
+    if (result == LIBBSC_NO_ERROR) result = bsc_container_write_header(pipeline.nBlocks, version, write, writeContext);
+    if (result == LIBBSC_NO_ERROR)
+    {
+        int team = 1, thread = 0;
+
+#ifdef LIBBSC_OPENMP
+
+        #pragma omp parallel num_threads(numThreads + 2) if(numThreads > 1 || pipeline.nBlocks > 1) private(team, thread)
+
+#endif
+
+        {
+
+#ifdef LIBBSC_OPENMP
+
+            team = omp_get_num_threads(); thread = omp_get_thread_num();
+
+#endif
+
+            // The master thread is the calling thread, it keeps the reader role so the read callback never changes thread
+            if (team >= 3)
+            {
+                if (thread == 0) bsc_container_pipeline_reader(&pipeline);
+                if (thread == 1) bsc_container_pipeline_writer(&pipeline);
+                if (thread >= 2) bsc_container_pipeline_worker(&pipeline, thread - 2, team - 2);
+            }
+            else if (thread == 0)
+            {
+                bsc_context * scratch = bsc_container_create_scratch(&blockParams, blockParams.features);
+
+                bsc_container_budget_enter(&budget);
+
+                for (int block = 0; block < pipeline.nBlocks; ++block)
+                {
+                    int blockResult = bsc_container_pipeline_load(&pipeline, block);
+                    if (blockResult == LIBBSC_NO_ERROR)
+                    {
+                        bsc_container_pipeline_compress(&pipeline, block, scratch);
+                        blockResult = bsc_container_pipeline_store(&pipeline, block);
+                    }
+
+                    if (blockResult != LIBBSC_NO_ERROR) { bsc_container_pipeline_fail(&pipeline, blockResult); break; }
+                }
+
+                bsc_container_destroy_scratch(scratch);
+            }
+        }
+
+        result = pipeline.result.load();
+    }
+
+    if (result == LIBBSC_NO_ERROR && writeIndex == LIBBSC_CONTAINER_INDEX_HASHES)
+    {
+        result = bsc_container_write_hashes(pipeline.hashes, pipeline.nBlocks, pipeline.position, write, writeContext);
+
+        pipeline.position += (long long)pipeline.nBlocks * LIBBSC_CONTAINER_HASH_ENTRY_SIZE + LIBBSC_CONTAINER_HASH_TRAILER_SIZE;
+    }
+
+    if (result == LIBBSC_NO_ERROR && pipeline.index != NULL)
+    {
+        result = bsc_container_write_index(pipeline.index, pipeline.nBlocks, pipeline.position, write, writeContext);
+    }
+
+    if (pipeline.buffers != NULL)
+    {
+        for (int slot = 0; slot < pipeline.nSlots; ++slot)
+        {
+            bsc_container_free(params, pipeline.buffers[slot]);
+        }
+    }
+
+    if (params->stats != NULL)
+    {
+        *params->stats = pipeline.stats;
+    }
+
+    bsc_container_free(params, pipeline.index);
+    bsc_container_free(params, pipeline.offsets);
+    bsc_free(previousIndex);
+    bsc_container_free(params, pipeline.reuse);
+    bsc_container_free(params, pipeline.hashes);
+    bsc_container_free(params, pipeline.flags);
+    bsc_container_free(params, pipeline.sources);
+    bsc_container_free(params, pipeline.skipped);
+    bsc_container_free(params, pipeline.results);
+    bsc_container_free(params, pipeline.buffers);
+    bsc_container_free(params, pipeline.nodes);
+    delete[] pipeline.tickets;
+    delete[] pipeline.claimed;
+
+    bsc_container_budget_done(&budget);
+
+    return result;
+}
+
+long long bsc_container_compress_bound(long long n, const bsc_container_params * params)
+{
+    if (n <= 0 || params == NULL || params->blockSize <= 0)
+    {
+        return LIBBSC_BAD_PARAMETER;
+    }
+
+    if (params->cdcBlockSize > 0 && params->cdcBlockSize < LIBBSC_CONTAINER_MIN_CDCBLOCKSIZE)
+    {
+        return LIBBSC_BAD_PARAMETER;
+    }
+
+    // Content-aware blocks are at least minBlockSize bytes long and content-defined ones cdcBlockSize / 4, except the last one
+    long long nBlocks   = params->cdcBlockSize > 0
+        ? n / (params->cdcBlockSize / 4) + 1
+        : params->minBlockSize > 0
+        ? n / (params->minBlockSize < params->blockSize ? params->minBlockSize : params->blockSize) + 1
+        : (n + params->blockSize - 1) / params->blockSize;
+
+    // Every long-range match is a block of its own and splits at most one other block in two
+    if (params->longRange)
+    {
+        nBlocks += 2 * (n / LIBBSC_CONTAINER_LONG_MIN_MATCH + 1);
+    }
+
+    long long bound     = LIBBSC_CONTAINER_HEADER_SIZE + n + nBlocks * (LIBBSC_CONTAINER_BLOCK_HEADER_SIZE + LIBBSC_HEADER_SIZE);
+    if (params->writeIndex || params->previous != NULL)
+    {
+        bound += nBlocks * LIBBSC_CONTAINER_INDEX_ENTRY_SIZE + LIBBSC_CONTAINER_INDEX_TRAILER_SIZE;
+    }
+
+    if (params->writeIndex == LIBBSC_CONTAINER_INDEX_HASHES || params->previous != NULL)
+    {
+        bound += nBlocks * LIBBSC_CONTAINER_HASH_ENTRY_SIZE + LIBBSC_CONTAINER_HASH_TRAILER_SIZE;
+    }
+
+    return bound;
+}
+
+int bsc_container_compress(const unsigned char * input, long long n, const bsc_container_params * params, bsc_container_write_fn write, void * context)
+{
+    if (input == NULL)
+    {
+        return LIBBSC_BAD_PARAMETER;
+    }
+
+    return bsc_container_compress_pipeline(NULL, NULL, input, n, params, write, context);
+}
+
+int bsc_container_compress_stream(bsc_container_read_fn read, void * readContext, long long n, const bsc_container_params * params, bsc_container_write_fn write, void * writeContext)
+{
+    if (read == NULL)
+    {
+        return LIBBSC_BAD_PARAMETER;
+    }
+
+    return bsc_container_compress_pipeline(read, readContext, NULL, n, params, write, writeContext);
+}
+
+/**
+* Decodes one container block and undoes the filters recorded in its block header.
+* @param input      - the compressed block of blockSize bytes.
+* @param buffer     - the output of dataSize bytes, may be the same memory as input if large enough.
+* @param scratch    - the scratch memory of the calling thread, can be NULL.
+* @return LIBBSC_NO_ERROR if no error occurred, error code otherwise.
+*/
+static int bsc_container_decode_block(const unsigned char * input, unsigned char * buffer, int blockSize, int dataSize, int recordSize, int sortingContexts, int features, bsc_context * scratch)
+{
+    int result = bsc_context_decompress(scratch, input, blockSize, buffer, dataSize, features);
+    if (result != LIBBSC_NO_ERROR)
+    {
+        return result;
+    }
+
+    if (sortingContexts == LIBBSC_CONTEXTS_PRECEDING)
+    {
+        result = bsc_reverse_block(buffer, dataSize, features);
+        if (result != LIBBSC_NO_ERROR) return result;
+    }
+
+    if (recordSize > 1)
+    {
+        result = bsc_context_reorder_reverse(scratch, buffer, dataSize, recordSize, features);
+        if (result != LIBBSC_NO_ERROR) return result;
+    }
+
+    return LIBBSC_NO_ERROR;
+}
+
+/**
+* Checks the container signature, "bsc2" marks a container holding reference records and "bsc3" one whose
+* references may repeat part of a block.
+* @return LIBBSC_NO_ERROR if no error occurred, LIBBSC_NOT_SUPPORTED for another format or a later version, error code otherwise.
+*/
+static int bsc_container_check_header(const unsigned char * header, int * version, int * nBlocks)
+{
+    if (header[0] != 'b' || header[1] != 's' || header[2] != 'c' || header[3] < 0x31 || header[3] > 0x33)
+    {
+        return LIBBSC_NOT_SUPPORTED;
+    }
+
+    *version = header[3] - 0x30;
+
+    memcpy(nBlocks, header + 4, sizeof(int));
+    if (*nBlocks <= 0)
+    {
+        return LIBBSC_DATA_CORRUPT;
+    }
+
+    return LIBBSC_NO_ERROR;
+}
+
+/**
+* Parses a block header. From version 2 on the deduplication flags are split from the order of contexts,
+* and a record size of 0 marks a reference record, whose sortingContexts is then 0.
+*/
+static int bsc_container_check_block_header(const unsigned char * header, int version, long long * blockOffset, int * recordSize, int * sortingContexts, int * flags)
+{
+    memcpy(blockOffset, header, sizeof(long long));
+    *recordSize         = (signed char)header[8];
+    *sortingContexts    = (signed char)header[9];
+    *flags              = 0;
+
+    if (version >= 2)
+    {
+        *flags              = header[9] & (LIBBSC_CONTAINER_BLOCK_REFERENCED | LIBBSC_CONTAINER_REFERENCE_LAST);
+        *sortingContexts    = header[9] & ~(LIBBSC_CONTAINER_BLOCK_REFERENCED | LIBBSC_CONTAINER_REFERENCE_LAST);
+
+        if (*recordSize == 0)
+        {
+            return *blockOffset >= 0 && *sortingContexts == 0 && (*flags & LIBBSC_CONTAINER_BLOCK_REFERENCED) == 0 ? LIBBSC_NO_ERROR : LIBBSC_DATA_CORRUPT;
+        }
+
+        if (*flags & LIBBSC_CONTAINER_REFERENCE_LAST)
+        {
+            return LIBBSC_DATA_CORRUPT;
+        }
+    }
+
+    if (*blockOffset < 0 || *recordSize < 1)
+    {
+        return LIBBSC_DATA_CORRUPT;
+    }
+
+    if (*sortingContexts != LIBBSC_CONTEXTS_FOLLOWING && *sortingContexts != LIBBSC_CONTEXTS_PRECEDING)
+    {
+        return LIBBSC_NOT_SUPPORTED;
+    }
+
+    return LIBBSC_NO_ERROR;
+}
+
+/**
+* Parses the payload of a reference record, the data it repeats must lie entirely before it in the original data.
+*/
+static int bsc_container_check_reference(const unsigned char * payload, long long blockOffset, long long * sourceOffset, int * dataSize)
+{
+    memcpy(sourceOffset, payload + 0, sizeof(long long));
+    memcpy(dataSize, payload + 8, sizeof(int));
+
+    return *sourceOffset >= 0 && *dataSize > 0 && *sourceOffset <= blockOffset - *dataSize ? LIBBSC_NO_ERROR : LIBBSC_DATA_CORRUPT;
+}
+
+#define LIBBSC_CONTAINER_SLOT_FREE      0
+#define LIBBSC_CONTAINER_SLOT_LOADED    1
+#define LIBBSC_CONTAINER_SLOT_DECODED   2
+
+typedef struct bsc_container_slot
+{
+    unsigned char * buffer;
+    int             capacity;
+    int             state;
+    long long       blockOffset;
+    int             recordSize;
+    int             sortingContexts;
+    int             flags;
+    long long       sourceOffset;
+    int             blockSize;
+    int             dataSize;
+} bsc_container_slot;
+
+/**
+* Reads the next block header and compressed block of the container into a free slot. A reference record only
+* fills the slot description, its recordSize is 0 and its blockSize 0.
+*/
+static int bsc_container_read_slot(bsc_container_read_fn read, void * context, bsc_container_slot * slot, int version, int features)
+{
+    unsigned char header[LIBBSC_CONTAINER_BLOCK_HEADER_SIZE + LIBBSC_HEADER_SIZE];
+
+    int result = bsc_container_read_block(read, context, header, LIBBSC_CONTAINER_BLOCK_HEADER_SIZE);
+    if (result != LIBBSC_NO_ERROR) return result;
+
+    result = bsc_container_check_block_header(header, version, &slot->blockOffset, &slot->recordSize, &slot->sortingContexts, &slot->flags);
+    if (result != LIBBSC_NO_ERROR) return result;
+
+    if (slot->recordSize == 0)
+    {
+        result = bsc_container_read_block(read, context, header + LIBBSC_CONTAINER_BLOCK_HEADER_SIZE, LIBBSC_CONTAINER_REFERENCE_SIZE - LIBBSC_CONTAINER_BLOCK_HEADER_SIZE);
+        if (result != LIBBSC_NO_ERROR) return result;
+
+        result = bsc_container_check_reference(header + LIBBSC_CONTAINER_BLOCK_HEADER_SIZE, slot->blockOffset, &slot->sourceOffset, &slot->dataSize);
+        if (result != LIBBSC_NO_ERROR) return result;
+
+        slot->blockSize = 0;
+        slot->state     = LIBBSC_CONTAINER_SLOT_LOADED;
+        return LIBBSC_NO_ERROR;
+    }
+
+    slot->sourceOffset = slot->blockOffset;
+
+    result = bsc_container_read_block(read, context, header + LIBBSC_CONTAINER_BLOCK_HEADER_SIZE, LIBBSC_HEADER_SIZE);
+    if (result != LIBBSC_NO_ERROR) return result;
+
+    result = bsc_block_info(header + LIBBSC_CONTAINER_BLOCK_HEADER_SIZE, LIBBSC_HEADER_SIZE, &slot->blockSize, &slot->dataSize, features);
+    if (result != LIBBSC_NO_ERROR) return result;
+
+    int capacity = slot->blockSize > slot->dataSize ? slot->blockSize : slot->dataSize;
+    if (capacity > slot->capacity)
+    {
+        bsc_free(slot->buffer); slot->capacity = 0;
+
+        slot->buffer = (unsigned char *)bsc_malloc(capacity);
+        if (slot->buffer == NULL) return LIBBSC_NOT_ENOUGH_MEMORY;
+
+        slot->capacity = capacity;
+    }
+
+    memcpy(slot->buffer, header + LIBBSC_CONTAINER_BLOCK_HEADER_SIZE, LIBBSC_HEADER_SIZE);
+
+    result = bsc_container_read_block(read, context, slot->buffer + LIBBSC_HEADER_SIZE, slot->blockSize - LIBBSC_HEADER_SIZE);
+    if (result != LIBBSC_NO_ERROR) return result;
+
+    slot->state = LIBBSC_CONTAINER_SLOT_LOADED;
+    return LIBBSC_NO_ERROR;
+}
+
+typedef struct bsc_container_retained
+{
+    long long       blockOffset;
+    int             dataSize;
+    unsigned char * data;
+} bsc_container_retained;
+
+/**
+* Copies of the decoded blocks that later reference records repeat. A forward-only output cannot be read back,
+* so a referenced block is kept from its own write until the write of its last reference.
+*/
+typedef struct bsc_container_retained_blocks
+{
+    bsc_container_retained *    blocks;
+    int                         count;
+    int                         capacity;
+} bsc_container_retained_blocks;
+
+static int bsc_container_retain(bsc_container_retained_blocks * retained, const bsc_container_slot * slot)
+{
+    if (retained->count == retained->capacity)
+    {
+        int capacity = retained->capacity > 0 ? 2 * retained->capacity : 16;
+
+        bsc_container_retained * blocks = (bsc_container_retained *)bsc_malloc((size_t)capacity * sizeof(bsc_container_retained));
+        if (blocks == NULL) return LIBBSC_NOT_ENOUGH_MEMORY;
+
+        if (retained->count > 0) memcpy(blocks, retained->blocks, (size_t)retained->count * sizeof(bsc_container_retained));
+
+        bsc_free(retained->blocks); retained->blocks = blocks; retained->capacity = capacity;
+    }
+
+    unsigned char * data = (unsigned char *)bsc_malloc(slot->dataSize);
+    if (data == NULL) return LIBBSC_NOT_ENOUGH_MEMORY;
+
+    memcpy(data, slot->buffer, slot->dataSize);
+
+    bsc_container_retained * block = &retained->blocks[retained->count++];
+
+    block->blockOffset  = slot->blockOffset;
+    block->dataSize     = slot->dataSize;
+    block->data         = data;
+
+    return LIBBSC_NO_ERROR;
+}
+
+/**
+* Finds the retained block holding dataSize bytes from sourceOffset, a whole block or a range of one.
+*/
+static int bsc_container_find_retained(const bsc_container_retained_blocks * retained, long long sourceOffset, int dataSize)
+{
+    for (int blockIndex = 0; blockIndex < retained->count; ++blockIndex)
+    {
+        const bsc_container_retained * block = &retained->blocks[blockIndex];
+        if (block->blockOffset <= sourceOffset && sourceOffset + dataSize <= block->blockOffset + block->dataSize) return blockIndex;
+    }
+
+    return -1;
+}
+
+static void bsc_container_release(bsc_container_retained_blocks * retained, int blockIndex)
+{
+    bsc_free(retained->blocks[blockIndex].data);
+    retained->blocks[blockIndex] = retained->blocks[--retained->count];
+}
+
+/**
+* Writes every decoded slot that continues the output, in order of blockOffset. A reference is always written after
+* the block it repeats, so its data is found among the retained blocks.
+*/
+static int bsc_container_flush_slots(bsc_container_slot * slots, int nSlots, bsc_container_retained_blocks * retained, long long * outputOffset, bsc_container_write_fn write, void * context)
+{
+    for (int slotIndex = 0; slotIndex < nSlots; )
+    {
+        bsc_container_slot * slot = &slots[slotIndex];
+        if (slot->state == LIBBSC_CONTAINER_SLOT_DECODED && slot->blockOffset == *outputOffset)
+        {
+            int retainedIndex = slot->recordSize == 0 ? bsc_container_find_retained(retained, slot->sourceOffset, slot->dataSize) : -1;
+            if (slot->recordSize == 0 && retainedIndex < 0)
+            {
+                return LIBBSC_DATA_CORRUPT;
+            }
+
+            const unsigned char * data = retainedIndex >= 0
+                ? retained->blocks[retainedIndex].data + (slot->sourceOffset - retained->blocks[retainedIndex].blockOffset)
+                : slot->buffer;
+
+            int result = write(context, data, slot->dataSize);
+            if (result != LIBBSC_NO_ERROR) return result;
+
+            if (slot->flags & LIBBSC_CONTAINER_REFERENCE_LAST) bsc_container_release(retained, retainedIndex);
+            if (slot->flags & LIBBSC_CONTAINER_BLOCK_REFERENCED)
+            {
+                result = bsc_container_retain(retained, slot);
+                if (result != LIBBSC_NO_ERROR) return result;
+            }
+
+            *outputOffset  += slot->dataSize;
+            slot->state     = LIBBSC_CONTAINER_SLOT_FREE;
+            slotIndex       = 0;
+            continue;
+        }
+
+        slotIndex++;
+    }
+
+    return LIBBSC_NO_ERROR;
+}
+
+int bsc_container_decompress_stream(bsc_container_read_fn read, void * readContext, int numThreads, int features, bsc_container_write_fn write, void * writeContext)
+{
+    if (read == NULL || write == NULL)
+    {
+        return LIBBSC_BAD_PARAMETER;
+    }
+
+    unsigned char header[LIBBSC_CONTAINER_HEADER_SIZE];
+
+    int result = bsc_container_read_block(read, readContext, header, LIBBSC_CONTAINER_HEADER_SIZE);
+    if (result != LIBBSC_NO_ERROR)
+    {
+        return result;
+    }
+
+    int version = 0, nBlocks = 0;
+
+    result = bsc_container_check_header(header, &version, &nBlocks);
+    if (result != LIBBSC_NO_ERROR)
+    {
+        return result;
+    }
+
+    bsc_container_budget budget;
+    bsc_container_budget_init(&budget, numThreads, nBlocks, features, false);
+
+    int window = budget.outer;
+    if (window > ALPHABET_SIZE) window = ALPHABET_SIZE;
+
+    // The reorder ring holds twice the decoding window so blocks written slightly out of order can wait for their turn
+    int nSlots = 2 * window > ALPHABET_SIZE ? ALPHABET_SIZE : 2 * window;
+
+    bsc_container_slot  slots[ALPHABET_SIZE];
+    int                 loaded[ALPHABET_SIZE];
+    int                 results[ALPHABET_SIZE];
+
+    memset(slots, 0, sizeof(slots));
+
+    bsc_container_retained_blocks retained = { NULL, 0, 0 };
+
+    bsc_context * scratch[ALPHABET_SIZE];
+    for (int thread = 0; thread < window; ++thread) scratch[thread] = bsc_container_create_scratch(NULL, budget.features);
+
+    long long outputOffset = 0;
+    for (int blockIndex = 0; (blockIndex < nBlocks) && (result == LIBBSC_NO_ERROR); )
+    {
+        int count = 0;
+        for (int slotIndex = 0; (slotIndex < nSlots) && (count < window) && (blockIndex < nBlocks) && (result == LIBBSC_NO_ERROR); ++slotIndex)
+        {
+            if (slots[slotIndex].state == LIBBSC_CONTAINER_SLOT_FREE)
+            {
+                result = bsc_container_read_slot(read, readContext, &slots[slotIndex], version, features);
+                loaded[count++] = slotIndex; blockIndex++;
+            }
+        }
+
+        if (result != LIBBSC_NO_ERROR) break;
+        if (count == 0) { result = LIBBSC_NOT_SUPPORTED; break; }
+
+#ifdef LIBBSC_OPENMP
+        #pragma omp parallel for schedule(dynamic, 1) ordered num_threads(count) if(count > 1)
+#endif
+        for (int loadedIndex = 0; loadedIndex < count; ++loadedIndex)
+        {
+            bsc_container_slot * slot = &slots[loaded[loadedIndex]];
+
+            bsc_container_budget_enter(&budget);
+
+            results[loadedIndex] = slot->recordSize > 0 ? bsc_container_decode_block(slot->buffer, slot->buffer, slot->blockSize, slot->dataSize, slot->recordSize, slot->sortingContexts, budget.features, scratch[bsc_container_thread_index()]) : LIBBSC_NO_ERROR;
+
+#ifdef LIBBSC_OPENMP
+            #pragma omp ordered
+#endif
+            {
+                if (result == LIBBSC_NO_ERROR)
+                {
+                    slot->state = LIBBSC_CONTAINER_SLOT_DECODED;
+                    result = results[loadedIndex] != LIBBSC_NO_ERROR ? results[loadedIndex] : bsc_container_flush_slots(slots, nSlots, &retained, &outputOffset, write, writeContext);
+                }
+            }
+        }
+    }
+
+    if (result == LIBBSC_NO_ERROR)
+    {
+        for (int slotIndex = 0; slotIndex < nSlots; ++slotIndex)
+        {
+            if (slots[slotIndex].state != LIBBSC_CONTAINER_SLOT_FREE) result = LIBBSC_DATA_CORRUPT;
+        }
+    }
+
+    for (int slotIndex = 0; slotIndex < nSlots; ++slotIndex)
+    {
+        bsc_free(slots[slotIndex].buffer);
+    }
+
+    for (int thread = 0; thread < window; ++thread)
+    {
+        bsc_container_destroy_scratch(scratch[thread]);
+    }
+
+    while (retained.count > 0)
+    {
+        bsc_container_release(&retained, retained.count - 1);
+    }
+
+    bsc_free(retained.blocks);
+
+    bsc_container_budget_done(&budget);
+
+    return result;
+}
+
+typedef struct bsc_container_cursor
+{
+    bsc_container_read_at_fn    read;
+    void *                      context;
+    long long                   position;
+} bsc_container_cursor;
+
+/**
+* Sequential view over a random access input, lets the range functions reuse the sequential block readers.
+*/
+static int bsc_container_read_cursor(void * context, unsigned char * buffer, int size)
+{
+    bsc_container_cursor * cursor = (bsc_container_cursor *)context;
+
+    int result = cursor->read(cursor->context, cursor->position, buffer, size);
+    if (result > 0) cursor->position += result;
+
+    return result;
+}
+
+/**
+* Reads the record at entry->position and fills the rest of the entry from its header.
+*/
+static int bsc_container_read_record(bsc_container_cursor * cursor, int version, bsc_container_index_entry * entry, int features)
+{
+    unsigned char header[LIBBSC_CONTAINER_BLOCK_HEADER_SIZE + LIBBSC_HEADER_SIZE];
+
+    int recordSize, sortingContexts, flags, blockSize;
+
+    cursor->position = entry->position;
+
+    int result = bsc_container_read_block(bsc_container_read_cursor, cursor, header, LIBBSC_CONTAINER_BLOCK_HEADER_SIZE);
+    if (result != LIBBSC_NO_ERROR) return result;
+
+    result = bsc_container_check_block_header(header, version, &entry->blockOffset, &recordSize, &sortingContexts, &flags);
+    if (result != LIBBSC_NO_ERROR) return result;
+
+    if (recordSize == 0)
+    {
+        result = bsc_container_read_block(bsc_container_read_cursor, cursor, header + LIBBSC_CONTAINER_BLOCK_HEADER_SIZE, LIBBSC_CONTAINER_REFERENCE_SIZE - LIBBSC_CONTAINER_BLOCK_HEADER_SIZE);
+        if (result != LIBBSC_NO_ERROR) return result;
+
+        entry->size = LIBBSC_CONTAINER_REFERENCE_SIZE;
+
+        return bsc_container_check_reference(header + LIBBSC_CONTAINER_BLOCK_HEADER_SIZE, entry->blockOffset, &entry->sourceOffset, &entry->dataSize);
+    }
+
+    result = bsc_container_read_block(bsc_container_read_cursor, cursor, header + LIBBSC_CONTAINER_BLOCK_HEADER_SIZE, LIBBSC_HEADER_SIZE);
+    if (result != LIBBSC_NO_ERROR) return result;
+
+    result = bsc_block_info(header + LIBBSC_CONTAINER_BLOCK_HEADER_SIZE, LIBBSC_HEADER_SIZE, &blockSize, &entry->dataSize, features);
+    if (result != LIBBSC_NO_ERROR) return result;
+
+    entry->size         = LIBBSC_CONTAINER_BLOCK_HEADER_SIZE + blockSize;
+    entry->sourceOffset = entry->blockOffset;
+
+    return LIBBSC_NO_ERROR;
+}
+
+static int bsc_container_read_index(bsc_container_cursor * cursor, long long indexPosition, bsc_container_index_entry * index, int nBlocks, int version, int features)
+{
+    unsigned char buffer[LIBBSC_CONTAINER_INDEX_CHUNK * LIBBSC_CONTAINER_INDEX_ENTRY_SIZE];
+
+    cursor->position = indexPosition;
+    for (int firstBlock = 0; firstBlock < nBlocks; firstBlock += LIBBSC_CONTAINER_INDEX_CHUNK)
+    {
+        int count = nBlocks - firstBlock < LIBBSC_CONTAINER_INDEX_CHUNK ? nBlocks - firstBlock : LIBBSC_CONTAINER_INDEX_CHUNK;
+
+        int result = bsc_container_read_block(bsc_container_read_cursor, cursor, buffer, count * LIBBSC_CONTAINER_INDEX_ENTRY_SIZE);
+        if (result != LIBBSC_NO_ERROR) return result;
+
+        for (int entryIndex = 0; entryIndex < count; ++entryIndex)
+        {
+            bsc_container_index_entry * entry = &index[firstBlock + entryIndex];
+            const unsigned char * record = buffer + entryIndex * LIBBSC_CONTAINER_INDEX_ENTRY_SIZE;
+
+            memcpy(&entry->blockOffset, record +  0, sizeof(long long));
+            memcpy(&entry->position, record +  8, sizeof(long long));
+            memcpy(&entry->size, record + 16, sizeof(int));
+            memcpy(&entry->dataSize, record + 20, sizeof(int));
+
+            entry->sourceOffset = entry->blockOffset;
+
+            bool reference = version >= 2 && entry->size == LIBBSC_CONTAINER_REFERENCE_SIZE;
+            if (entry->blockOffset < 0 || entry->dataSize < 0 || (entry->size < LIBBSC_CONTAINER_BLOCK_HEADER_SIZE + LIBBSC_HEADER_SIZE && !reference)
+                || entry->position < LIBBSC_CONTAINER_HEADER_SIZE || entry->position > indexPosition - entry->size)
+            {
+                return LIBBSC_DATA_CORRUPT;
+            }
+        }
+    }
+
+    // The footer does not tell which block a reference repeats, only the reference record itself does
+    for (int blockIndex = 0; blockIndex < nBlocks && version >= 2; ++blockIndex)
+    {
+        bsc_container_index_entry * entry = &index[blockIndex];
+        if (entry->size != LIBBSC_CONTAINER_REFERENCE_SIZE) continue;
+
+        bsc_container_index_entry record = *entry;
+
+        int result = bsc_container_read_record(cursor, version, &record, features);
+        if (result != LIBBSC_NO_ERROR) return result;
+
+        if (record.blockOffset != entry->blockOffset || record.size != entry->size || record.dataSize != entry->dataSize)
+        {
+            return LIBBSC_DATA_CORRUPT;
+        }
+
+        entry->sourceOffset = record.sourceOffset;
+    }
+
+    return LIBBSC_NO_ERROR;
+}
+
+static int bsc_container_scan_blocks(bsc_container_cursor * cursor, long long size, bsc_container_index_entry * index, int nBlocks, int version, int features)
+{
+    long long position = LIBBSC_CONTAINER_HEADER_SIZE;
+    for (int blockIndex = 0; blockIndex < nBlocks; ++blockIndex)
+    {
+        bsc_container_index_entry * entry = &index[blockIndex];
+
+        entry->position = position;
+
+        int result = bsc_container_read_record(cursor, version, entry, features);
+        if (result != LIBBSC_NO_ERROR) return result;
+
+        position = entry->position + entry->size;
+
+        if (position > size) return LIBBSC_UNEXPECTED_EOB;
+    }
+
+    return LIBBSC_NO_ERROR;
+}
+
+static int bsc_container_compare_entries(const void * left, const void * right)
+{
+    long long leftOffset    = ((const bsc_container_index_entry *)left)->blockOffset;
+    long long rightOffset   = ((const bsc_container_index_entry *)right)->blockOffset;
+
+    return leftOffset < rightOffset ? -1 : (leftOffset > rightOffset ? 1 : 0);
+}
+
+/**
+* Points every reference of a loaded table at the compressed block it repeats, which must not be another reference.
+* In a version 2 container it is a whole block of the same size, from version 3 on any block holding the repeated
+* range. Readers then decode that block for the reference, or copy its output.
+*/
+static int bsc_container_link_references(bsc_container_index_entry * index, int nBlocks, int version)
+{
+    int nPlain = 0;
+    for (int blockIndex = 0; blockIndex < nBlocks; ++blockIndex)
+    {
+        index[blockIndex].sourceBlock   = index[blockIndex].blockOffset;
+        index[blockIndex].sourceSize    = index[blockIndex].dataSize;
+
+        if (index[blockIndex].sourceOffset == index[blockIndex].blockOffset) nPlain++;
+    }
+
+    if (nPlain == nBlocks)
+    {
+        return LIBBSC_NO_ERROR;
+    }
+
+    bsc_container_index_entry * blocks = (bsc_container_index_entry *)bsc_malloc((size_t)nPlain * sizeof(bsc_container_index_entry));
+    if (blocks == NULL)
+    {
+        return LIBBSC_NOT_ENOUGH_MEMORY;
+    }
+
+    nPlain = 0;
+    for (int blockIndex = 0; blockIndex < nBlocks; ++blockIndex)
+    {
+        if (index[blockIndex].sourceOffset == index[blockIndex].blockOffset) blocks[nPlain++] = index[blockIndex];
+    }
+
+    qsort(blocks, nPlain, sizeof(bsc_container_index_entry), bsc_container_compare_entries);
+
+    int result = LIBBSC_NO_ERROR;
+    for (int blockIndex = 0; blockIndex < nBlocks && result == LIBBSC_NO_ERROR; ++blockIndex)
+    {
+        bsc_container_index_entry * entry = &index[blockIndex];
+        if (entry->sourceOffset == entry->blockOffset) continue;
+
+        // The last block starting at or before the repeated data is the only one that can hold it
+        int low = 0, high = nPlain;
+        while (low < high)
+        {
+            int middle = low + (high - low) / 2;
+            if (blocks[middle].blockOffset <= entry->sourceOffset) low = middle + 1; else high = middle;
+        }
+
+        const bsc_container_index_entry * source = low > 0 ? &blocks[low - 1] : NULL;
+        if (source == NULL || entry->sourceOffset + entry->dataSize > source->blockOffset + source->dataSize
+            || (version < 3 && (source->blockOffset != entry->sourceOffset || source->dataSize != entry->dataSize)))
+        {
+            result = LIBBSC_DATA_CORRUPT; break;
+        }
+
+        entry->position     = source->position;
+        entry->size         = source->size;
+        entry->sourceBlock  = source->blockOffset;
+        entry->sourceSize   = source->dataSize;
+    }
+
+    bsc_free(blocks);
+
+    return result;
+}
+
+
+/**
+* Loads the block table of a container, from its index footer if present or by walking the block headers otherwise.
+* The entry of a reference keeps its own offset and size but the position of the block it repeats.
+* @param index      - receives the table of *nBlocks entries, to be released with bsc_free.
+* @param version    - receives the container version, 2 or 3 if it may hold references.
+* @return LIBBSC_NO_ERROR if no error occurred, error code otherwise.
+*/
+static int bsc_container_load_index(bsc_container_read_at_fn read, void * context, long long size, int features, bsc_container_index_entry ** index, int * nBlocks, int * version)
+{
+    bsc_container_cursor cursor = { read, context, 0 };
+
+    unsigned char header[LIBBSC_CONTAINER_HEADER_SIZE];
+
+    int result = bsc_container_read_block(bsc_container_read_cursor, &cursor, header, LIBBSC_CONTAINER_HEADER_SIZE);
+    if (result != LIBBSC_NO_ERROR)
+    {
+        return result;
+    }
+
+    result = bsc_container_check_header(header, version, nBlocks);
+    if (result != LIBBSC_NO_ERROR)
+    {
+        return result;
+    }
+
+    *index = (bsc_container_index_entry *)bsc_malloc((size_t)*nBlocks * sizeof(bsc_container_index_entry));
+    if (*index == NULL)
+    {
+        return LIBBSC_NOT_ENOUGH_MEMORY;
+    }
+
+    long long indexPosition = -1;
+    if (size >= LIBBSC_CONTAINER_HEADER_SIZE + LIBBSC_CONTAINER_INDEX_TRAILER_SIZE)
+    {
+        unsigned char trailer[LIBBSC_CONTAINER_INDEX_TRAILER_SIZE];
+
+        cursor.position = size - LIBBSC_CONTAINER_INDEX_TRAILER_SIZE;
+        result = bsc_container_read_block(bsc_container_read_cursor, &cursor, trailer, LIBBSC_CONTAINER_INDEX_TRAILER_SIZE);
+
+        int indexBlocks = 0;
+        if (result == LIBBSC_NO_ERROR && trailer[12] == 'b' && trailer[13] == 's' && trailer[14] == 'c' && trailer[15] == 'i')
+        {
+            memcpy(&indexPosition, trailer + 0, sizeof(long long));
+            memcpy(&indexBlocks, trailer + 8, sizeof(int));
+
+            // A trailer that does not describe this container is block data that happens to end with the signature
+            if (indexBlocks != *nBlocks || indexPosition != size - LIBBSC_CONTAINER_INDEX_TRAILER_SIZE - (long long)*nBlocks * LIBBSC_CONTAINER_INDEX_ENTRY_SIZE)
+            {
+                indexPosition = -1;
+            }
+        }
+    }
+
+    if (result == LIBBSC_NO_ERROR)
+    {
+        result = indexPosition >= LIBBSC_CONTAINER_HEADER_SIZE
+            ? bsc_container_read_index(&cursor, indexPosition, *index, *nBlocks, *version, features)
+            : bsc_container_scan_blocks(&cursor, size, *index, *nBlocks, *version, features);
+    }
+
+    if (result == LIBBSC_NO_ERROR)
+    {
+        result = bsc_container_link_references(*index, *nBlocks, *version);
+    }
+
+    if (result != LIBBSC_NO_ERROR)
+    {
+        bsc_free(*index); *index = NULL;
+    }
+
+    return result;
+}
+
+int bsc_container_decompress_range(bsc_container_read_at_fn read, void * readContext, long long size, long long offset, long long length, int numThreads, int features, bsc_container_write_fn write, void * writeContext)
+{
+    if (read == NULL || write == NULL || size <= 0 || offset < 0 || length < 0)
+    {
+        return LIBBSC_BAD_PARAMETER;
+    }
+
+    bsc_container_index_entry * index = NULL; int nBlocks = 0, version = 0;
+
+    int result = bsc_container_load_index(read, readContext, size, features, &index, &nBlocks, &version);
+    if (result != LIBBSC_NO_ERROR)
+    {
+        return result;
+    }
+
+    long long dataLength = 0;
+    for (int blockIndex = 0; blockIndex < nBlocks; ++blockIndex)
+    {
+        if (index[blockIndex].blockOffset + index[blockIndex].dataSize > dataLength) dataLength = index[blockIndex].blockOffset + index[blockIndex].dataSize;
+    }
+
+    if (offset > dataLength || length > dataLength - offset)
+    {
+        bsc_free(index);
+        return LIBBSC_BAD_PARAMETER;
+    }
+
+    // Keep only the blocks touching the range, in order of their offset in the original data
+    int nSelected = 0;
+    for (int blockIndex = 0; blockIndex < nBlocks; ++blockIndex)
+    {
+        if (index[blockIndex].blockOffset < offset + length && index[blockIndex].blockOffset + index[blockIndex].dataSize > offset)
+        {
+            index[nSelected++] = index[blockIndex];
+        }
+    }
+
+    qsort(index, nSelected, sizeof(bsc_container_index_entry), bsc_container_compare_entries);
+
+    bsc_container_budget budget;
+    bsc_container_budget_init(&budget, numThreads, nSelected, features, false);
+
+    int window = budget.outer;
+    if (window > ALPHABET_SIZE) window = ALPHABET_SIZE;
+
+    bsc_container_slot  slots[ALPHABET_SIZE];
+    int                 results[ALPHABET_SIZE];
+
+    memset(slots, 0, sizeof(slots));
+
+    bsc_container_cursor cursor = { read, readContext, 0 };
+
+    bsc_context * scratch[ALPHABET_SIZE];
+    for (int thread = 0; thread < window; ++thread) scratch[thread] = bsc_container_create_scratch(NULL, budget.features);
+
+    long long outputOffset = offset;
+    for (int firstBlock = 0; (firstBlock < nSelected) && (result == LIBBSC_NO_ERROR); firstBlock += window)
+    {
+        int count = nSelected - firstBlock < window ? nSelected - firstBlock : window;
+
+        for (int slotIndex = 0; (slotIndex < count) && (result == LIBBSC_NO_ERROR); ++slotIndex)
+        {
+            const bsc_container_index_entry * entry = &index[firstBlock + slotIndex];
+            bsc_container_slot * slot = &slots[slotIndex];
+
+            cursor.position = entry->position;
+            result = bsc_container_read_slot(bsc_container_read_cursor, &cursor, slot, version, features);
+
+            // A reference reads the block holding the data it repeats, the data then goes to the offset of the reference
+            if (result == LIBBSC_NO_ERROR && (slot->recordSize == 0 || slot->blockOffset != entry->sourceBlock || slot->dataSize != entry->sourceSize || LIBBSC_CONTAINER_BLOCK_HEADER_SIZE + slot->blockSize != entry->size))
+            {
+                result = LIBBSC_DATA_CORRUPT;
+            }
+        }
+
+        if (result != LIBBSC_NO_ERROR) break;
+
+#ifdef LIBBSC_OPENMP
+        #pragma omp parallel for schedule(dynamic, 1) num_threads(count) if(count > 1)
+#endif
+        for (int slotIndex = 0; slotIndex < count; ++slotIndex)
+        {
+            bsc_container_slot * slot = &slots[slotIndex];
+
+            bsc_container_budget_enter(&budget);
+
+            results[slotIndex] = bsc_container_decode_block(slot->buffer, slot->buffer, slot->blockSize, slot->dataSize, slot->recordSize, slot->sortingContexts, budget.features, scratch[bsc_container_thread_index()]);
+        }
+
+        for (int slotIndex = 0; (slotIndex < count) && (result == LIBBSC_NO_ERROR); ++slotIndex)
+        {
+            const bsc_container_index_entry * entry = &index[firstBlock + slotIndex];
+            bsc_container_slot * slot = &slots[slotIndex];
+
+            result = results[slotIndex];
+            if (result != LIBBSC_NO_ERROR) break;
+
+            // Blocks must tile the original data, a hole inside the range means the table is lying
+            if (entry->blockOffset > outputOffset) { result = LIBBSC_DATA_CORRUPT; break; }
+
+            const unsigned char * data = slot->buffer + (entry->sourceOffset - entry->sourceBlock);
+
+            long long blockEnd  = entry->blockOffset + entry->dataSize < offset + length ? entry->blockOffset + entry->dataSize : offset + length;
+            int       begin     = (int)(outputOffset - entry->blockOffset);
+            int       end       = (int)(blockEnd - entry->blockOffset);
+
+            if (end > begin)
+            {
+                result = write(writeContext, data + begin, end - begin);
+                outputOffset = blockEnd;
+            }
+
+            slot->state = LIBBSC_CONTAINER_SLOT_FREE;
+        }
+    }
+
+    if (result == LIBBSC_NO_ERROR && outputOffset != offset + length)
+    {
+        result = LIBBSC_DATA_CORRUPT;
+    }
+
+    for (int slotIndex = 0; slotIndex < window; ++slotIndex)
+    {
+        bsc_free(slots[slotIndex].buffer);
+    }
+
+    for (int thread = 0; thread < window; ++thread)
+    {
+        bsc_container_destroy_scratch(scratch[thread]);
+    }
+
+    bsc_free(index);
+
+    bsc_container_budget_done(&budget);
+
+    return result;
+}
+
+typedef struct bsc_container_memory
+{
+    const unsigned char *   input;
+    long long               n;
+} bsc_container_memory;
+
+static int bsc_container_read_memory(void * context, long long position, unsigned char * buffer, int size)
+{
+    bsc_container_memory * memory = (bsc_container_memory *)context;
+    if (position >= memory->n)
+    {
+        return 0;
+    }
+
+    if (size > memory->n - position) size = (int)(memory->n - position);
+
+    memcpy(buffer, memory->input + position, size);
+    return size;
+}
+
+/**
+* Decodes one block of a loaded table, references are skipped when decoding into output.
+*/
+static void bsc_container_decode_entry(const unsigned char * input, const bsc_container_index_entry * entry, int version, int features, bsc_container_write_at_fn write, void * context, unsigned char * output, long long outputSize, unsigned char * buffer, bsc_context * scratch, std::atomic<int> * decodeResult)
+{
+    const unsigned char * block = input + entry->position;
+
+    if (decodeResult->load(std::memory_order_relaxed) != LIBBSC_NO_ERROR) return;
+    if (output != NULL && entry->sourceOffset != entry->blockOffset) return;
+
+    long long blockOffset = 0;
+    int recordSize = 0, sortingContexts = 0, flags = 0, blockSize = 0, dataSize = 0;
+
+    int blockResult = output != NULL || buffer != NULL ? LIBBSC_NO_ERROR : LIBBSC_NOT_ENOUGH_MEMORY;
+    if (blockResult == LIBBSC_NO_ERROR)
+    {
+        blockResult = bsc_container_check_block_header(block, version, &blockOffset, &recordSize, &sortingContexts, &flags);
+    }
+    if (blockResult == LIBBSC_NO_ERROR && recordSize == 0)
+    {
+        blockResult = LIBBSC_DATA_CORRUPT;
+    }
+    if (blockResult == LIBBSC_NO_ERROR)
+    {
+        blockResult = bsc_block_info(block + LIBBSC_CONTAINER_BLOCK_HEADER_SIZE, LIBBSC_HEADER_SIZE, &blockSize, &dataSize, features);
+    }
+    if (blockResult == LIBBSC_NO_ERROR && (blockOffset != entry->sourceBlock || dataSize != entry->sourceSize || LIBBSC_CONTAINER_BLOCK_HEADER_SIZE + blockSize != entry->size))
+    {
+        blockResult = LIBBSC_DATA_CORRUPT;
+    }
+    if (blockResult == LIBBSC_NO_ERROR && output != NULL && blockOffset > outputSize - dataSize)
+    {
+        blockResult = LIBBSC_UNEXPECTED_EOB;
+    }
+    if (blockResult == LIBBSC_NO_ERROR)
+    {
+        blockResult = bsc_container_decode_block(block + LIBBSC_CONTAINER_BLOCK_HEADER_SIZE, output != NULL ? output + blockOffset : buffer, blockSize, dataSize, recordSize, sortingContexts, features, scratch);
+    }
+
+    if (output != NULL)
+    {
+        if (blockResult != LIBBSC_NO_ERROR) decodeResult->store(blockResult);
+        return;
+    }
+
+#ifdef LIBBSC_OPENMP
+    #pragma omp critical(bsc_container_output)
+#endif
+    {
+        if (decodeResult->load() == LIBBSC_NO_ERROR)
+        {
+            decodeResult->store(blockResult != LIBBSC_NO_ERROR ? blockResult : write(context, entry->blockOffset, buffer + (entry->sourceOffset - entry->sourceBlock), entry->dataSize));
+        }
+    }
+}
+
+/**
+* Decodes every block of a loaded table, straight into output at its offset when output is not NULL,
+* through the positioned write callback otherwise. References are copied within the output once every
+* block is decoded, through the callback they decode the block they repeat once more.
+*/
+static int bsc_container_decode_table(const unsigned char * input, const bsc_container_index_entry * index, int nBlocks, int version, int numThreads, int features, bsc_container_write_at_fn write, void * context, unsigned char * output, long long outputSize)
+{
+    int bufferSize = 1;
+    if (output == NULL)
+    {
+        for (int blockIndex = 0; blockIndex < nBlocks; ++blockIndex)
+        {
+            if (index[blockIndex].sourceSize > bufferSize) bufferSize = index[blockIndex].sourceSize;
+        }
+    }
+
+    std::atomic<int> decodeResult(LIBBSC_NO_ERROR);
+
+    bsc_container_budget budget;
+    bsc_container_budget_init(&budget, numThreads, nBlocks, features, false);
+
+    numThreads = budget.outer; features = budget.features;
+
+    // With NUMA placement, blocks are listed per node of their compressed bytes, the last list holds unknown ones
+    bsc_container_numa numa;
+    bsc_container_numa_init(&numa, numThreads);
+
+    int *               order   = NULL;
+    int                 starts[LIBBSC_CONTAINER_MAX_NODES + 2];
+    std::atomic<int>    next[LIBBSC_CONTAINER_MAX_NODES + 1];
+
+    if (numa.nNodes > 1)
+    {
+        int * nodes = (int *)bsc_malloc((size_t)nBlocks * sizeof(int));
+        order       = (int *)bsc_malloc((size_t)nBlocks * sizeof(int));
+
+        if (nodes != NULL && order != NULL)
+        {
+            memset(starts, 0, sizeof(starts));
+            for (int blockIndex = 0; blockIndex < nBlocks; ++blockIndex)
+            {
+                int node = bsc_container_numa_locate(&numa, input + index[blockIndex].position, index[blockIndex].size);
+
+                nodes[blockIndex] = node >= 0 ? node : numa.nNodes; starts[nodes[blockIndex] + 1]++;
+            }
+
+            for (int node = 0; node <= numa.nNodes; ++node) { starts[node + 1] += starts[node]; next[node].store(starts[node]); }
+            for (int blockIndex = 0; blockIndex < nBlocks; ++blockIndex) { order[next[nodes[blockIndex]].fetch_add(1)] = blockIndex; }
+            for (int node = 0; node <= numa.nNodes; ++node) { next[node].store(starts[node]); }
+        }
+        else
+        {
+            bsc_free(order); order = NULL; numa.nNodes = 1;
+        }
+
+        bsc_free(nodes);
+    }
+
+#ifdef LIBBSC_OPENMP
+
+    #pragma omp parallel num_threads(numThreads) if(numThreads > 1)
+
+#endif
+
+    {
+        bsc_container_numa_binding binding;
+
+        int thread = 0, team = 1;
+
+#ifdef LIBBSC_OPENMP
+
+        thread = omp_get_thread_num(); team = omp_get_num_threads();
+
+#endif
+
+        int             node    = bsc_container_numa_enter(&numa, thread, team, &binding);
+        unsigned char * buffer  = output == NULL ? (unsigned char *)bsc_malloc(bufferSize) : NULL;
+        bsc_context *   scratch = bsc_container_create_scratch(NULL, features);
+
+        bsc_container_budget_enter(&budget);
+
+        // The condition is the same for the whole team, so every thread meets the same worksharing constructs
+        if (order != NULL)
+        {
+            // A thread drains the list of its own node first, then the unknown blocks, then helps the other nodes
+            for (int step = 0; step <= numa.nNodes; ++step)
+            {
+                int list = node < 0 ? (step == 0 ? numa.nNodes : step - 1) : (step == 0 ? node : step == 1 ? numa.nNodes : (node + step - 1) % numa.nNodes);
+
+                for (int position = next[list].fetch_add(1); position < starts[list + 1]; position = next[list].fetch_add(1))
+                {
+                    bsc_container_decode_entry(input, &index[order[position]], version, features, write, context, output, outputSize, buffer, scratch, &decodeResult);
+                }
+            }
+
+#ifdef LIBBSC_OPENMP
+            #pragma omp barrier
+#endif
+        }
+        else
+        {
+
+#ifdef LIBBSC_OPENMP
+            #pragma omp for schedule(dynamic, 1)
+#endif
+            for (int blockIndex = 0; blockIndex < nBlocks; ++blockIndex)
+            {
+                bsc_container_decode_entry(input, &index[blockIndex], version, features, write, context, output, outputSize, buffer, scratch, &decodeResult);
+            }
+        }
+
+        // The loop above ends on a barrier, so every block a reference repeats is already in the output
+        if (output != NULL)
+        {
+
+#ifdef LIBBSC_OPENMP
+            #pragma omp for schedule(dynamic, 1)
+#endif
+            for (int blockIndex = 0; blockIndex < nBlocks; ++blockIndex)
+            {
+                const bsc_container_index_entry * entry = &index[blockIndex];
+                if (entry->sourceOffset == entry->blockOffset || decodeResult.load(std::memory_order_relaxed) != LIBBSC_NO_ERROR) continue;
+
+                if (entry->blockOffset > outputSize - entry->dataSize)
+                {
+                    decodeResult.store(LIBBSC_UNEXPECTED_EOB); continue;
+                }
+
+                memcpy(output + entry->blockOffset, output + entry->sourceOffset, entry->dataSize);
+            }
+        }
+
+        bsc_container_destroy_scratch(scratch);
+        bsc_free(buffer);
+
+        bsc_container_numa_leave(&binding);
+    }
+
+    bsc_free(order);
+
+    bsc_container_budget_done(&budget);
+
+    return decodeResult.load();
+}
+
+/**
+* Loads the block table of a container held in memory.
+*/
+static int bsc_container_load_memory_index(const unsigned char * input, long long n, int features, bsc_container_index_entry ** index, int * nBlocks, int * version)
+{
+    bsc_container_memory memory = { input, n };
+
+    return bsc_container_load_index(bsc_container_read_memory, &memory, n, features, index, nBlocks, version);
+}
+
+/**
+* Loads the block table and the block hashes of the previous container of an incremental compression. Every block
+* of the table is checked against its record, as its compressed bytes are copied into the new container unseen.
+* @param hashes     - receives the hashes of the *nBlocks blocks, pointing into previous.
+* @return LIBBSC_NO_ERROR if no error occurred, LIBBSC_NOT_SUPPORTED if the container has no hashes, error code otherwise.
+*/
+static int bsc_container_load_previous(const unsigned char * previous, long long previousSize, int features, bsc_container_index_entry ** index, const unsigned char ** hashes, int * nBlocks)
+{
+    int version = 0;
+
+    int result = bsc_container_load_memory_index(previous, previousSize, features, index, nBlocks, &version);
+    if (result != LIBBSC_NO_ERROR)
+    {
+        return result;
+    }
+
+    // The hashes end right before the index footer, which in turn ends the container
+    long long indexPosition = previousSize - LIBBSC_CONTAINER_INDEX_TRAILER_SIZE - (long long)*nBlocks * LIBBSC_CONTAINER_INDEX_ENTRY_SIZE;
+    long long hashPosition  = indexPosition - LIBBSC_CONTAINER_HASH_TRAILER_SIZE - (long long)*nBlocks * LIBBSC_CONTAINER_HASH_ENTRY_SIZE;
+
+    result = LIBBSC_NOT_SUPPORTED;
+    if (hashPosition >= LIBBSC_CONTAINER_HEADER_SIZE)
+    {
+        const unsigned char * indexTrailer  = previous + previousSize - LIBBSC_CONTAINER_INDEX_TRAILER_SIZE;
+        const unsigned char * hashTrailer   = previous + indexPosition - LIBBSC_CONTAINER_HASH_TRAILER_SIZE;
+
+        long long position = 0; int count = 0;
+
+        memcpy(&position, hashTrailer + 0, sizeof(long long));
+        memcpy(&count, hashTrailer + 8, sizeof(int));
+
+        if (indexTrailer[12] == 'b' && indexTrailer[13] == 's' && indexTrailer[14] == 'c' && indexTrailer[15] == 'i'
+            && hashTrailer[12] == 'b' && hashTrailer[13] == 's' && hashTrailer[14] == 'c' && hashTrailer[15] == 'h'
+            && position == hashPosition && count == *nBlocks)
+        {
+            result = LIBBSC_NO_ERROR;
+        }
+    }
+
+    for (int blockIndex = 0; blockIndex < *nBlocks && result == LIBBSC_NO_ERROR; ++blockIndex)
+    {
+        const bsc_container_index_entry * entry = &(*index)[blockIndex];
+
+        // References were linked to the block they repeat, which is checked on its own
+        if (entry->sourceOffset != entry->blockOffset) continue;
+
+        long long blockOffset; int recordSize, sortingContexts, flags, blockSize, dataSize;
+
+        const unsigned char * record = previous + entry->position;
+
+        result = entry->position + entry->size <= hashPosition ? bsc_container_check_block_header(record, version, &blockOffset, &recordSize, &sortingContexts, &flags) : LIBBSC_DATA_CORRUPT;
+        if (result == LIBBSC_NO_ERROR && (recordSize == 0 || blockOffset != entry->blockOffset)) result = LIBBSC_DATA_CORRUPT;
+        if (result == LIBBSC_NO_ERROR) result = bsc_block_info(record + LIBBSC_CONTAINER_BLOCK_HEADER_SIZE, LIBBSC_HEADER_SIZE, &blockSize, &dataSize, features);
+        if (result == LIBBSC_NO_ERROR && (LIBBSC_CONTAINER_BLOCK_HEADER_SIZE + blockSize != entry->size || dataSize != entry->dataSize || blockSize > dataSize + LIBBSC_HEADER_SIZE))
+        {
+            result = LIBBSC_DATA_CORRUPT;
+        }
+    }
+
+    if (result != LIBBSC_NO_ERROR)
+    {
+        bsc_free(*index); *index = NULL;
+        return result;
+    }
+
+    *hashes = previous + hashPosition;
+
+    return LIBBSC_NO_ERROR;
+}
+
+int bsc_container_decompress(const unsigned char * input, long long n, int numThreads, int features, bsc_container_write_at_fn write, void * context)
+{
+    if (input == NULL || n <= 0 || write == NULL)
+    {
+        return LIBBSC_BAD_PARAMETER;
+    }
+
+    bsc_container_index_entry * index = NULL; int nBlocks = 0, version = 0;
+
+    // Every block is located before any decoding starts, workers then never wait on each other to find their input
+    int result = bsc_container_load_memory_index(input, n, features, &index, &nBlocks, &version);
+    if (result != LIBBSC_NO_ERROR)
+    {
+        return result;
+    }
+
+    result = bsc_container_decode_table(input, index, nBlocks, version, numThreads, features, write, context, NULL, 0);
+
+    bsc_free(index);
+
+    return result;
+}
+
+int bsc_container_data_size(const unsigned char * input, long long n, int features, long long * dataSize)
+{
+    if (input == NULL || n <= 0 || dataSize == NULL)
+    {
+        return LIBBSC_BAD_PARAMETER;
+    }
+
+    bsc_container_index_entry * index = NULL; int nBlocks = 0, version = 0;
+
+    int result = bsc_container_load_memory_index(input, n, features, &index, &nBlocks, &version);
+    if (result != LIBBSC_NO_ERROR)
+    {
+        return result;
+    }
+
+    *dataSize = 0;
+    for (int blockIndex = 0; blockIndex < nBlocks; ++blockIndex)
+    {
+        if (index[blockIndex].blockOffset + index[blockIndex].dataSize > *dataSize) *dataSize = index[blockIndex].blockOffset + index[blockIndex].dataSize;
+    }
+
+    bsc_free(index);
+
+    return LIBBSC_NO_ERROR;
+}
+
+int bsc_container_decompress_buffer(const unsigned char * input, long long n, unsigned char * output, long long outputSize, int numThreads, int features)
+{
+    if (input == NULL || n <= 0 || output == NULL || outputSize < 0)
+    {
+        return LIBBSC_BAD_PARAMETER;
+    }
+
+    bsc_container_index_entry * index = NULL; int nBlocks = 0, version = 0;
+
+    int result = bsc_container_load_memory_index(input, n, features, &index, &nBlocks, &version);
+    if (result != LIBBSC_NO_ERROR)
+    {
+        return result;
+    }
+
+    // Workers decode straight into the output, blocks must therefore not overlap
+    bsc_container_index_entry * sorted = (bsc_container_index_entry *)bsc_malloc((size_t)nBlocks * sizeof(bsc_container_index_entry));
+    if (sorted != NULL)
+    {
+        memcpy(sorted, index, (size_t)nBlocks * sizeof(bsc_container_index_entry));
+        qsort(sorted, nBlocks, sizeof(bsc_container_index_entry), bsc_container_compare_entries);
+
+        for (int blockIndex = 1; blockIndex < nBlocks; ++blockIndex)
+        {
+            if (sorted[blockIndex].blockOffset < sorted[blockIndex - 1].blockOffset + sorted[blockIndex - 1].dataSize) result = LIBBSC_DATA_CORRUPT;
+        }
+
+        bsc_free(sorted);
+    }
+    else
+    {
+        result = LIBBSC_NOT_ENOUGH_MEMORY;
+    }
+
+    if (result == LIBBSC_NO_ERROR)
+    {
+        result = bsc_container_decode_table(input, index, nBlocks, version, numThreads, features, NULL, NULL, output, outputSize);
+    }
+
+    bsc_free(index);
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
+/* End                                         container.cpp */
+/*-----------------------------------------------------------*/
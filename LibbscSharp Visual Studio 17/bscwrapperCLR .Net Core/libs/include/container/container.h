@@ -0,0 +1,356 @@
+/*-----------------------------------------------------------*/
+/* Block Sorting, Lossless Data Compression Library.         */
+/* Interface to block-parallel bsc1 container functions      */
+/*-----------------------------------------------------------*/
+
+/*--
+
+This file is a part of LibBSC Sharp, a .NET port of bsc and libbsc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+The container layout is the one written by the original bsc command-line
+tool: a "bsc1" signature, the number of blocks, then for every block a
+10 bytes header (offset of the block in the original data, record size
+and order of contexts) followed by the libbsc compressed block.
+
+Optionally the blocks are followed by an index footer: for every block its
+offset in the original data, its position and size in the container and its
+decompressed size, then a 16 bytes trailer (position of the index, number of
+blocks, "bsci" signature). Readers that stop after the declared number of
+blocks never see it, readers that know it find any block in a single seek.
+
+With deduplication, a block identical to an earlier one is written as a 22
+bytes reference record instead: a block header with a record size of 0,
+then the offset in the original data of the earlier block and the length.
+The earlier block carries LIBBSC_CONTAINER_BLOCK_REFERENCED in its order
+of contexts byte and the last reference to it LIBBSC_CONTAINER_REFERENCE_LAST,
+so streaming readers know how long to keep it. Containers holding references
+are signed "bsc2", readers that only know "bsc1" reject them as unsupported.
+
+With long-range matching, a repeat of at least LIBBSC_CONTAINER_LONG_MIN_MATCH
+bytes anywhere earlier in the input is cut into a block of its own and written
+as the same reference record, whose source is then any range inside one earlier
+block that is not a reference. Containers where a reference does not cover a
+whole block are signed "bsc3".
+
+With LIBBSC_CONTAINER_INDEX_HASHES the index footer is preceded by the 128-bit
+hash of the original data of every block, then a 16 bytes trailer (position
+of the hashes, number of blocks, "bsch" signature). Readers of the index never
+see them, an incremental compression looks blocks up by hash in them.
+
+--*/
+
+#ifndef _LIBBSC_CONTAINER_H
+#define _LIBBSC_CONTAINER_H
+
+#include <stddef.h>
+
+#define LIBBSC_CONTAINER_HEADER_SIZE        8
+#define LIBBSC_CONTAINER_BLOCK_HEADER_SIZE  10
+#define LIBBSC_CONTAINER_INDEX_ENTRY_SIZE   24
+#define LIBBSC_CONTAINER_INDEX_TRAILER_SIZE 16
+#define LIBBSC_CONTAINER_REFERENCE_SIZE     22
+#define LIBBSC_CONTAINER_HASH_ENTRY_SIZE    16
+#define LIBBSC_CONTAINER_HASH_TRAILER_SIZE  16
+
+#define LIBBSC_CONTAINER_INDEX_HASHES       2
+
+#define LIBBSC_CONTAINER_BLOCK_REFERENCED   0x10
+#define LIBBSC_CONTAINER_REFERENCE_LAST     0x20
+
+#define LIBBSC_CONTAINER_DEFAULT_BLOCKSIZE  (25 * 1024 * 1024)
+
+#define LIBBSC_CONTAINER_CONTEXTS_AUTODETECT    3
+#define LIBBSC_CONTAINER_RECORDSIZE_AUTODETECT  0
+#define LIBBSC_CONTAINER_MAX_RECORDSIZE         127
+#define LIBBSC_CONTAINER_LZP_AUTODETECT         -1
+
+#define LIBBSC_CONTAINER_DEFAULT_MINBLOCKSIZE   (1024 * 1024)
+#define LIBBSC_CONTAINER_DEFAULT_CDCBLOCKSIZE   (4 * 1024 * 1024)
+#define LIBBSC_CONTAINER_MIN_CDCBLOCKSIZE       4096
+#define LIBBSC_CONTAINER_DEFAULT_STORETHRESHOLD 790
+#define LIBBSC_CONTAINER_LONG_MIN_MATCH         (32 * 1024)
+
+#define LIBBSC_CONTAINER_IO_ERROR           -24
+
+#ifndef LIBBSC_API
+  #ifdef _WIN32
+    #ifdef LIBBSC_SHARED
+      #ifdef LIBBSC_EXPORTS
+        #define LIBBSC_API __declspec(dllexport)
+      #else
+        #define LIBBSC_API __declspec(dllimport)
+      #endif
+    #else
+      #define LIBBSC_API
+    #endif
+  #else
+    #define LIBBSC_API
+  #endif
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    /**
+    * Statistics of a container compression, filled when bsc_container_params::stats is set.
+    */
+    typedef struct bsc_container_stats
+    {
+        int         nBlocks;        /* the number of blocks written.                                          */
+        int         storedBlocks;   /* the number of blocks stored uncompressed, skipped ones included.       */
+        int         skippedBlocks;  /* the number of blocks stored by the entropy estimator, not compressed.  */
+        long long   skippedBytes;   /* the number of input bytes in skipped blocks.                           */
+        int         dedupBlocks;    /* the number of blocks written as references to an identical block.     */
+        long long   dedupBytes;     /* the number of input bytes in deduplicated blocks.                      */
+        int         reusedBlocks;   /* the number of blocks copied from the previous container.               */
+        long long   reusedBytes;    /* the number of input bytes in reused blocks.                            */
+        int         longMatches;    /* the number of long-range matches written as references.               */
+        long long   longBytes;      /* the number of input bytes in long-range matches.                       */
+    } bsc_container_stats;
+
+    /**
+    * Parameters of the container compressor, initialize them with @ref bsc_container_default_params.
+    */
+    typedef struct bsc_container_params
+    {
+        int blockSize;          /* the maximum size of a block in bytes.                                  */
+        int numThreads;         /* the number of blocks compressed concurrently, 0 for all cores.         */
+        int lzpHashSize;        /* the hash table size if LZP enabled, 0 otherwise, -1 to size it per block. */
+        int lzpMinLen;          /* the minimum match length if LZP enabled, 0 otherwise, -1 to pick it
+                                   per block from a sample, LZP is then disabled where it does not pay.    */
+        int blockSorter;        /* the block sorting algorithm.                                           */
+        int coder;              /* the entropy coding algorithm.                                          */
+        int features;           /* the set of additional features.                                        */
+        int writeIndex;         /* non-zero to append the index footer, LIBBSC_CONTAINER_INDEX_HASHES
+                                   to precede it with the block hashes used by incremental compression.    */
+        int sortingContexts;    /* LIBBSC_CONTEXTS_FOLLOWING, LIBBSC_CONTEXTS_PRECEDING or autodetection. */
+        int recordSize;         /* the record size for reordering, 1 to disable, 0 for autodetection.     */
+        int minBlockSize;       /* the minimum size of content-aware blocks, 0 for fixed-size blocks.     */
+        int storeThreshold;     /* store blocks estimated above this many 1/100 bits per byte, 0 never.   */
+        int deduplicate;        /* non-zero to write repeated blocks as references, memory inputs only.   */
+        int cdcBlockSize;       /* the average size of content-defined blocks, 0 for fixed-size blocks.   */
+        int longRange;          /* non-zero to write long repeats anywhere in the input as references,
+                                   memory inputs only, supersedes deduplicate.                             */
+
+        bsc_container_stats *   stats;          /* optional, receives the statistics of the compression.   */
+        const unsigned char *   previous;       /* optional, a previous container written with the block   */
+        long long               previousSize;   /* hashes, blocks found in it by hash are copied verbatim. */
+
+        void *  (* malloc)(void * user, size_t size);   /* optional, allocates the memory of a compression:   */
+        void    (* free)(void * user, void * address);  /* slot buffers, plans, indexes and thread scratch.   */
+        void *  allocatorUser;                          /* passed to malloc and free.                         */
+    } bsc_container_params;
+
+    /**
+    * Output callback of the container functions. Called from a single thread at a time, in container order.
+    * @param context    - the user context given to the container function.
+    * @param data       - the bytes to write.
+    * @param size       - the number of bytes to write.
+    * @return LIBBSC_NO_ERROR if no error occurred, negative error code otherwise (aborts the operation).
+    */
+    typedef int (* bsc_container_write_fn)(void * context, const unsigned char * data, int size);
+
+    /**
+    * Positioned output callback of the container functions. Called from a single thread at a time, in completion order.
+    * @param context    - the user context given to the container function.
+    * @param position   - the offset in the original data of the first byte to write.
+    * @param data       - the bytes to write.
+    * @param size       - the number of bytes to write.
+    * @return LIBBSC_NO_ERROR if no error occurred, negative error code otherwise (aborts the operation).
+    */
+    typedef int (* bsc_container_write_at_fn)(void * context, long long position, const unsigned char * data, int size);
+
+    /**
+    * Input callback of the streaming container functions. Always called from the thread that started the operation.
+    * @param context    - the user context given to the container function.
+    * @param buffer     - the buffer to fill.
+    * @param size       - the capacity of the buffer.
+    * @return the number of bytes read (0 at end of input) if no error occurred, negative error code otherwise.
+    */
+    typedef int (* bsc_container_read_fn)(void * context, unsigned char * buffer, int size);
+
+    /**
+    * Random access input callback of the container functions. Always called from the thread that started the operation.
+    * @param context    - the user context given to the container function.
+    * @param position   - the position in the container of the first byte to read.
+    * @param buffer     - the buffer to fill.
+    * @param size       - the capacity of the buffer.
+    * @return the number of bytes read (0 at end of input) if no error occurred, negative error code otherwise.
+    */
+    typedef int (* bsc_container_read_at_fn)(void * context, long long position, unsigned char * buffer, int size);
+
+    /**
+    * Fills the container parameters with the defaults used by the .NET wrapper.
+    * @param params     - the parameters to initialize.
+    */
+    LIBBSC_API void bsc_container_default_params(bsc_container_params * params);
+
+    /**
+    * Computes the worst case size of the container of n bytes, every block stored uncompressed. The index footer and
+    * the block hashes are included when requested, or when previous is set as an incremental compression writes both.
+    * @param n          - the length of the input.
+    * @param params     - the compression parameters.
+    * @return the maximum container size if no error occurred, LIBBSC_BAD_PARAMETER otherwise.
+    */
+    LIBBSC_API long long bsc_container_compress_bound(long long n, const bsc_container_params * params);
+
+    /**
+    * Compresses a memory buffer into a bsc1 container, blocks are compressed in parallel and written in order.
+    * numThreads compressor threads feed a dedicated writer thread through a bounded ring of numThreads + 2 reusable
+    * arenas of blockSize + LIBBSC_HEADER_SIZE bytes, so output writes never stall the compressors.
+    * When minBlockSize is set, segments are detected in parallel over the input first and blocks are cut at content
+    * changes, between minBlockSize and blockSize bytes.
+    * When cdcBlockSize is set, blocks are cut by a Gear rolling hash instead (FastCDC normalized chunking), between
+    * cdcBlockSize / 4 and min(8 * cdcBlockSize, blockSize) bytes, so an edit of the input only moves the blocks
+    * around it. When deduplicate is set, every block is hashed in parallel first and repeated blocks are written as
+    * references to their first occurrence, without being compressed again.
+    * When longRange is set, the whole input is scanned for repeats of LIBBSC_CONTAINER_LONG_MIN_MATCH bytes or more
+    * through a Gear hash sampled about every 4KB, wherever they fall relative to block boundaries. Every match becomes
+    * a block written as a reference to a range of an earlier block, the rest of the input keeps its planned blocks.
+    * When previous is set, blocks whose hash and size are found in its hash table are not compressed: their compressed
+    * bytes are copied from the previous container, only the block header is rewritten. The new container always gets
+    * the block hashes, so it can serve as the previous one of the next compression. Compressing a new version of an
+    * input that changed by 1% then costs about 1% of a full compression, plus hashing.
+    * @param input      - the input memory block of n bytes.
+    * @param n          - the length of the input memory block.
+    * @param params     - the compression parameters.
+    * @param write      - the output callback.
+    * @param context    - the user context passed to the output callback.
+    * @return LIBBSC_NO_ERROR if no error occurred, error code otherwise.
+    */
+    LIBBSC_API int bsc_container_compress(const unsigned char * input, long long n, const bsc_container_params * params, bsc_container_write_fn write, void * context);
+
+    /**
+    * Compresses n bytes pulled from an input callback into a bsc1 container without materializing the whole input.
+    * The calling thread reads blocks into a bounded ring of numThreads + 2 slots, numThreads compressor threads and a
+    * writer thread drain it concurrently, so disk reads, compression and output writes overlap. Peak memory is about
+    * 2 * (numThreads + 2) * blockSize whatever the size of the input. Blocks always have a fixed size here, the
+    * number of blocks is written before the input is seen so minBlockSize, cdcBlockSize, deduplicate, longRange and
+    * previous are ignored.
+    * @param read           - the input callback, must deliver exactly n bytes.
+    * @param readContext    - the user context passed to the input callback.
+    * @param n              - the length of the input, needed upfront as the container header stores the number of blocks.
+    * @param params         - the compression parameters.
+    * @param write          - the output callback.
+    * @param writeContext   - the user context passed to the output callback.
+    * @return LIBBSC_NO_ERROR if no error occurred, error code otherwise.
+    */
+    LIBBSC_API int bsc_container_compress_stream(bsc_container_read_fn read, void * readContext, long long n, const bsc_container_params * params, bsc_container_write_fn write, void * writeContext);
+
+    /**
+    * Decompresses a bsc1 container held in memory to a positioned output callback.
+    * The block table is built upfront (from the index footer when present, otherwise by one pass over the block headers)
+    * so every block is an independent job and workers never serialize on parsing the input. The callback has no output
+    * to copy from, so a reference decodes its block again.
+    * @param input      - the container of n bytes.
+    * @param n          - the length of the container.
+    * @param numThreads - the number of blocks decoded concurrently, 0 for all cores.
+    * @param features   - the set of additional features.
+    * @param write      - the positioned output callback, every block is written once at its offset in the original data.
+    * @param context    - the user context passed to the output callback.
+    * @return LIBBSC_NO_ERROR if no error occurred, error code otherwise.
+    */
+    LIBBSC_API int bsc_container_decompress(const unsigned char * input, long long n, int numThreads, int features, bsc_container_write_at_fn write, void * context);
+
+    /**
+    * Computes the size of the original data of a bsc1 container held in memory.
+    * @param input      - the container of n bytes.
+    * @param n          - the length of the container.
+    * @param features   - the set of additional features.
+    * @param dataSize   - receives the size of the original data.
+    * @return LIBBSC_NO_ERROR if no error occurred, error code otherwise.
+    */
+    LIBBSC_API int bsc_container_data_size(const unsigned char * input, long long n, int features, long long * dataSize);
+
+    /**
+    * Decompresses a bsc1 container held in memory into an output buffer, every block is decoded in parallel
+    * directly at its offset in the output, no intermediate copy is made. References are then copied from the output.
+    * @param input      - the container of n bytes.
+    * @param n          - the length of the container.
+    * @param output     - the output buffer, see @ref bsc_container_data_size.
+    * @param outputSize - the size of the output buffer.
+    * @param numThreads - the number of blocks decoded concurrently, 0 for all cores.
+    * @param features   - the set of additional features.
+    * @return LIBBSC_NO_ERROR if no error occurred, error code otherwise.
+    */
+    LIBBSC_API int bsc_container_decompress_buffer(const unsigned char * input, long long n, unsigned char * output, long long outputSize, int numThreads, int features);
+
+    /**
+    * Decompresses a bsc1 container pulled from an input callback to a forward-only output callback.
+    * Blocks are decoded in parallel into a bounded reorder ring and written strictly in order of their offset,
+    * the first block is written as soon as it is decoded. Memory is bounded by 2 * numThreads blocks, plus a copy of
+    * every referenced block of a "bsc2" or "bsc3" container until its last reference is written.
+    * @param read           - the input callback.
+    * @param readContext    - the user context passed to the input callback.
+    * @param numThreads     - the number of blocks decoded concurrently, 0 for all cores.
+    * @param features       - the set of additional features.
+    * @param write          - the output callback.
+    * @param writeContext   - the user context passed to the output callback.
+    * @return LIBBSC_NO_ERROR if no error occurred, LIBBSC_NOT_SUPPORTED if blocks are too far out of order for the ring, error code otherwise.
+    */
+    LIBBSC_API int bsc_container_decompress_stream(bsc_container_read_fn read, void * readContext, int numThreads, int features, bsc_container_write_fn write, void * writeContext);
+
+    /**
+    * Decompresses length bytes starting at offset of the original data, only the blocks touching the range are read and decoded.
+    * The block table comes from the index footer when present, otherwise it is rebuilt by walking the block headers.
+    * @param read           - the random access input callback.
+    * @param readContext    - the user context passed to the input callback.
+    * @param size           - the size of the container in bytes.
+    * @param offset         - the offset in the original data of the first byte to decompress.
+    * @param length         - the number of bytes to decompress.
+    * @param numThreads     - the number of blocks decoded concurrently, 0 for all cores.
+    * @param features       - the set of additional features.
+    * @param write          - the output callback, receives exactly length bytes in order.
+    * @param writeContext   - the user context passed to the output callback.
+    * @return LIBBSC_NO_ERROR if no error occurred, LIBBSC_BAD_PARAMETER if the range is outside of the data, error code otherwise.
+    */
+    LIBBSC_API int bsc_container_decompress_range(bsc_container_read_at_fn read, void * readContext, long long size, long long offset, long long length, int numThreads, int features, bsc_container_write_fn write, void * writeContext);
+
+    /**
+    * Compresses a file into a bsc1 container file. On POSIX systems the input is memory mapped with read-ahead hints
+    * and every block worker reads its slice straight from the mapping, the output is a mapping sized for the worst case
+    * and trimmed to the written length. Elsewhere the file is streamed through @ref bsc_container_compress_stream.
+    * An empty input file, or an output naming the input file, is rejected before the output is created, the output
+    * is removed on any later error.
+    * @param inputFile  - the path of the file to compress.
+    * @param outputFile - the path of the container to create or overwrite.
+    * @param params     - the compression parameters.
+    * @return LIBBSC_NO_ERROR if no error occurred, LIBBSC_CONTAINER_IO_ERROR if a file cannot be accessed,
+    *         LIBBSC_BAD_PARAMETER if the input file is empty or is the output file, error code otherwise.
+    */
+    LIBBSC_API int bsc_container_compress_file(const char * inputFile, const char * outputFile, const bsc_container_params * params);
+
+    /**
+    * Decompresses a bsc1 container file. On POSIX systems both files are memory mapped, the output is sized upfront and
+    * every block is decoded in parallel straight at its offset. Elsewhere it goes through @ref bsc_container_decompress_stream.
+    * @param inputFile  - the path of the container to decompress.
+    * @param outputFile - the path of the file to create or overwrite.
+    * @param numThreads - the number of blocks decoded concurrently, 0 for all cores.
+    * @param features   - the set of additional features.
+    * @return LIBBSC_NO_ERROR if no error occurred, LIBBSC_CONTAINER_IO_ERROR if a file cannot be accessed,
+    *         LIBBSC_BAD_PARAMETER if the output file is the input file, error code otherwise.
+    */
+    LIBBSC_API int bsc_container_decompress_file(const char * inputFile, const char * outputFile, int numThreads, int features);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/*-----------------------------------------------------------*/
+/* End                                           container.h */
+/*-----------------------------------------------------------*/
@@ -0,0 +1,391 @@
+/*-----------------------------------------------------------*/
+/* Block Sorting, Lossless Data Compression Library.         */
+/* File to file bsc1 container functions                     */
+/*-----------------------------------------------------------*/
+
+/*--
+
+This file is a part of LibBSC Sharp, a .NET port of bsc and libbsc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+--*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "container.h"
+
+#include "../platform/platform.h"
+#include "../libbsc.h"
+
+#if defined(__unix__) || defined(__unix) || defined(__APPLE__)
+    #define LIBBSC_CONTAINER_MMAP
+
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <sys/types.h>
+    #include <unistd.h>
+#elif defined(_WIN32)
+    #include <io.h>
+    #include <windows.h>
+#endif
+
+#ifdef LIBBSC_CONTAINER_MMAP
+
+typedef struct bsc_container_mapping
+{
+    unsigned char * data;
+    long long       capacity;
+    long long       size;
+} bsc_container_mapping;
+
+static int bsc_container_write_mapping(void * context, const unsigned char * data, int size)
+{
+    bsc_container_mapping * mapping = (bsc_container_mapping *)context;
+    if (size > mapping->capacity - mapping->size)
+    {
+        return LIBBSC_UNEXPECTED_EOB;
+    }
+
+    memcpy(mapping->data + mapping->size, data, size);
+    mapping->size += size;
+
+    return LIBBSC_NO_ERROR;
+}
+
+/**
+* Maps a whole file read-only and hints the kernel to start reading it ahead.
+* @return LIBBSC_NO_ERROR if no error occurred, error code otherwise. *data is NULL for an empty file.
+*/
+static int bsc_container_map_input(const char * file, int advice, int * fd, unsigned char ** data, long long * n)
+{
+    *data = NULL; *n = 0;
+
+    *fd = open(file, O_RDONLY);
+    if (*fd < 0)
+    {
+        return LIBBSC_CONTAINER_IO_ERROR;
+    }
+
+    struct stat status;
+    if (fstat(*fd, &status) != 0)
+    {
+        return LIBBSC_CONTAINER_IO_ERROR;
+    }
+
+    *n = (long long)status.st_size;
+    if (*n > 0)
+    {
+        void * address = mmap(NULL, (size_t)*n, PROT_READ, MAP_PRIVATE, *fd, 0);
+        if (address == MAP_FAILED)
+        {
+            return LIBBSC_CONTAINER_IO_ERROR;
+        }
+
+        *data = (unsigned char *)address;
+
+        // Hints only, a kernel that ignores them still serves the mapping correctly
+        madvise(address, (size_t)*n, advice);
+        madvise(address, (size_t)*n, MADV_WILLNEED);
+    }
+
+    return LIBBSC_NO_ERROR;
+}
+
+/**
+* Creates or truncates a file to size bytes and maps it writable.
+* @return LIBBSC_NO_ERROR if no error occurred, error code otherwise. *data is NULL for an empty file.
+*/
+static int bsc_container_map_output(const char * file, long long size, int * fd, unsigned char ** data)
+{
+    *data = NULL;
+
+    *fd = open(file, O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if (*fd < 0 || ftruncate(*fd, (off_t)size) != 0)
+    {
+        return LIBBSC_CONTAINER_IO_ERROR;
+    }
+
+    if (size > 0)
+    {
+        void * address = mmap(NULL, (size_t)size, PROT_READ | PROT_WRITE, MAP_SHARED, *fd, 0);
+        if (address == MAP_FAILED)
+        {
+            return LIBBSC_CONTAINER_IO_ERROR;
+        }
+
+        *data = (unsigned char *)address;
+    }
+
+    return LIBBSC_NO_ERROR;
+}
+
+static void bsc_container_unmap(int fd, unsigned char * data, long long size)
+{
+    if (data != NULL) munmap(data, (size_t)size);
+    if (fd >= 0) close(fd);
+}
+
+/**
+* Tells whether the output path names the open input file, through another name or a link included. Truncating it
+* would wipe the mapped input before it is read.
+*/
+static bool bsc_container_same_file(int inputFd, const char * outputFile)
+{
+    struct stat inputStatus, outputStatus;
+    if (fstat(inputFd, &inputStatus) != 0 || stat(outputFile, &outputStatus) != 0)
+    {
+        return false;
+    }
+
+    return inputStatus.st_dev == outputStatus.st_dev && inputStatus.st_ino == outputStatus.st_ino;
+}
+
+int bsc_container_compress_file(const char * inputFile, const char * outputFile, const bsc_container_params * params)
+{
+    if (inputFile == NULL || outputFile == NULL || params == NULL || params->blockSize <= 0)
+    {
+        return LIBBSC_BAD_PARAMETER;
+    }
+
+    int             inputFd     = -1;
+    unsigned char * input       = NULL;
+    long long       n           = 0;
+
+    int result = bsc_container_map_input(inputFile, MADV_SEQUENTIAL, &inputFd, &input, &n);
+    if (result == LIBBSC_NO_ERROR && (n == 0 || bsc_container_same_file(inputFd, outputFile)))
+    {
+        result = LIBBSC_BAD_PARAMETER;
+    }
+
+    if (result != LIBBSC_NO_ERROR)
+    {
+        bsc_container_unmap(inputFd, input, n);
+        return result;
+    }
+
+    // Stored blocks are the worst case, so the output can be sized once and trimmed to the written length afterwards
+    long long capacity = bsc_container_compress_bound(n, params);
+
+    int                     outputFd    = -1;
+    bsc_container_mapping   mapping     = { NULL, capacity, 0 };
+
+    result = bsc_container_map_output(outputFile, capacity, &outputFd, &mapping.data);
+    if (result == LIBBSC_NO_ERROR)
+    {
+        madvise(mapping.data, (size_t)capacity, MADV_SEQUENTIAL);
+
+        result = bsc_container_compress(input, n, params, bsc_container_write_mapping, &mapping);
+    }
+
+    bsc_container_unmap(-1, mapping.data, capacity);
+    if (outputFd >= 0 && ftruncate(outputFd, (off_t)mapping.size) != 0 && result == LIBBSC_NO_ERROR)
+    {
+        result = LIBBSC_CONTAINER_IO_ERROR;
+    }
+
+    bsc_container_unmap(outputFd, NULL, 0);
+    bsc_container_unmap(inputFd, input, n);
+
+    // A truncated container must not be mistaken for a valid one
+    if (result != LIBBSC_NO_ERROR && outputFd >= 0) unlink(outputFile);
+
+    return result;
+}
+
+int bsc_container_decompress_file(const char * inputFile, const char * outputFile, int numThreads, int features)
+{
+    if (inputFile == NULL || outputFile == NULL)
+    {
+        return LIBBSC_BAD_PARAMETER;
+    }
+
+    int             inputFd     = -1;
+    unsigned char * input       = NULL;
+    long long       n           = 0;
+    long long       dataSize    = 0;
+
+    // Workers pick blocks all over the file, read-ahead is requested for the whole mapping instead of sequential access
+    int result = bsc_container_map_input(inputFile, MADV_NORMAL, &inputFd, &input, &n);
+    if (result == LIBBSC_NO_ERROR)
+    {
+        result = n > 0 ? bsc_container_data_size(input, n, features, &dataSize) : LIBBSC_UNEXPECTED_EOB;
+    }
+
+    if (result == LIBBSC_NO_ERROR && bsc_container_same_file(inputFd, outputFile))
+    {
+        result = LIBBSC_BAD_PARAMETER;
+    }
+
+    int             outputFd    = -1;
+    unsigned char * output      = NULL;
+
+    if (result == LIBBSC_NO_ERROR)
+    {
+        result = bsc_container_map_output(outputFile, dataSize, &outputFd, &output);
+    }
+
+    if (result == LIBBSC_NO_ERROR && output != NULL)
+    {
+        result = bsc_container_decompress_buffer(input, n, output, dataSize, numThreads, features);
+    }
+
+    bsc_container_unmap(outputFd, output, dataSize);
+    bsc_container_unmap(inputFd, input, n);
+
+    if (result != LIBBSC_NO_ERROR && outputFd >= 0) unlink(outputFile);
+
+    return result;
+}
+
+#else
+
+static int bsc_container_read_file(void * context, unsigned char * buffer, int size)
+{
+    FILE * file = (FILE *)context;
+
+    size_t result = fread(buffer, 1, (size_t)size, file);
+    if (result == 0 && ferror(file))
+    {
+        return LIBBSC_CONTAINER_IO_ERROR;
+    }
+
+    return (int)result;
+}
+
+static int bsc_container_write_file(void * context, const unsigned char * data, int size)
+{
+    return fwrite(data, 1, (size_t)size, (FILE *)context) == (size_t)size ? LIBBSC_NO_ERROR : LIBBSC_CONTAINER_IO_ERROR;
+}
+
+static long long bsc_container_file_size(FILE * file)
+{
+#if defined(_MSC_VER)
+    if (_fseeki64(file, 0, SEEK_END) != 0) return -1;
+    long long size = _ftelli64(file);
+    if (_fseeki64(file, 0, SEEK_SET) != 0) return -1;
+#else
+    if (fseek(file, 0, SEEK_END) != 0) return -1;
+    long long size = ftell(file);
+    if (fseek(file, 0, SEEK_SET) != 0) return -1;
+#endif
+
+    return size;
+}
+
+/**
+* Tells whether the output path names the open input file, opening it for writing would truncate the input.
+*/
+static bool bsc_container_same_file(FILE * input, const char * outputFile)
+{
+#if defined(_WIN32)
+    HANDLE output = CreateFileA(outputFile, 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL);
+    if (output == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    BY_HANDLE_FILE_INFORMATION inputInfo, outputInfo;
+
+    bool same = GetFileInformationByHandle((HANDLE)_get_osfhandle(_fileno(input)), &inputInfo) && GetFileInformationByHandle(output, &outputInfo)
+        && inputInfo.dwVolumeSerialNumber == outputInfo.dwVolumeSerialNumber
+        && inputInfo.nFileIndexHigh == outputInfo.nFileIndexHigh && inputInfo.nFileIndexLow == outputInfo.nFileIndexLow;
+
+    CloseHandle(output);
+
+    return same;
+#else
+    (void)input; (void)outputFile; return false;
+#endif
+}
+
+static int bsc_container_close_files(FILE * input, FILE * output, const char * outputFile, int result)
+{
+    if (output != NULL && fclose(output) != 0 && result == LIBBSC_NO_ERROR) result = LIBBSC_CONTAINER_IO_ERROR;
+    if (input != NULL) fclose(input);
+
+    // A truncated output must not be mistaken for a valid one
+    if (output != NULL && result != LIBBSC_NO_ERROR) remove(outputFile);
+
+    return result;
+}
+
+int bsc_container_compress_file(const char * inputFile, const char * outputFile, const bsc_container_params * params)
+{
+    if (inputFile == NULL || outputFile == NULL || params == NULL || params->blockSize <= 0)
+    {
+        return LIBBSC_BAD_PARAMETER;
+    }
+
+    // No memory mapping on this platform, the streaming pipeline keeps memory bounded instead
+    FILE * input = fopen(inputFile, "rb");
+    if (input == NULL)
+    {
+        return LIBBSC_CONTAINER_IO_ERROR;
+    }
+
+    // An empty file is rejected before the output is created, as with the memory mapped input
+    long long n = bsc_container_file_size(input);
+    if (n <= 0 || bsc_container_same_file(input, outputFile))
+    {
+        return bsc_container_close_files(input, NULL, NULL, n < 0 ? LIBBSC_CONTAINER_IO_ERROR : LIBBSC_BAD_PARAMETER);
+    }
+
+    FILE * output = fopen(outputFile, "wb");
+    if (output == NULL)
+    {
+        return bsc_container_close_files(input, NULL, NULL, LIBBSC_CONTAINER_IO_ERROR);
+    }
+
+    int result = bsc_container_compress_stream(bsc_container_read_file, input, n, params, bsc_container_write_file, output);
+
+    return bsc_container_close_files(input, output, outputFile, result);
+}
+
+int bsc_container_decompress_file(const char * inputFile, const char * outputFile, int numThreads, int features)
+{
+    if (inputFile == NULL || outputFile == NULL)
+    {
+        return LIBBSC_BAD_PARAMETER;
+    }
+
+    FILE * input = fopen(inputFile, "rb");
+    if (input == NULL)
+    {
+        return LIBBSC_CONTAINER_IO_ERROR;
+    }
+
+    if (bsc_container_same_file(input, outputFile))
+    {
+        return bsc_container_close_files(input, NULL, NULL, LIBBSC_BAD_PARAMETER);
+    }
+
+    FILE * output = fopen(outputFile, "wb");
+    if (output == NULL)
+    {
+        return bsc_container_close_files(input, NULL, NULL, LIBBSC_CONTAINER_IO_ERROR);
+    }
+
+    int result = bsc_container_decompress_stream(bsc_container_read_file, input, numThreads, features, bsc_container_write_file, output);
+
+    return bsc_container_close_files(input, output, outputFile, result);
+}
+
+#endif
+
+/*-----------------------------------------------------------*/
+/* End                                    container_file.cpp */
+/*-----------------------------------------------------------*/
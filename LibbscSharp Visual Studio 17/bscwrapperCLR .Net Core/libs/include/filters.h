@@ -114,6 +114,43 @@ extern "C" {
     */
     LIBBSC_API int bsc_reorder_reverse(unsigned char * T, int n, int recordSize, int features);
 
+    typedef struct bsc_context bsc_context;
+
+    /**
+    * Autodetects segments with the scratch buffers of a context, see @ref bsc_detect_segments.
+    * @param context    - the context that owns the scratch buffers, NULL to use bsc_malloc.
+    * @return The number of segments if no error occurred, error code otherwise.
+    */
+    LIBBSC_API int bsc_context_detect_segments(bsc_context * context, const unsigned char * input, int n, int * segments, int k, int features);
+
+    /**
+    * Autodetects order of contexts with the scratch buffers of a context, see @ref bsc_detect_contextsorder.
+    * @param context    - the context that owns the scratch buffers, NULL to use bsc_malloc.
+    * @return The detected contexts order if no error occurred, error code otherwise.
+    */
+    LIBBSC_API int bsc_context_detect_contextsorder(bsc_context * context, const unsigned char * input, int n, int features);
+
+    /**
+    * Autodetects record size with the scratch buffers of a context, see @ref bsc_detect_recordsize.
+    * @param context    - the context that owns the scratch buffers, NULL to use bsc_malloc.
+    * @return The size of record if no error occurred, error code otherwise.
+    */
+    LIBBSC_API int bsc_context_detect_recordsize(bsc_context * context, const unsigned char * input, int n, int features);
+
+    /**
+    * Reorders memory block with the scratch buffers of a context, see @ref bsc_reorder_forward.
+    * @param context    - the context that owns the scratch buffers, NULL to use bsc_malloc.
+    * @return LIBBSC_NO_ERROR if no error occurred, error code otherwise.
+    */
+    LIBBSC_API int bsc_context_reorder_forward(bsc_context * context, unsigned char * T, int n, int recordSize, int features);
+
+    /**
+    * Reverses the reordering with the scratch buffers of a context, see @ref bsc_reorder_reverse.
+    * @param context    - the context that owns the scratch buffers, NULL to use bsc_malloc.
+    * @return LIBBSC_NO_ERROR if no error occurred, error code otherwise.
+    */
+    LIBBSC_API int bsc_context_reorder_reverse(bsc_context * context, unsigned char * T, int n, int recordSize, int features);
+
 #ifdef __cplusplus
 }
 #endif
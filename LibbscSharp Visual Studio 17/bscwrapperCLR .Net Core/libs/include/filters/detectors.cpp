@@ -287,7 +287,7 @@ int bsc_detect_segments_recursive(BscSegmentationModel * model0, BscSegmentation
     return leftResult + rightResult;
 }
 
-int bsc_detect_segments(const unsigned char * input, int n, int * segments, int k, int features)
+int bsc_context_detect_segments(bsc_context * context, const unsigned char * input, int n, int * segments, int k, int features)
 {
     if (n < DETECTORS_BLOCK_SIZE || k == 1)
     {
@@ -295,17 +295,17 @@ int bsc_detect_segments(const unsigned char * input, int n, int * segments, int
         return 1;
     }
 
-    if (BscSegmentationModel * model0 = (BscSegmentationModel *)bsc_malloc(sizeof(BscSegmentationModel)))
+    if (BscSegmentationModel * model0 = (BscSegmentationModel *)bsc_context_malloc(context, sizeof(BscSegmentationModel)))
     {
-        if (BscSegmentationModel * model1 = (BscSegmentationModel *)bsc_malloc(sizeof(BscSegmentationModel)))
+        if (BscSegmentationModel * model1 = (BscSegmentationModel *)bsc_context_malloc(context, sizeof(BscSegmentationModel)))
         {
             int result = bsc_detect_segments_recursive(model0, model1, input, n, segments, k, features);
 
-            bsc_free(model1); bsc_free(model0);
+            bsc_context_free(context, model1); bsc_context_free(context, model0);
 
             return result;
         }
-        bsc_free(model0);
+        bsc_context_free(context, model0);
     };
 
     return LIBBSC_NOT_ENOUGH_MEMORY;
@@ -357,13 +357,13 @@ static long long bsc_estimate_contextsorder(const unsigned char * input, int n)
     return entropy;
 }
 
-int bsc_detect_contextsorder(const unsigned char * RESTRICT input, int n, int features)
+int bsc_context_detect_contextsorder(bsc_context * context, const unsigned char * RESTRICT input, int n, int features)
 {
     int sortingContexts = LIBBSC_NOT_ENOUGH_MEMORY;
 
     if ((n > DETECTORS_NUM_BLOCKS * DETECTORS_BLOCK_SIZE) && (features & LIBBSC_FEATURE_FASTMODE))
     {
-        if (unsigned char * buffer = (unsigned char *)bsc_malloc(DETECTORS_NUM_BLOCKS * DETECTORS_BLOCK_SIZE * sizeof(unsigned char)))
+        if (unsigned char * buffer = (unsigned char *)bsc_context_malloc(context, DETECTORS_NUM_BLOCKS * DETECTORS_BLOCK_SIZE * sizeof(unsigned char)))
         {
             int blockStride = (((n - DETECTORS_NUM_BLOCKS * DETECTORS_BLOCK_SIZE) / DETECTORS_NUM_BLOCKS) / 48) * 48;
 
@@ -372,19 +372,19 @@ int bsc_detect_contextsorder(const unsigned char * RESTRICT input, int n, int fe
                 memcpy(buffer + block * DETECTORS_BLOCK_SIZE, input + block * (DETECTORS_BLOCK_SIZE + blockStride), DETECTORS_BLOCK_SIZE);
             }
 
-            sortingContexts = bsc_detect_contextsorder(buffer, DETECTORS_NUM_BLOCKS * DETECTORS_BLOCK_SIZE, features);
+            sortingContexts = bsc_context_detect_contextsorder(context, buffer, DETECTORS_NUM_BLOCKS * DETECTORS_BLOCK_SIZE, features);
 
-            bsc_free(buffer);
+            bsc_context_free(context, buffer);
         }
 
         return sortingContexts;
     }
 
-    if (unsigned char * RESTRICT buffer = (unsigned char *)bsc_malloc(n * sizeof(unsigned char)))
+    if (unsigned char * RESTRICT buffer = (unsigned char *)bsc_context_malloc(context, n * sizeof(unsigned char)))
     {
-        if (int * RESTRICT bucket0 = (int *)bsc_zero_malloc(ALPHABET_SIZE * ALPHABET_SIZE * sizeof(int)))
+        if (int * RESTRICT bucket0 = (int *)bsc_context_zero_malloc(context, ALPHABET_SIZE * ALPHABET_SIZE * sizeof(int)))
         {
-            if (int * RESTRICT bucket1 = (int *)bsc_zero_malloc(ALPHABET_SIZE * ALPHABET_SIZE * sizeof(int)))
+            if (int * RESTRICT bucket1 = (int *)bsc_context_zero_malloc(context, ALPHABET_SIZE * ALPHABET_SIZE * sizeof(int)))
             {
                 unsigned char C0 = input[n - 1];
                 for (int i = 0; i < n; ++i)
@@ -429,11 +429,11 @@ int bsc_detect_contextsorder(const unsigned char * RESTRICT input, int n, int fe
 
                 sortingContexts = (preceding < following) ? LIBBSC_CONTEXTS_PRECEDING : LIBBSC_CONTEXTS_FOLLOWING;
 
-                bsc_free(bucket1);
+                bsc_context_free(context, bucket1);
             }
-            bsc_free(bucket0);
+            bsc_context_free(context, bucket0);
         };
-        bsc_free(buffer);
+        bsc_context_free(context, buffer);
     }
 
     return sortingContexts;
@@ -458,13 +458,13 @@ long long bsc_estimate_reordering(BscReorderingModel * model, int recordSize)
     return entropy;
 }
 
-int bsc_detect_recordsize(const unsigned char * RESTRICT input, int n, int features)
+int bsc_context_detect_recordsize(bsc_context * context, const unsigned char * RESTRICT input, int n, int features)
 {
     int result = LIBBSC_NOT_ENOUGH_MEMORY;
 
     if ((n > DETECTORS_NUM_BLOCKS * DETECTORS_BLOCK_SIZE) && (features & LIBBSC_FEATURE_FASTMODE))
     {
-        if (unsigned char * buffer = (unsigned char *)bsc_malloc(DETECTORS_NUM_BLOCKS * DETECTORS_BLOCK_SIZE * sizeof(unsigned char)))
+        if (unsigned char * buffer = (unsigned char *)bsc_context_malloc(context, DETECTORS_NUM_BLOCKS * DETECTORS_BLOCK_SIZE * sizeof(unsigned char)))
         {
             int blockStride = (((n - DETECTORS_NUM_BLOCKS * DETECTORS_BLOCK_SIZE) / DETECTORS_NUM_BLOCKS) / 48) * 48;
 
@@ -473,15 +473,15 @@ int bsc_detect_recordsize(const unsigned char * RESTRICT input, int n, int featu
                 memcpy(buffer + block * DETECTORS_BLOCK_SIZE, input + block * (DETECTORS_BLOCK_SIZE + blockStride), DETECTORS_BLOCK_SIZE);
             }
 
-            result = bsc_detect_recordsize(buffer, DETECTORS_NUM_BLOCKS * DETECTORS_BLOCK_SIZE, features);
+            result = bsc_context_detect_recordsize(context, buffer, DETECTORS_NUM_BLOCKS * DETECTORS_BLOCK_SIZE, features);
 
-            bsc_free(buffer);
+            bsc_context_free(context, buffer);
         }
 
         return result;
     }
 
-    if (BscReorderingModel * RESTRICT model = (BscReorderingModel *)bsc_malloc(sizeof(BscReorderingModel)))
+    if (BscReorderingModel * RESTRICT model = (BscReorderingModel *)bsc_context_malloc(context, sizeof(BscReorderingModel)))
     {
         long long Entropy[DETECTORS_MAX_RECORD_SIZE];
 
@@ -574,12 +574,27 @@ int bsc_detect_recordsize(const unsigned char * RESTRICT input, int n, int featu
             if (bestSize > Entropy[recordSize - 1]) { bestSize = Entropy[recordSize - 1]; result = recordSize; }
         }
 
-        bsc_free(model);
+        bsc_context_free(context, model);
     };
 
     return result;
 }
 
+int bsc_detect_segments(const unsigned char * input, int n, int * segments, int k, int features)
+{
+    return bsc_context_detect_segments(NULL, input, n, segments, k, features);
+}
+
+int bsc_detect_contextsorder(const unsigned char * RESTRICT input, int n, int features)
+{
+    return bsc_context_detect_contextsorder(NULL, input, n, features);
+}
+
+int bsc_detect_recordsize(const unsigned char * RESTRICT input, int n, int features)
+{
+    return bsc_context_detect_recordsize(NULL, input, n, features);
+}
+
 /*-------------------------------------------------*/
 /* End                               detectors.cpp */
 /*-------------------------------------------------*/
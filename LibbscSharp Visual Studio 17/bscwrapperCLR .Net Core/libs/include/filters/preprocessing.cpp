@@ -65,12 +65,12 @@ int bsc_reverse_block(unsigned char * T, int n, int features)
     return LIBBSC_NO_ERROR;
 }
 
-int bsc_reorder_forward(unsigned char * T, int n, int recordSize, int features)
+int bsc_context_reorder_forward(bsc_context * context, unsigned char * T, int n, int recordSize, int features)
 {
     if (recordSize <= 0) return LIBBSC_BAD_PARAMETER;
     if (recordSize == 1) return LIBBSC_NO_ERROR;
 
-    if (unsigned char * buffer = (unsigned char *)bsc_malloc(n))
+    if (unsigned char * buffer = (unsigned char *)bsc_context_malloc(context, n))
     {
         memcpy(buffer, T, n);
 
@@ -114,18 +114,18 @@ int bsc_reorder_forward(unsigned char * T, int n, int recordSize, int features)
             }
         }
 
-        bsc_free(buffer); return LIBBSC_NO_ERROR;
+        bsc_context_free(context, buffer); return LIBBSC_NO_ERROR;
     }
 
     return LIBBSC_NOT_ENOUGH_MEMORY;
 }
 
-int bsc_reorder_reverse(unsigned char * T, int n, int recordSize, int features)
+int bsc_context_reorder_reverse(bsc_context * context, unsigned char * T, int n, int recordSize, int features)
 {
     if (recordSize <= 0) return LIBBSC_BAD_PARAMETER;
     if (recordSize == 1) return LIBBSC_NO_ERROR;
 
-    if (unsigned char * buffer = (unsigned char *)bsc_malloc(n))
+    if (unsigned char * buffer = (unsigned char *)bsc_context_malloc(context, n))
     {
         memcpy(buffer, T, n);
 
@@ -169,12 +169,22 @@ int bsc_reorder_reverse(unsigned char * T, int n, int recordSize, int features)
             }
         }
 
-        bsc_free(buffer); return LIBBSC_NO_ERROR;
+        bsc_context_free(context, buffer); return LIBBSC_NO_ERROR;
     }
 
     return LIBBSC_NOT_ENOUGH_MEMORY;
 }
 
+int bsc_reorder_forward(unsigned char * T, int n, int recordSize, int features)
+{
+    return bsc_context_reorder_forward(NULL, T, n, recordSize, features);
+}
+
+int bsc_reorder_reverse(unsigned char * T, int n, int recordSize, int features)
+{
+    return bsc_context_reorder_reverse(NULL, T, n, recordSize, features);
+}
+
 /*-------------------------------------------------*/
 /* End                           preprocessing.cpp */
 /*-------------------------------------------------*/
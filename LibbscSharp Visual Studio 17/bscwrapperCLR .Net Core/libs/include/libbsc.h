@@ -75,6 +75,14 @@ See also the bsc and libbsc web site:
 #define LIBBSC_FEATURE_LARGEPAGES      4
 #define LIBBSC_FEATURE_CUDA            8
 
+/* LZP keeps 4-way buckets of candidates instead of one position per hash slot, the choice is stored in the block header. */
+#define LIBBSC_FEATURE_LZPBUCKETS      16
+
+/* Bits 16..23 of the features hold the number of LZP and QLFC sub-blocks, 0 for the default of up to 8. */
+#define LIBBSC_FEATURE_SUBBLOCKS(n)         (((n) & 0xff) << 16)
+#define LIBBSC_FEATURE_SUBBLOCKS_COUNT(f)   (((f) >> 16) & 0xff)
+#define LIBBSC_MAX_SUBBLOCKS                255
+
 #define LIBBSC_DEFAULT_LZPHASHSIZE     15
 #define LIBBSC_DEFAULT_LZPMINLEN       128
 #define LIBBSC_DEFAULT_BLOCKSORTER     LIBBSC_BLOCKSORTER_BWT
@@ -167,6 +175,48 @@ extern "C" {
     */
     LIBBSC_API int bsc_decompress(const unsigned char * input, int inputSize, unsigned char * output, int outputSize, int features);
 
+    typedef struct bsc_context bsc_context;
+
+    /**
+    * Creates a compression context that keeps the scratch buffers of LZP, BWT, ST and the entropy coders between calls.
+    * A context can be used by one call at a time, give every worker thread its own context.
+    * @param features                           - the set of additional features, contexts with LIBBSC_FEATURE_MULTITHREADING are locked internally.
+    * @return the context, or NULL if there is insufficient memory available.
+    */
+    LIBBSC_API bsc_context * bsc_context_create(int features);
+
+    /**
+    * Creates a compression context whose buffers come from its own allocator instead of the one installed by
+    * @ref bsc_init_full, so concurrent requests can use different arenas or memory limits.
+    * @param features                           - the set of additional features.
+    * @param malloc                             - function to use to allocate buffers, NULL for bsc_malloc.
+    * @param zero_malloc                        - function to use to allocate zero-filled buffers, NULL to clear buffers from malloc.
+    * @param free                               - function used to free buffers, must be set if and only if malloc is set.
+    * @param user                               - the pointer passed as the first argument of the allocator functions.
+    * @return the context, or NULL if there is insufficient memory available or the functions are inconsistent.
+    */
+    LIBBSC_API bsc_context * bsc_context_create_full(int features, void* (* malloc)(void* user, size_t size), void* (* zero_malloc)(void* user, size_t size), void (* free)(void* user, void* address), void* user);
+
+    /**
+    * Releases a compression context and all the buffers it kept.
+    * @param context                            - the context to destroy, can be NULL.
+    */
+    LIBBSC_API void bsc_context_destroy(bsc_context * context);
+
+    /**
+    * Compress a memory block reusing the scratch buffers of a context, see @ref bsc_compress.
+    * @param context                            - the context that owns the scratch buffers, NULL to allocate them per call.
+    * @return the length of compressed memory block if no error occurred, error code otherwise.
+    */
+    LIBBSC_API int bsc_context_compress(bsc_context * context, const unsigned char * input, unsigned char * output, int n, int lzpHashSize, int lzpMinLen, int blockSorter, int coder, int features);
+
+    /**
+    * Decompress a memory block reusing the scratch buffers of a context, see @ref bsc_decompress.
+    * @param context                            - the context that owns the scratch buffers, NULL to allocate them per call.
+    * @return LIBBSC_NO_ERROR if no error occurred, error code otherwise.
+    */
+    LIBBSC_API int bsc_context_decompress(bsc_context * context, const unsigned char * input, int inputSize, unsigned char * output, int outputSize, int features);
+
 #ifdef __cplusplus
 }
 #endif
@@ -43,6 +43,9 @@ See also the bsc and libbsc web site:
 #include "../coder/coder.h"
 #include "../st/st.h"
 
+/* Bit 24 of the mode word marks blocks whose LZP was done with the bucketed match finder. */
+#define LIBBSC_MODE_LZPBUCKETS         (1 << 24)
+
 int bsc_init_full(int features, void* (* malloc)(size_t size), void* (* zero_malloc)(size_t size), void (* free)(void* address))
 {
     int result = LIBBSC_NO_ERROR;
@@ -80,7 +83,7 @@ int bsc_store(const unsigned char * input, unsigned char * output, int n, int fe
     return n + LIBBSC_HEADER_SIZE;
 }
 
-int bsc_compress_inplace(unsigned char * data, int n, int lzpHashSize, int lzpMinLen, int blockSorter, int coder, int features)
+static int bsc_compress_inplace(bsc_context * context, unsigned char * data, int n, int lzpHashSize, int lzpMinLen, int blockSorter, int coder, int features)
 {
     int             indexes[256];
     unsigned char   num_indexes;
@@ -120,6 +123,7 @@ int bsc_compress_inplace(unsigned char * data, int n, int lzpHashSize, int lzpMi
         if (lzpHashSize < 10 || lzpHashSize > 28) return LIBBSC_BAD_PARAMETER;
         mode += (lzpMinLen << 8);
         mode += (lzpHashSize << 16);
+        mode += (features & LIBBSC_FEATURE_LZPBUCKETS) ? LIBBSC_MODE_LZPBUCKETS : 0;
     }
     if (n < 0 || n > 2146435072) return LIBBSC_BAD_PARAMETER;
     if (n <= LIBBSC_HEADER_SIZE)
@@ -132,10 +136,10 @@ int bsc_compress_inplace(unsigned char * data, int n, int lzpHashSize, int lzpMi
     int lzSize = n;
     if (mode != (mode & 0xff))
     {
-        unsigned char * buffer = (unsigned char *)bsc_malloc(n);
+        unsigned char * buffer = (unsigned char *)bsc_context_malloc(context, n);
         if (buffer == NULL) return LIBBSC_NOT_ENOUGH_MEMORY;
 
-        lzSize = bsc_lzp_compress(data, buffer, n, lzpHashSize, lzpMinLen, features);
+        lzSize = bsc_lzp_compress(data, buffer, n, lzpHashSize, lzpMinLen, features, context);
         if (lzSize < LIBBSC_NO_ERROR)
         {
             lzSize = n; mode &= 0xff;
@@ -145,7 +149,7 @@ int bsc_compress_inplace(unsigned char * data, int n, int lzpHashSize, int lzpMi
             memcpy(data, buffer, lzSize);
         }
 
-        bsc_free(buffer);
+        bsc_context_free(context, buffer);
     }
 
     if (lzSize <= LIBBSC_HEADER_SIZE)
@@ -157,16 +161,16 @@ int bsc_compress_inplace(unsigned char * data, int n, int lzpHashSize, int lzpMi
     int index = LIBBSC_BAD_PARAMETER; num_indexes = 0;
     switch (blockSorter)
     {
-        case LIBBSC_BLOCKSORTER_BWT : index = bsc_bwt_encode(data, lzSize, &num_indexes, indexes, features); break;
+        case LIBBSC_BLOCKSORTER_BWT : index = bsc_bwt_encode(data, lzSize, &num_indexes, indexes, features, context); break;
 
 #ifndef LIBBSC_NO_SORT_TRANSFORM
 
-        case LIBBSC_BLOCKSORTER_ST3 : index = bsc_st_encode(data, lzSize, 3, features); break;
-        case LIBBSC_BLOCKSORTER_ST4 : index = bsc_st_encode(data, lzSize, 4, features); break;
-        case LIBBSC_BLOCKSORTER_ST5 : index = bsc_st_encode(data, lzSize, 5, features); break;
-        case LIBBSC_BLOCKSORTER_ST6 : index = bsc_st_encode(data, lzSize, 6, features); break;
-        case LIBBSC_BLOCKSORTER_ST7 : index = bsc_st_encode(data, lzSize, 7, features); break;
-        case LIBBSC_BLOCKSORTER_ST8 : index = bsc_st_encode(data, lzSize, 8, features); break;
+        case LIBBSC_BLOCKSORTER_ST3 : index = bsc_st_encode(data, lzSize, 3, features, context); break;
+        case LIBBSC_BLOCKSORTER_ST4 : index = bsc_st_encode(data, lzSize, 4, features, context); break;
+        case LIBBSC_BLOCKSORTER_ST5 : index = bsc_st_encode(data, lzSize, 5, features, context); break;
+        case LIBBSC_BLOCKSORTER_ST6 : index = bsc_st_encode(data, lzSize, 6, features, context); break;
+        case LIBBSC_BLOCKSORTER_ST7 : index = bsc_st_encode(data, lzSize, 7, features, context); break;
+        case LIBBSC_BLOCKSORTER_ST8 : index = bsc_st_encode(data, lzSize, 8, features, context); break;
 
 #endif
 
@@ -180,11 +184,11 @@ int bsc_compress_inplace(unsigned char * data, int n, int lzpHashSize, int lzpMi
         return index;
     }
 
-    if (unsigned char * buffer = (unsigned char *)bsc_malloc(lzSize + 4096))
+    if (unsigned char * buffer = (unsigned char *)bsc_context_malloc(context, lzSize + 4096))
     {
-        int result = bsc_coder_compress(data, buffer, lzSize, coder, features);
+        int result = bsc_coder_compress(data, buffer, lzSize, coder, features, context);
         if (result >= LIBBSC_NO_ERROR) memcpy(data + LIBBSC_HEADER_SIZE, buffer, result);
-        bsc_free(buffer);
+        bsc_context_free(context, buffer);
         if ((result < LIBBSC_NO_ERROR) || (result + 1 + 4 * num_indexes >= n))
         {
             return LIBBSC_NOT_COMPRESSIBLE;
@@ -210,11 +214,11 @@ int bsc_compress_inplace(unsigned char * data, int n, int lzpHashSize, int lzpMi
     return LIBBSC_NOT_ENOUGH_MEMORY;
 }
 
-int bsc_compress(const unsigned char * input, unsigned char * output, int n, int lzpHashSize, int lzpMinLen, int blockSorter, int coder, int features)
+int bsc_context_compress(bsc_context * context, const unsigned char * input, unsigned char * output, int n, int lzpHashSize, int lzpMinLen, int blockSorter, int coder, int features)
 {
     if (input == output)
     {
-        return bsc_compress_inplace(output, n, lzpHashSize, lzpMinLen, blockSorter, coder, features);
+        return bsc_compress_inplace(context, output, n, lzpHashSize, lzpMinLen, blockSorter, coder, features);
     }
 
     int             indexes[256];
@@ -255,6 +259,7 @@ int bsc_compress(const unsigned char * input, unsigned char * output, int n, int
         if (lzpHashSize < 10 || lzpHashSize > 28) return LIBBSC_BAD_PARAMETER;
         mode += (lzpMinLen << 8);
         mode += (lzpHashSize << 16);
+        mode += (features & LIBBSC_FEATURE_LZPBUCKETS) ? LIBBSC_MODE_LZPBUCKETS : 0;
     }
     if (n < 0 || n > 1073741824) return LIBBSC_BAD_PARAMETER;
     if (n <= LIBBSC_HEADER_SIZE)
@@ -264,7 +269,7 @@ int bsc_compress(const unsigned char * input, unsigned char * output, int n, int
     int lzSize = 0;
     if (mode != (mode & 0xff))
     {
-        lzSize = bsc_lzp_compress(input, output, n, lzpHashSize, lzpMinLen, features);
+        lzSize = bsc_lzp_compress(input, output, n, lzpHashSize, lzpMinLen, features, context);
         if (lzSize < LIBBSC_NO_ERROR)
         {
             mode &= 0xff;
@@ -284,16 +289,16 @@ int bsc_compress(const unsigned char * input, unsigned char * output, int n, int
     int index = LIBBSC_BAD_PARAMETER; num_indexes = 0;
     switch (blockSorter)
     {
-        case LIBBSC_BLOCKSORTER_BWT : index = bsc_bwt_encode(output, lzSize, &num_indexes, indexes, features); break;
+        case LIBBSC_BLOCKSORTER_BWT : index = bsc_bwt_encode(output, lzSize, &num_indexes, indexes, features, context); break;
 
 #ifndef LIBBSC_NO_SORT_TRANSFORM
 
-        case LIBBSC_BLOCKSORTER_ST3 : index = bsc_st_encode(output, lzSize, 3, features); break;
-        case LIBBSC_BLOCKSORTER_ST4 : index = bsc_st_encode(output, lzSize, 4, features); break;
-        case LIBBSC_BLOCKSORTER_ST5 : index = bsc_st_encode(output, lzSize, 5, features); break;
-        case LIBBSC_BLOCKSORTER_ST6 : index = bsc_st_encode(output, lzSize, 6, features); break;
-        case LIBBSC_BLOCKSORTER_ST7 : index = bsc_st_encode(output, lzSize, 7, features); break;
-        case LIBBSC_BLOCKSORTER_ST8 : index = bsc_st_encode(output, lzSize, 8, features); break;
+        case LIBBSC_BLOCKSORTER_ST3 : index = bsc_st_encode(output, lzSize, 3, features, context); break;
+        case LIBBSC_BLOCKSORTER_ST4 : index = bsc_st_encode(output, lzSize, 4, features, context); break;
+        case LIBBSC_BLOCKSORTER_ST5 : index = bsc_st_encode(output, lzSize, 5, features, context); break;
+        case LIBBSC_BLOCKSORTER_ST6 : index = bsc_st_encode(output, lzSize, 6, features, context); break;
+        case LIBBSC_BLOCKSORTER_ST7 : index = bsc_st_encode(output, lzSize, 7, features, context); break;
+        case LIBBSC_BLOCKSORTER_ST8 : index = bsc_st_encode(output, lzSize, 8, features, context); break;
 
 #endif
 
@@ -307,11 +312,11 @@ int bsc_compress(const unsigned char * input, unsigned char * output, int n, int
         return index;
     }
 
-    if (unsigned char * buffer = (unsigned char *)bsc_malloc(lzSize + 4096))
+    if (unsigned char * buffer = (unsigned char *)bsc_context_malloc(context, lzSize + 4096))
     {
-        int result = bsc_coder_compress(output, buffer, lzSize, coder, features);
+        int result = bsc_coder_compress(output, buffer, lzSize, coder, features, context);
         if (result >= LIBBSC_NO_ERROR) memcpy(output + LIBBSC_HEADER_SIZE, buffer, result);
-        bsc_free(buffer);
+        bsc_context_free(context, buffer);
         if ((result < LIBBSC_NO_ERROR) || (result + 1 + 4 * num_indexes >= n))
         {
             return bsc_store(input, output, n, features);
@@ -337,6 +342,11 @@ int bsc_compress(const unsigned char * input, unsigned char * output, int n, int
     return LIBBSC_NOT_ENOUGH_MEMORY;
 }
 
+int bsc_compress(const unsigned char * input, unsigned char * output, int n, int lzpHashSize, int lzpMinLen, int blockSorter, int coder, int features)
+{
+    return bsc_context_compress(NULL, input, output, n, lzpHashSize, lzpMinLen, blockSorter, coder, features);
+}
+
 int bsc_block_info(const unsigned char * blockHeader, int headerSize, int * pBlockSize, int * pDataSize, int features)
 {
     if (headerSize < LIBBSC_HEADER_SIZE)
@@ -394,6 +404,7 @@ int bsc_block_info(const unsigned char * blockHeader, int headerSize, int * pBlo
         if (lzpHashSize < 10 || lzpHashSize > 28) return LIBBSC_DATA_CORRUPT;
         test_mode += (lzpMinLen << 8);
         test_mode += (lzpHashSize << 16);
+        test_mode += mode & LIBBSC_MODE_LZPBUCKETS;
     }
 
     if (test_mode != mode)
@@ -417,7 +428,7 @@ int bsc_block_info(const unsigned char * blockHeader, int headerSize, int * pBlo
     return LIBBSC_NO_ERROR;
 }
 
-int bsc_decompress_inplace(unsigned char * data, int inputSize, int outputSize, int features)
+static int bsc_decompress_inplace(bsc_context * context, unsigned char * data, int inputSize, int outputSize, int features)
 {
     int             indexes[256];
     unsigned char   num_indexes;
@@ -460,17 +471,18 @@ int bsc_decompress_inplace(unsigned char * data, int inputSize, int outputSize,
     int lzpMinLen    = (mode >>  8) & 0xff;
     int coder        = (mode >>  5) & 0x7;
     int blockSorter  = (mode >>  0) & 0x1f;
+    int lzpFeatures  = (features & ~LIBBSC_FEATURE_LZPBUCKETS) | ((mode & LIBBSC_MODE_LZPBUCKETS) ? LIBBSC_FEATURE_LZPBUCKETS : 0);
 
     int lzSize = LIBBSC_NO_ERROR;
     {
-        unsigned char * buffer = (unsigned char *)bsc_malloc(blockSize);
+        unsigned char * buffer = (unsigned char *)bsc_context_malloc(context, blockSize);
         if (buffer == NULL) return LIBBSC_NOT_ENOUGH_MEMORY;
 
         memcpy(buffer, data, blockSize);
 
-        lzSize = bsc_coder_decompress(buffer + LIBBSC_HEADER_SIZE, data, coder, features);
+        lzSize = bsc_coder_decompress(buffer + LIBBSC_HEADER_SIZE, data, coder, features, context);
 
-        bsc_free(buffer);
+        bsc_context_free(context, buffer);
     }
     if (lzSize < LIBBSC_NO_ERROR)
     {
@@ -480,16 +492,16 @@ int bsc_decompress_inplace(unsigned char * data, int inputSize, int outputSize,
     int result;
     switch (blockSorter)
     {
-        case LIBBSC_BLOCKSORTER_BWT : result = bsc_bwt_decode(data, lzSize, index, num_indexes, indexes, features); break;
+        case LIBBSC_BLOCKSORTER_BWT : result = bsc_bwt_decode(data, lzSize, index, num_indexes, indexes, features, context); break;
 
 #ifndef LIBBSC_NO_SORT_TRANSFORM
 
-        case LIBBSC_BLOCKSORTER_ST3 : result = bsc_st_decode(data, lzSize, 3, index, features); break;
-        case LIBBSC_BLOCKSORTER_ST4 : result = bsc_st_decode(data, lzSize, 4, index, features); break;
-        case LIBBSC_BLOCKSORTER_ST5 : result = bsc_st_decode(data, lzSize, 5, index, features); break;
-        case LIBBSC_BLOCKSORTER_ST6 : result = bsc_st_decode(data, lzSize, 6, index, features); break;
-        case LIBBSC_BLOCKSORTER_ST7 : result = bsc_st_decode(data, lzSize, 7, index, features); break;
-        case LIBBSC_BLOCKSORTER_ST8 : result = bsc_st_decode(data, lzSize, 8, index, features); break;
+        case LIBBSC_BLOCKSORTER_ST3 : result = bsc_st_decode(data, lzSize, 3, index, features, context); break;
+        case LIBBSC_BLOCKSORTER_ST4 : result = bsc_st_decode(data, lzSize, 4, index, features, context); break;
+        case LIBBSC_BLOCKSORTER_ST5 : result = bsc_st_decode(data, lzSize, 5, index, features, context); break;
+        case LIBBSC_BLOCKSORTER_ST6 : result = bsc_st_decode(data, lzSize, 6, index, features, context); break;
+        case LIBBSC_BLOCKSORTER_ST7 : result = bsc_st_decode(data, lzSize, 7, index, features, context); break;
+        case LIBBSC_BLOCKSORTER_ST8 : result = bsc_st_decode(data, lzSize, 8, index, features, context); break;
 
 #endif
 
@@ -502,11 +514,11 @@ int bsc_decompress_inplace(unsigned char * data, int inputSize, int outputSize,
 
     if (mode != (mode & 0xff))
     {
-        if (unsigned char * buffer = (unsigned char *)bsc_malloc(lzSize))
+        if (unsigned char * buffer = (unsigned char *)bsc_context_malloc(context, lzSize))
         {
             memcpy(buffer, data, lzSize);
-            result = bsc_lzp_decompress(buffer, data, lzSize, lzpHashSize, lzpMinLen, features);
-            bsc_free(buffer);
+            result = bsc_lzp_decompress(buffer, data, lzSize, lzpHashSize, lzpMinLen, lzpFeatures, context);
+            bsc_context_free(context, buffer);
             if (result < LIBBSC_NO_ERROR)
             {
                 return result;
@@ -519,14 +531,14 @@ int bsc_decompress_inplace(unsigned char * data, int inputSize, int outputSize,
     return lzSize == dataSize ? (adler32_data == bsc_adler32(data, dataSize, features) ? LIBBSC_NO_ERROR : LIBBSC_DATA_CORRUPT) : LIBBSC_DATA_CORRUPT;
 }
 
-int bsc_decompress(const unsigned char * input, int inputSize, unsigned char * output, int outputSize, int features)
+int bsc_context_decompress(bsc_context * context, const unsigned char * input, int inputSize, unsigned char * output, int outputSize, int features)
 {
     int             indexes[256];
     unsigned char   num_indexes;
 
     if (input == output)
     {
-        return bsc_decompress_inplace(output, inputSize, outputSize, features);
+        return bsc_decompress_inplace(context, output, inputSize, outputSize, features);
     }
 
     int blockSize = 0, dataSize = 0;
@@ -567,8 +579,9 @@ int bsc_decompress(const unsigned char * input, int inputSize, unsigned char * o
     int lzpMinLen    = (mode >>  8) & 0xff;
     int coder        = (mode >>  5) & 0x7;
     int blockSorter  = (mode >>  0) & 0x1f;
+    int lzpFeatures  = (features & ~LIBBSC_FEATURE_LZPBUCKETS) | ((mode & LIBBSC_MODE_LZPBUCKETS) ? LIBBSC_FEATURE_LZPBUCKETS : 0);
 
-    int lzSize = bsc_coder_decompress(input + LIBBSC_HEADER_SIZE, output, coder, features);
+    int lzSize = bsc_coder_decompress(input + LIBBSC_HEADER_SIZE, output, coder, features, context);
     if (lzSize < LIBBSC_NO_ERROR)
     {
         return lzSize;
@@ -577,16 +590,16 @@ int bsc_decompress(const unsigned char * input, int inputSize, unsigned char * o
     int result;
     switch (blockSorter)
     {
-        case LIBBSC_BLOCKSORTER_BWT : result = bsc_bwt_decode(output, lzSize, index, num_indexes, indexes, features); break;
+        case LIBBSC_BLOCKSORTER_BWT : result = bsc_bwt_decode(output, lzSize, index, num_indexes, indexes, features, context); break;
 
 #ifndef LIBBSC_NO_SORT_TRANSFORM
 
-        case LIBBSC_BLOCKSORTER_ST3 : result = bsc_st_decode(output, lzSize, 3, index, features); break;
-        case LIBBSC_BLOCKSORTER_ST4 : result = bsc_st_decode(output, lzSize, 4, index, features); break;
-        case LIBBSC_BLOCKSORTER_ST5 : result = bsc_st_decode(output, lzSize, 5, index, features); break;
-        case LIBBSC_BLOCKSORTER_ST6 : result = bsc_st_decode(output, lzSize, 6, index, features); break;
-        case LIBBSC_BLOCKSORTER_ST7 : result = bsc_st_decode(output, lzSize, 7, index, features); break;
-        case LIBBSC_BLOCKSORTER_ST8 : result = bsc_st_decode(output, lzSize, 8, index, features); break;
+        case LIBBSC_BLOCKSORTER_ST3 : result = bsc_st_decode(output, lzSize, 3, index, features, context); break;
+        case LIBBSC_BLOCKSORTER_ST4 : result = bsc_st_decode(output, lzSize, 4, index, features, context); break;
+        case LIBBSC_BLOCKSORTER_ST5 : result = bsc_st_decode(output, lzSize, 5, index, features, context); break;
+        case LIBBSC_BLOCKSORTER_ST6 : result = bsc_st_decode(output, lzSize, 6, index, features, context); break;
+        case LIBBSC_BLOCKSORTER_ST7 : result = bsc_st_decode(output, lzSize, 7, index, features, context); break;
+        case LIBBSC_BLOCKSORTER_ST8 : result = bsc_st_decode(output, lzSize, 8, index, features, context); break;
 
 #endif
 
@@ -599,11 +612,11 @@ int bsc_decompress(const unsigned char * input, int inputSize, unsigned char * o
 
     if (mode != (mode & 0xff))
     {
-        if (unsigned char * buffer = (unsigned char *)bsc_malloc(lzSize))
+        if (unsigned char * buffer = (unsigned char *)bsc_context_malloc(context, lzSize))
         {
             memcpy(buffer, output, lzSize);
-            result = bsc_lzp_decompress(buffer, output, lzSize, lzpHashSize, lzpMinLen, features);
-            bsc_free(buffer);
+            result = bsc_lzp_decompress(buffer, output, lzSize, lzpHashSize, lzpMinLen, lzpFeatures, context);
+            bsc_context_free(context, buffer);
             if (result < LIBBSC_NO_ERROR)
             {
                 return result;
@@ -616,6 +629,11 @@ int bsc_decompress(const unsigned char * input, int inputSize, unsigned char * o
     return lzSize == dataSize ? (adler32_data == bsc_adler32(output, dataSize, features) ? LIBBSC_NO_ERROR : LIBBSC_DATA_CORRUPT) : LIBBSC_DATA_CORRUPT;
 }
 
+int bsc_decompress(const unsigned char * input, int inputSize, unsigned char * output, int outputSize, int features)
+{
+    return bsc_context_decompress(NULL, input, inputSize, output, outputSize, features);
+}
+
 /*-------------------------------------------------*/
 /* End                                  libbsc.cpp */
 /*-------------------------------------------------*/
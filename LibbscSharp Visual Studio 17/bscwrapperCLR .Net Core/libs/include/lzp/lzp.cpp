@@ -41,8 +41,23 @@ See also the bsc and libbsc web site:
 
 #define LIBBSC_LZP_MATCH_FLAG 	0xf2
 
-static INLINE int bsc_lzp_num_blocks(int n)
+#define LIBBSC_LZP_MIN_SUBBLOCK_SIZE    (256 * 1024)
+
+/* The bucketed table keeps 2^hashSize positions in 4-way buckets of one cache line, every position comes with three tags,
+   so it is capped at 2^26 positions, the memory of the largest direct-mapped table. */
+#define LIBBSC_LZP_BUCKET_WAYS                  4
+#define LIBBSC_LZP_BUCKET_BITS(hashSize)        ((hashSize) < 26 ? (hashSize) - 2 : 24)
+#define LIBBSC_LZP_BUCKET_TABLE_SIZE(hashSize)  ((size_t)4 * LIBBSC_LZP_BUCKET_WAYS * sizeof(unsigned int) << LIBBSC_LZP_BUCKET_BITS(hashSize))
+
+static INLINE int bsc_lzp_num_blocks(int n, int features)
 {
+    // An explicit count is kept to sub-blocks large enough for their hash table to find matches
+    if (int maxBlocks = LIBBSC_FEATURE_SUBBLOCKS_COUNT(features))
+    {
+        int nBlocks = n / LIBBSC_LZP_MIN_SUBBLOCK_SIZE;
+        return nBlocks < 1 ? 1 : (nBlocks < maxBlocks ? nBlocks : maxBlocks);
+    }
+
     if (n <       256 * 1024)   return 1;
     if (n <  4 * 1024 * 1024)   return 2;
     if (n < 16 * 1024 * 1024)   return 4;
@@ -50,9 +65,121 @@ static INLINE int bsc_lzp_num_blocks(int n)
     return 8;
 }
 
+#if defined(LIBBSC_DYNAMIC_CPU_DISPATCH)
+    int bsc_lzp_encode_block(const unsigned char * input, const unsigned char * inputEnd, unsigned char * output, unsigned char * outputEnd, int hashSize, int minLen, bsc_context * context);
+    int bsc_lzp_encode_block_avx512(const unsigned char * input, const unsigned char * inputEnd, unsigned char * output, unsigned char * outputEnd, int hashSize, int minLen, bsc_context * context);
+    int bsc_lzp_encode_block_avx2(const unsigned char * input, const unsigned char * inputEnd, unsigned char * output, unsigned char * outputEnd, int hashSize, int minLen, bsc_context * context);
+    int bsc_lzp_encode_block_sse2(const unsigned char * input, const unsigned char * inputEnd, unsigned char * output, unsigned char * outputEnd, int hashSize, int minLen, bsc_context * context);
+
+    #if LIBBSC_CPU_FEATURE == LIBBSC_CPU_FEATURE_SSE2
+        static int bsc_lzp_cpu_features = -1;
+
+        int bsc_lzp_set_cpu_features(int cpuFeatures)
+        {
+            bsc_lzp_cpu_features = cpuFeatures >= 0 && cpuFeatures < bsc_get_cpu_features() ? cpuFeatures : -1;
+
+            int effective = bsc_lzp_cpu_features >= 0 ? bsc_lzp_cpu_features : bsc_get_cpu_features();
+            if (effective >= LIBBSC_CPU_FEATURE_AVX512BW) return LIBBSC_CPU_FEATURE_AVX512BW;
+            if (effective >= LIBBSC_CPU_FEATURE_AVX2)     return LIBBSC_CPU_FEATURE_AVX2;
+
+            return LIBBSC_CPU_FEATURE_SSE2;
+        }
+
+        int bsc_lzp_encode_block(const unsigned char * input, const unsigned char * inputEnd, unsigned char * output, unsigned char * outputEnd, int hashSize, int minLen, bsc_context * context)
+        {
+            int cpuFeatures = bsc_lzp_cpu_features >= 0 ? bsc_lzp_cpu_features : bsc_get_cpu_features();
+
+            if (cpuFeatures >= LIBBSC_CPU_FEATURE_AVX512BW) { return bsc_lzp_encode_block_avx512(input, inputEnd, output, outputEnd, hashSize, minLen, context); }
+            if (cpuFeatures >= LIBBSC_CPU_FEATURE_AVX2)     { return bsc_lzp_encode_block_avx2  (input, inputEnd, output, outputEnd, hashSize, minLen, context); }
+
+            return bsc_lzp_encode_block_sse2(input, inputEnd, output, outputEnd, hashSize, minLen, context);
+        }
+    #endif
+
+    #if LIBBSC_CPU_FEATURE == LIBBSC_CPU_FEATURE_AVX512BW
+        #define LZP_ENCODE_FUNCTION_NAME    bsc_lzp_encode_block_avx512
+    #elif LIBBSC_CPU_FEATURE == LIBBSC_CPU_FEATURE_AVX2
+        #define LZP_ENCODE_FUNCTION_NAME    bsc_lzp_encode_block_avx2
+    #elif LIBBSC_CPU_FEATURE == LIBBSC_CPU_FEATURE_SSE2
+        #define LZP_ENCODE_FUNCTION_NAME    bsc_lzp_encode_block_sse2
+    #endif
+#else
+    #define LZP_ENCODE_FUNCTION_NAME        bsc_lzp_encode_block
+
+    int bsc_lzp_set_cpu_features(int cpuFeatures)
+    {
+        // A single code path is compiled in, chosen by the compiler flags
+        (void)cpuFeatures; return LIBBSC_CPU_FEATURE;
+    }
+#endif
+
+#if defined(LZP_ENCODE_FUNCTION_NAME)
+
 #if !defined(LIBBSC_NO_UNALIGNED_ACCESS) && (defined(LIBBSC_x86_64) || defined(LIBBSC_AArch64))
 
-template<class T> int bsc_lzp_encode_small(const unsigned char * RESTRICT input, const unsigned char * inputEnd, unsigned char * RESTRICT output, unsigned char * outputEnd, int * RESTRICT lookup, int mask)
+static INLINE void bsc_lzp_hash4(const unsigned char * RESTRICT input, int mask, unsigned int * RESTRICT index)
+{
+#if LIBBSC_CPU_FEATURE >= LIBBSC_CPU_FEATURE_AVX2
+    // The four contexts ending before input .. input + 3 are hashed at once in the lanes of one register
+    __m128i contexts    = _mm_shuffle_epi8(_mm_loadl_epi64((const __m128i *)(input - 4)), _mm_setr_epi8(3, 2, 1, 0, 4, 3, 2, 1, 5, 4, 3, 2, 6, 5, 4, 3));
+    __m128i hashes      = _mm_and_si128(_mm_xor_si128(_mm_xor_si128(_mm_srli_epi32(contexts, 15), contexts), _mm_srli_epi32(contexts, 3)), _mm_set1_epi32(mask));
+
+    index[0] = (unsigned int)_mm_cvtsi128_si32(hashes);
+    index[1] = (unsigned int)_mm_extract_epi32(hashes, 1);
+    index[2] = (unsigned int)_mm_extract_epi32(hashes, 2);
+    index[3] = (unsigned int)_mm_extract_epi32(hashes, 3);
+#else
+    // Inlined into the encoders, this load is the one they already made for the match flag checks
+    unsigned long long next8 = bsc_byteswap_uint64(*(const unsigned long long *)(input - 4));
+
+    index[0] = (((next8 >> (4 * 8)) >> 15) ^ (next8 >> (4 * 8)) ^ ((next8 >> (4 * 8)) >> 3)) & mask;
+    index[1] = (((next8 >> (3 * 8)) >> 15) ^ (next8 >> (3 * 8)) ^ ((next8 >> (3 * 8)) >> 3)) & mask;
+    index[2] = (((next8 >> (2 * 8)) >> 15) ^ (next8 >> (2 * 8)) ^ ((next8 >> (2 * 8)) >> 3)) & mask;
+    index[3] = (((next8 >> (1 * 8)) >> 15) ^ (next8 >> (1 * 8)) ^ ((next8 >> (1 * 8)) >> 3)) & mask;
+#endif
+}
+
+static INLINE long long bsc_lzp_match_length(const unsigned char * RESTRICT input, const unsigned char * RESTRICT reference, long long len, const unsigned char * inputMinLenEnd)
+{
+    // Wide compares stop at the same 8-byte boundary as the scalar loop, so the match lengths do not depend on the CPU.
+    // AVX-512 starts with a 32-byte compare, 64-byte compares only pay off once the match is known to be long
+#if LIBBSC_CPU_FEATURE >= LIBBSC_CPU_FEATURE_AVX512BW
+    if (input + len + 24 < inputMinLenEnd)
+    {
+        unsigned int m = ~(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(input + len)), _mm256_loadu_si256((const __m256i *)(reference + len))));
+        if (m != 0) { return len + bsc_bit_scan_forward(m); }
+
+        len += 32;
+    }
+
+    for (; input + len + 56 < inputMinLenEnd; len += 64)
+    {
+        unsigned long long m = _mm512_cmpneq_epi8_mask(_mm512_loadu_si512((const void *)(input + len)), _mm512_loadu_si512((const void *)(reference + len)));
+        if (m != 0) { return len + bsc_bit_scan_forward64(m); }
+    }
+#endif
+
+#if LIBBSC_CPU_FEATURE >= LIBBSC_CPU_FEATURE_AVX2
+    for (; input + len + 24 < inputMinLenEnd; len += 32)
+    {
+        unsigned int m = ~(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(input + len)), _mm256_loadu_si256((const __m256i *)(reference + len))));
+        if (m != 0) { return len + bsc_bit_scan_forward(m); }
+    }
+#endif
+
+    for (; input + len < inputMinLenEnd; len += sizeof(unsigned long long))
+    {
+        unsigned long long m;
+        if ((m = (*(unsigned long long *)(input + len)) ^ *(unsigned long long *)(reference + len)) != 0) 
+        {
+            return len + bsc_bit_scan_forward64(m) / 8;
+        }
+    }
+
+    return len;
+}
+
+template<class T> static int bsc_lzp_encode_small(const unsigned char * RESTRICT input, const unsigned char * inputEnd, unsigned char * RESTRICT output, unsigned char * outputEnd, int * RESTRICT lookup, int mask)
 {
     const unsigned char *   inputStart      = input;
     const unsigned char *   inputMinLenEnd  = inputEnd - sizeof(T) - 32;
@@ -67,21 +194,23 @@ template<class T> int bsc_lzp_encode_small(const unsigned char * RESTRICT input,
         {
             unsigned long long next8 = *(unsigned long long *)(input - 4); *(unsigned int *)(output) = (unsigned int)(next8 >> 32); next8 = bsc_byteswap_uint64(next8);
 
+            unsigned int index[4]; bsc_lzp_hash4(input, mask, index);
+
             int value;
             {
-                const unsigned int index0 = (((next8 >> (4 * 8)) >> 15) ^ (next8 >> (4 * 8)) ^ ((next8 >> (4 * 8)) >> 3)) & mask; value = lookup[index0]; lookup[index0] = (int)(input - inputStart + 0); 
+                value = lookup[index[0]]; lookup[index[0]] = (int)(input - inputStart + 0); 
                 if (value > 0 && (*(T *)(input + 0) == *(T *)(inputStart + value))) goto LIBBSC_LZP_GOOD_MATCH_FOUND1;
                 if (value > 0 && ((unsigned char)(next8 >> 3 * 8) == LIBBSC_LZP_MATCH_FLAG)) goto LIBBSC_LZP_BAD_MATCH_FOUND1;
 
-                const unsigned int index1 = (((next8 >> (3 * 8)) >> 15) ^ (next8 >> (3 * 8)) ^ ((next8 >> (3 * 8)) >> 3)) & mask; value = lookup[index1]; lookup[index1] = (int)(input - inputStart + 1); 
+                value = lookup[index[1]]; lookup[index[1]] = (int)(input - inputStart + 1); 
                 if (value > 0 && (*(T *)(input + 1) == *(T *)(inputStart + value))) goto LIBBSC_LZP_GOOD_MATCH_FOUND2;
                 if (value > 0 && ((unsigned char)(next8 >> 2 * 8) == LIBBSC_LZP_MATCH_FLAG)) goto LIBBSC_LZP_BAD_MATCH_FOUND2;
 
-                const unsigned int index2 = (((next8 >> (2 * 8)) >> 15) ^ (next8 >> (2 * 8)) ^ ((next8 >> (2 * 8)) >> 3)) & mask; value = lookup[index2]; lookup[index2] = (int)(input - inputStart + 2); 
+                value = lookup[index[2]]; lookup[index[2]] = (int)(input - inputStart + 2); 
                 if (value > 0 && (*(T *)(input + 2) == *(T *)(inputStart + value))) goto LIBBSC_LZP_GOOD_MATCH_FOUND3;
                 if (value > 0 && ((unsigned char)(next8 >> 1 * 8) == LIBBSC_LZP_MATCH_FLAG)) goto LIBBSC_LZP_BAD_MATCH_FOUND3;
 
-                const unsigned int index3 = (((next8 >> (1 * 8)) >> 15) ^ (next8 >> (1 * 8)) ^ ((next8 >> (1 * 8)) >> 3)) & mask; value = lookup[index3]; lookup[index3] = (int)(input - inputStart + 3); 
+                value = lookup[index[3]]; lookup[index[3]] = (int)(input - inputStart + 3); 
                 if (value > 0 && (*(T *)(input + 3) == *(T *)(inputStart + value))) goto LIBBSC_LZP_GOOD_MATCH_FOUND4;
                 if (value > 0 && ((unsigned char)(next8 >> 0 * 8) == LIBBSC_LZP_MATCH_FLAG)) goto LIBBSC_LZP_BAD_MATCH_FOUND4;
 
@@ -101,16 +230,7 @@ LIBBSC_LZP_GOOD_MATCH_FOUND1:
             {
                 const unsigned char * RESTRICT reference = inputStart + value;
 
-                long long len = sizeof(T);
-
-                for (; input + len < inputMinLenEnd; len += sizeof(unsigned long long))
-                {
-                    unsigned long long m;
-                    if ((m = (*(unsigned long long *)(input + len)) ^ *(unsigned long long *)(reference + len)) != 0) 
-                    {
-                        len += bsc_bit_scan_forward64(m) / 8; break;
-                    }
-                }
+                long long len = bsc_lzp_match_length(input, reference, sizeof(T), inputMinLenEnd);
 
                 input += len; len -= sizeof(T);
 
@@ -146,7 +266,7 @@ LIBBSC_LZP_BAD_MATCH_FOUND1:
     return (output >= outputEOB) ? LIBBSC_NOT_COMPRESSIBLE : (int)(output - outputStart);
 }
 
-template<class T> int bsc_lzp_encode_small2x(const unsigned char * RESTRICT input, const unsigned char * inputEnd, unsigned char * RESTRICT output, unsigned char * outputEnd, int * RESTRICT lookup, int mask)
+template<class T> static int bsc_lzp_encode_small2x(const unsigned char * RESTRICT input, const unsigned char * inputEnd, unsigned char * RESTRICT output, unsigned char * outputEnd, int * RESTRICT lookup, int mask)
 {
     const unsigned char *   inputStart      = input;
     const unsigned char *   inputMinLenEnd  = inputEnd - sizeof(T) - sizeof(T) - 32;
@@ -161,21 +281,23 @@ template<class T> int bsc_lzp_encode_small2x(const unsigned char * RESTRICT inpu
         {
             unsigned long long next8 = *(unsigned long long *)(input - 4); *(unsigned int *)(output) = (unsigned int)(next8 >> 32); next8 = bsc_byteswap_uint64(next8);
 
+            unsigned int index[4]; bsc_lzp_hash4(input, mask, index);
+
             int value;
             {
-                const unsigned int index0 = (((next8 >> (4 * 8)) >> 15) ^ (next8 >> (4 * 8)) ^ ((next8 >> (4 * 8)) >> 3)) & mask; value = lookup[index0]; lookup[index0] = (int)(input - inputStart + 0); 
+                value = lookup[index[0]]; lookup[index[0]] = (int)(input - inputStart + 0); 
                 if (value > 0 && (*(T *)(input + sizeof(T) + 0) == *(T *)(inputStart + value + sizeof(T))) && (*(T *)(input + 0) == *(T *)(inputStart + value))) goto LIBBSC_LZP_GOOD_MATCH_FOUND1;
                 if (value > 0 && ((unsigned char)(next8 >> 3 * 8) == LIBBSC_LZP_MATCH_FLAG)) goto LIBBSC_LZP_BAD_MATCH_FOUND1;
 
-                const unsigned int index1 = (((next8 >> (3 * 8)) >> 15) ^ (next8 >> (3 * 8)) ^ ((next8 >> (3 * 8)) >> 3)) & mask; value = lookup[index1]; lookup[index1] = (int)(input - inputStart + 1); 
+                value = lookup[index[1]]; lookup[index[1]] = (int)(input - inputStart + 1); 
                 if (value > 0 && (*(T *)(input + sizeof(T) + 1) == *(T *)(inputStart + value + sizeof(T))) && (*(T *)(input + 1) == *(T *)(inputStart + value))) goto LIBBSC_LZP_GOOD_MATCH_FOUND2;
                 if (value > 0 && ((unsigned char)(next8 >> 2 * 8) == LIBBSC_LZP_MATCH_FLAG)) goto LIBBSC_LZP_BAD_MATCH_FOUND2;
 
-                const unsigned int index2 = (((next8 >> (2 * 8)) >> 15) ^ (next8 >> (2 * 8)) ^ ((next8 >> (2 * 8)) >> 3)) & mask; value = lookup[index2]; lookup[index2] = (int)(input - inputStart + 2); 
+                value = lookup[index[2]]; lookup[index[2]] = (int)(input - inputStart + 2); 
                 if (value > 0 && (*(T *)(input + sizeof(T) + 2) == *(T *)(inputStart + value + sizeof(T))) && (*(T *)(input + 2) == *(T *)(inputStart + value))) goto LIBBSC_LZP_GOOD_MATCH_FOUND3;
                 if (value > 0 && ((unsigned char)(next8 >> 1 * 8) == LIBBSC_LZP_MATCH_FLAG)) goto LIBBSC_LZP_BAD_MATCH_FOUND3;
 
-                const unsigned int index3 = (((next8 >> (1 * 8)) >> 15) ^ (next8 >> (1 * 8)) ^ ((next8 >> (1 * 8)) >> 3)) & mask; value = lookup[index3]; lookup[index3] = (int)(input - inputStart + 3); 
+                value = lookup[index[3]]; lookup[index[3]] = (int)(input - inputStart + 3); 
                 if (value > 0 && (*(T *)(input + sizeof(T) + 3) == *(T *)(inputStart + value + sizeof(T))) && (*(T *)(input + 3) == *(T *)(inputStart + value))) goto LIBBSC_LZP_GOOD_MATCH_FOUND4;
                 if (value > 0 && ((unsigned char)(next8 >> 0 * 8) == LIBBSC_LZP_MATCH_FLAG)) goto LIBBSC_LZP_BAD_MATCH_FOUND4;
 
@@ -195,16 +317,7 @@ LIBBSC_LZP_GOOD_MATCH_FOUND1:
             {
                 const unsigned char * RESTRICT reference = inputStart + value;
 
-                long long len = sizeof(T) + sizeof(T);
-
-                for (; input + len < inputMinLenEnd; len += sizeof(unsigned long long))
-                {
-                    unsigned long long m;
-                    if ((m = (*(unsigned long long *)(input + len)) ^ *(unsigned long long *)(reference + len)) != 0) 
-                    {
-                        len += bsc_bit_scan_forward64(m) / 8; break;
-                    }
-                }
+                long long len = bsc_lzp_match_length(input, reference, sizeof(T) + sizeof(T), inputMinLenEnd);
 
                 input += len; len -= sizeof(T) + sizeof(T);
 
@@ -240,7 +353,7 @@ LIBBSC_LZP_BAD_MATCH_FOUND1:
     return (output >= outputEOB) ? LIBBSC_NOT_COMPRESSIBLE : (int)(output - outputStart);
 }
 
-template<class T> int bsc_lzp_encode_medium(const unsigned char * RESTRICT input, const unsigned char * inputEnd, unsigned char * RESTRICT output, unsigned char * outputEnd, int * RESTRICT lookup, int mask, int minLen)
+template<class T> static int bsc_lzp_encode_medium(const unsigned char * RESTRICT input, const unsigned char * inputEnd, unsigned char * RESTRICT output, unsigned char * outputEnd, int * RESTRICT lookup, int mask, int minLen)
 {
     const unsigned char *   inputStart      = input;
     const unsigned char *   inputMinLenEnd  = inputEnd - sizeof(T) - sizeof(T) - 32;
@@ -255,21 +368,23 @@ template<class T> int bsc_lzp_encode_medium(const unsigned char * RESTRICT input
         {
             unsigned long long next8 = *(unsigned long long *)(input - 4); *(unsigned int *)(output) = (unsigned int)(next8 >> 32); next8 = bsc_byteswap_uint64(next8);
 
+            unsigned int index[4]; bsc_lzp_hash4(input, mask, index);
+
             int value;
             {
-                const unsigned int index0 = (((next8 >> (4 * 8)) >> 15) ^ (next8 >> (4 * 8)) ^ ((next8 >> (4 * 8)) >> 3)) & mask; value = lookup[index0]; lookup[index0] = (int)(input - inputStart + 0); 
+                value = lookup[index[0]]; lookup[index[0]] = (int)(input - inputStart + 0); 
                 if (value > 0 && (*(T *)(input + minLen - sizeof(T) + 0) == *(T *)(inputStart + value + minLen - sizeof(T))) && (*(T *)(input + 0) == *(T *)(inputStart + value))) goto LIBBSC_LZP_GOOD_MATCH_FOUND1;
                 if (value > 0 && ((unsigned char)(next8 >> 3 * 8) == LIBBSC_LZP_MATCH_FLAG)) goto LIBBSC_LZP_BAD_MATCH_FOUND1;
 
-                const unsigned int index1 = (((next8 >> (3 * 8)) >> 15) ^ (next8 >> (3 * 8)) ^ ((next8 >> (3 * 8)) >> 3)) & mask; value = lookup[index1]; lookup[index1] = (int)(input - inputStart + 1); 
+                value = lookup[index[1]]; lookup[index[1]] = (int)(input - inputStart + 1); 
                 if (value > 0 && (*(T *)(input + minLen - sizeof(T) + 1) == *(T *)(inputStart + value + minLen - sizeof(T))) && (*(T *)(input + 1) == *(T *)(inputStart + value))) goto LIBBSC_LZP_GOOD_MATCH_FOUND2;
                 if (value > 0 && ((unsigned char)(next8 >> 2 * 8) == LIBBSC_LZP_MATCH_FLAG)) goto LIBBSC_LZP_BAD_MATCH_FOUND2;
 
-                const unsigned int index2 = (((next8 >> (2 * 8)) >> 15) ^ (next8 >> (2 * 8)) ^ ((next8 >> (2 * 8)) >> 3)) & mask; value = lookup[index2]; lookup[index2] = (int)(input - inputStart + 2); 
+                value = lookup[index[2]]; lookup[index[2]] = (int)(input - inputStart + 2); 
                 if (value > 0 && (*(T *)(input + minLen - sizeof(T) + 2) == *(T *)(inputStart + value + minLen - sizeof(T))) && (*(T *)(input + 2) == *(T *)(inputStart + value))) goto LIBBSC_LZP_GOOD_MATCH_FOUND3;
                 if (value > 0 && ((unsigned char)(next8 >> 1 * 8) == LIBBSC_LZP_MATCH_FLAG)) goto LIBBSC_LZP_BAD_MATCH_FOUND3;
 
-                const unsigned int index3 = (((next8 >> (1 * 8)) >> 15) ^ (next8 >> (1 * 8)) ^ ((next8 >> (1 * 8)) >> 3)) & mask; value = lookup[index3]; lookup[index3] = (int)(input - inputStart + 3); 
+                value = lookup[index[3]]; lookup[index[3]] = (int)(input - inputStart + 3); 
                 if (value > 0 && (*(T *)(input + minLen - sizeof(T) + 3) == *(T *)(inputStart + value + minLen - sizeof(T))) && (*(T *)(input + 3) == *(T *)(inputStart + value))) goto LIBBSC_LZP_GOOD_MATCH_FOUND4;
                 if (value > 0 && ((unsigned char)(next8 >> 0 * 8) == LIBBSC_LZP_MATCH_FLAG)) goto LIBBSC_LZP_BAD_MATCH_FOUND4;
 
@@ -289,16 +404,7 @@ LIBBSC_LZP_GOOD_MATCH_FOUND1:
             {
                 const unsigned char * RESTRICT reference = inputStart + value;
 
-                long long len = minLen;
-
-                for (; input + len < inputMinLenEnd; len += sizeof(unsigned long long))
-                {
-                    unsigned long long m;
-                    if ((m = (*(unsigned long long *)(input + len)) ^ *(unsigned long long *)(reference + len)) != 0) 
-                    {
-                        len += bsc_bit_scan_forward64(m) / 8; break;
-                    }
-                }
+                long long len = bsc_lzp_match_length(input, reference, minLen, inputMinLenEnd);
 
                 input += len; len -= minLen;
 
@@ -334,7 +440,7 @@ LIBBSC_LZP_BAD_MATCH_FOUND1:
     return (output >= outputEOB) ? LIBBSC_NOT_COMPRESSIBLE : (int)(output - outputStart);
 }
 
-template<class T> int bsc_lzp_encode_large(const unsigned char * RESTRICT input, const unsigned char * inputEnd, unsigned char * RESTRICT output, unsigned char * outputEnd, int * RESTRICT lookup, int mask, int minLen)
+template<class T> static int bsc_lzp_encode_large(const unsigned char * RESTRICT input, const unsigned char * inputEnd, unsigned char * RESTRICT output, unsigned char * outputEnd, int * RESTRICT lookup, int mask, int minLen)
 {
     const unsigned char *   inputStart  = input;
     const unsigned char *   outputStart = output;
@@ -350,21 +456,23 @@ template<class T> int bsc_lzp_encode_large(const unsigned char * RESTRICT input,
         {
             unsigned long long next8 = *(unsigned long long *)(input - 4); *(unsigned int *)(output) = (unsigned int)(next8 >> 32); next8 = bsc_byteswap_uint64(next8);
 
+            unsigned int index[4]; bsc_lzp_hash4(input, mask, index);
+
             int value;
             {
-                const unsigned int index0 = (((next8 >> (4 * 8)) >> 15) ^ (next8 >> (4 * 8)) ^ ((next8 >> (4 * 8)) >> 3)) & mask; value = lookup[index0]; lookup[index0] = (int)(input - inputStart + 0); 
+                value = lookup[index[0]]; lookup[index[0]] = (int)(input - inputStart + 0); 
                 if (value > 0 && input > heuristic && (*(T *)(input + minLen - sizeof(T) + 0) == *(T *)(inputStart + value + minLen - sizeof(T))) && (*(T *)(input + 0) == *(T *)(inputStart + value))) goto LIBBSC_LZP_GOOD_MATCH_FOUND1;
                 if (value > 0 && ((unsigned char)(next8 >> 3 * 8) == LIBBSC_LZP_MATCH_FLAG)) goto LIBBSC_LZP_BAD_MATCH_FOUND1;
 
-                const unsigned int index1 = (((next8 >> (3 * 8)) >> 15) ^ (next8 >> (3 * 8)) ^ ((next8 >> (3 * 8)) >> 3)) & mask; value = lookup[index1]; lookup[index1] = (int)(input - inputStart + 1); 
+                value = lookup[index[1]]; lookup[index[1]] = (int)(input - inputStart + 1); 
                 if (value > 0 && input > heuristic && (*(T *)(input + minLen - sizeof(T) + 1) == *(T *)(inputStart + value + minLen - sizeof(T))) && (*(T *)(input + 1) == *(T *)(inputStart + value))) goto LIBBSC_LZP_GOOD_MATCH_FOUND2;
                 if (value > 0 && ((unsigned char)(next8 >> 2 * 8) == LIBBSC_LZP_MATCH_FLAG)) goto LIBBSC_LZP_BAD_MATCH_FOUND2;
 
-                const unsigned int index2 = (((next8 >> (2 * 8)) >> 15) ^ (next8 >> (2 * 8)) ^ ((next8 >> (2 * 8)) >> 3)) & mask; value = lookup[index2]; lookup[index2] = (int)(input - inputStart + 2); 
+                value = lookup[index[2]]; lookup[index[2]] = (int)(input - inputStart + 2); 
                 if (value > 0 && input > heuristic && (*(T *)(input + minLen - sizeof(T) + 2) == *(T *)(inputStart + value + minLen - sizeof(T))) && (*(T *)(input + 2) == *(T *)(inputStart + value))) goto LIBBSC_LZP_GOOD_MATCH_FOUND3;
                 if (value > 0 && ((unsigned char)(next8 >> 1 * 8) == LIBBSC_LZP_MATCH_FLAG)) goto LIBBSC_LZP_BAD_MATCH_FOUND3;
 
-                const unsigned int index3 = (((next8 >> (1 * 8)) >> 15) ^ (next8 >> (1 * 8)) ^ ((next8 >> (1 * 8)) >> 3)) & mask; value = lookup[index3]; lookup[index3] = (int)(input - inputStart + 3); 
+                value = lookup[index[3]]; lookup[index[3]] = (int)(input - inputStart + 3); 
                 if (value > 0 && input > heuristic && (*(T *)(input + minLen - sizeof(T) + 3) == *(T *)(inputStart + value + minLen - sizeof(T))) && (*(T *)(input + 3) == *(T *)(inputStart + value))) goto LIBBSC_LZP_GOOD_MATCH_FOUND4;
                 if (value > 0 && ((unsigned char)(next8 >> 0 * 8) == LIBBSC_LZP_MATCH_FLAG)) goto LIBBSC_LZP_BAD_MATCH_FOUND4;
 
@@ -384,16 +492,7 @@ LIBBSC_LZP_GOOD_MATCH_FOUND1:
             {
                 const unsigned char * RESTRICT reference = inputStart + value;
 
-                long long len = sizeof(T);
-
-                for (; input + len < inputMinLenEnd; len += sizeof(unsigned long long))
-                {
-                    unsigned long long m;
-                    if ((m = (*(unsigned long long *)(input + len)) ^ *(unsigned long long *)(reference + len)) != 0) 
-                    {
-                        len += bsc_bit_scan_forward64(m) / 8; break;
-                    }
-                }
+                long long len = bsc_lzp_match_length(input, reference, sizeof(T), inputMinLenEnd);
 
                 if (len < minLen) { heuristic = input + len; goto LIBBSC_LZP_MATCH_NOT_FOUND; }
 
@@ -438,7 +537,7 @@ LIBBSC_LZP_BAD_MATCH_FOUND1:
 
 #endif
 
-int bsc_lzp_encode_generic(const unsigned char * RESTRICT input, const unsigned char * inputEnd, unsigned char * RESTRICT output, unsigned char * outputEnd, int * RESTRICT lookup, int mask, int minLen)
+static int bsc_lzp_encode_generic(const unsigned char * RESTRICT input, const unsigned char * inputEnd, unsigned char * RESTRICT output, unsigned char * outputEnd, int * RESTRICT lookup, int mask, int minLen)
 {
     const unsigned char *   inputStart  = input;
     const unsigned char *   outputStart = output;
@@ -538,7 +637,7 @@ LIBBSC_LZP_MATCH_NOT_FOUND:
     return (output >= outputEOB) ? LIBBSC_NOT_COMPRESSIBLE : (int)(output - outputStart);
 }
 
-int bsc_lzp_encode_block(const unsigned char * input, const unsigned char * inputEnd, unsigned char * output, unsigned char * outputEnd, int hashSize, int minLen)
+int LZP_ENCODE_FUNCTION_NAME (const unsigned char * input, const unsigned char * inputEnd, unsigned char * output, unsigned char * outputEnd, int hashSize, int minLen, bsc_context * context)
 {
     if (inputEnd - input - minLen < 32)
     {
@@ -546,7 +645,7 @@ int bsc_lzp_encode_block(const unsigned char * input, const unsigned char * inpu
     }
 
     int result = LIBBSC_NOT_ENOUGH_MEMORY;
-    if (int * lookup = (int *)bsc_zero_malloc((int)(1 << hashSize) * sizeof(int)))
+    if (int * lookup = (int *)bsc_context_zero_malloc(context, (int)(1 << hashSize) * sizeof(int)))
     {
 #if !defined(LIBBSC_NO_UNALIGNED_ACCESS) && (defined(LIBBSC_x86_64) || defined(LIBBSC_AArch64))
         if (hashSize <= 17)
@@ -563,20 +662,24 @@ int bsc_lzp_encode_block(const unsigned char * input, const unsigned char * inpu
 
         result = result == LIBBSC_NOT_ENOUGH_MEMORY ? bsc_lzp_encode_generic(input, inputEnd, output, outputEnd, lookup, (int)(1 << hashSize) - 1, minLen) : result;
 
-        bsc_free(lookup);
+        bsc_context_free(context, lookup);
     }
 
     return result;
 }
 
-int bsc_lzp_decode_block(const unsigned char * RESTRICT input, const unsigned char * inputEnd, unsigned char * RESTRICT output, int hashSize, int minLen)
+#endif
+
+#if !defined(LIBBSC_DYNAMIC_CPU_DISPATCH) || LIBBSC_CPU_FEATURE == LIBBSC_CPU_FEATURE_SSE2
+
+int bsc_lzp_decode_block(const unsigned char * RESTRICT input, const unsigned char * inputEnd, unsigned char * RESTRICT output, int hashSize, int minLen, bsc_context * context)
 {
     if (inputEnd - input < 4)
     {
         return LIBBSC_UNEXPECTED_EOB;
     }
 
-    if (int * RESTRICT lookup = (int *)bsc_zero_malloc((int)(1 << hashSize) * sizeof(int)))
+    if (int * RESTRICT lookup = (int *)bsc_context_zero_malloc(context, (int)(1 << hashSize) * sizeof(int)))
     {
         unsigned int            mask        = (int)(1 << hashSize) - 1;
         const unsigned char *   outputStart = output;
@@ -673,7 +776,7 @@ LIBBSC_LZP_MATCH_FOUND1:
             }
         }
 
-        bsc_free(lookup);
+        bsc_context_free(context, lookup);
 
         return (int)(output - outputStart);
     }
@@ -681,17 +784,278 @@ LIBBSC_LZP_MATCH_FOUND1:
     return LIBBSC_NOT_ENOUGH_MEMORY;
 }
 
-int bsc_lzp_compress_serial(const unsigned char * input, unsigned char * output, int n, int hashSize, int minLen)
+static INLINE int bsc_lzp_bucket_update(unsigned int * RESTRICT bucket, unsigned int context, unsigned int prev4, unsigned int prev8, int position)
+{
+    // A bucket is one cache line with the last four positions whose contexts hashed to it, each tagged with its
+    // context and the eight bytes before it. The most recent way that agrees on the longest of the 4, 8 and 12
+    // byte contexts is predicted. This only looks at history, so the decoder makes the same choice
+    int m4, m8, m12;
+
+#if LIBBSC_CPU_FEATURE >= LIBBSC_CPU_FEATURE_SSE2
+    __m128i tags        = _mm_load_si128((const __m128i *)(bucket + 0 * LIBBSC_LZP_BUCKET_WAYS));
+    __m128i tags4       = _mm_load_si128((const __m128i *)(bucket + 1 * LIBBSC_LZP_BUCKET_WAYS));
+    __m128i tags8       = _mm_load_si128((const __m128i *)(bucket + 2 * LIBBSC_LZP_BUCKET_WAYS));
+    __m128i positions   = _mm_load_si128((const __m128i *)(bucket + 3 * LIBBSC_LZP_BUCKET_WAYS));
+
+    __m128i  v4         = _mm_andnot_si128(_mm_cmpeq_epi32(positions, _mm_setzero_si128()), _mm_cmpeq_epi32(tags, _mm_set1_epi32((int)context)));
+    __m128i  v8         = _mm_and_si128(v4, _mm_cmpeq_epi32(tags4, _mm_set1_epi32((int)prev4)));
+    __m128i  v12        = _mm_and_si128(v8, _mm_cmpeq_epi32(tags8, _mm_set1_epi32((int)prev8)));
+
+    m4  = _mm_movemask_ps(_mm_castsi128_ps(v4));
+    m8  = _mm_movemask_ps(_mm_castsi128_ps(v8));
+    m12 = _mm_movemask_ps(_mm_castsi128_ps(v12));
+#elif LIBBSC_CPU_FEATURE == LIBBSC_CPU_FEATURE_A64
+    static const unsigned int ways[4] = { 1, 2, 4, 8 };
+
+    uint32x4_t v4       = vbicq_u32(vceqq_u32(vld1q_u32(bucket + 0 * LIBBSC_LZP_BUCKET_WAYS), vdupq_n_u32(context)), vceqq_u32(vld1q_u32(bucket + 3 * LIBBSC_LZP_BUCKET_WAYS), vdupq_n_u32(0)));
+    uint32x4_t v8       = vandq_u32(v4, vceqq_u32(vld1q_u32(bucket + 1 * LIBBSC_LZP_BUCKET_WAYS), vdupq_n_u32(prev4)));
+    uint32x4_t v12      = vandq_u32(v8, vceqq_u32(vld1q_u32(bucket + 2 * LIBBSC_LZP_BUCKET_WAYS), vdupq_n_u32(prev8)));
+
+    m4  = (int)vaddvq_u32(vandq_u32(v4 , vld1q_u32(ways)));
+    m8  = (int)vaddvq_u32(vandq_u32(v8 , vld1q_u32(ways)));
+    m12 = (int)vaddvq_u32(vandq_u32(v12, vld1q_u32(ways)));
+#else
+    m4 = m8 = m12 = 0;
+    for (int w = 0; w < LIBBSC_LZP_BUCKET_WAYS; ++w)
+    {
+        m4  |= (bucket[w] == context && bucket[3 * LIBBSC_LZP_BUCKET_WAYS + w] != 0) << w;
+        m8  |= (bucket[1 * LIBBSC_LZP_BUCKET_WAYS + w] == prev4) << w;
+        m12 |= (bucket[2 * LIBBSC_LZP_BUCKET_WAYS + w] == prev8) << w;
+    }
+
+    m8 &= m4; m12 &= m8;
+#endif
+
+    int m = m12 != 0 ? m12 : (m8 != 0 ? m8 : m4);
+    int value = m != 0 ? (int)bucket[3 * LIBBSC_LZP_BUCKET_WAYS + bsc_bit_scan_forward(m)] : 0;
+
+#if LIBBSC_CPU_FEATURE >= LIBBSC_CPU_FEATURE_SSE2
+    _mm_store_si128((__m128i *)(bucket + 0 * LIBBSC_LZP_BUCKET_WAYS), _mm_or_si128(_mm_slli_si128(tags     , 4), _mm_cvtsi32_si128((int)context)));
+    _mm_store_si128((__m128i *)(bucket + 1 * LIBBSC_LZP_BUCKET_WAYS), _mm_or_si128(_mm_slli_si128(tags4    , 4), _mm_cvtsi32_si128((int)prev4)));
+    _mm_store_si128((__m128i *)(bucket + 2 * LIBBSC_LZP_BUCKET_WAYS), _mm_or_si128(_mm_slli_si128(tags8    , 4), _mm_cvtsi32_si128((int)prev8)));
+    _mm_store_si128((__m128i *)(bucket + 3 * LIBBSC_LZP_BUCKET_WAYS), _mm_or_si128(_mm_slli_si128(positions, 4), _mm_cvtsi32_si128(position)));
+#else
+    for (int w = LIBBSC_LZP_BUCKET_WAYS - 1; w > 0; --w)
+    {
+        for (int k = 0; k < 4; ++k) { bucket[k * LIBBSC_LZP_BUCKET_WAYS + w] = bucket[k * LIBBSC_LZP_BUCKET_WAYS + w - 1]; }
+    }
+
+    bucket[0 * LIBBSC_LZP_BUCKET_WAYS] = context;
+    bucket[1 * LIBBSC_LZP_BUCKET_WAYS] = prev4;
+    bucket[2 * LIBBSC_LZP_BUCKET_WAYS] = prev8;
+    bucket[3 * LIBBSC_LZP_BUCKET_WAYS] = (unsigned int)position;
+#endif
+
+    return value;
+}
+
+static INLINE int bsc_lzp_predict(unsigned int * RESTRICT table, int shift, unsigned int context, const unsigned char * base, int position)
 {
-    if (bsc_lzp_num_blocks(n) == 1)
+    // The eight bytes before the context, read only once there are twelve bytes of history
+    const unsigned char * p = base + position;
+
+#ifndef LIBBSC_NO_UNALIGNED_ACCESS
+    unsigned int prev4 = position >= 12 ? *(const unsigned int *)(p - 8)  : 0;
+    unsigned int prev8 = position >= 12 ? *(const unsigned int *)(p - 12) : 0;
+#else
+    unsigned int prev4 = position >= 12 ? p[-8]  | (p[-7]  << 8) | (p[-6]  << 16) | ((unsigned int)p[-5] << 24) : 0;
+    unsigned int prev8 = position >= 12 ? p[-12] | (p[-11] << 8) | (p[-10] << 16) | ((unsigned int)p[-9] << 24) : 0;
+#endif
+
+    return bsc_lzp_bucket_update(table + 4 * LIBBSC_LZP_BUCKET_WAYS * ((context * 0x9e3779b1u) >> shift), context, prev4, prev8, position);
+}
+
+static unsigned int * bsc_lzp_bucket_table(int hashSize, unsigned char ** memory, bsc_context * context)
+{
+    // The table is aligned so that every bucket is exactly one cache line
+    if ((*memory = (unsigned char *)bsc_context_zero_malloc(context, LIBBSC_LZP_BUCKET_TABLE_SIZE(hashSize) + 64)) != NULL)
     {
-        int result = bsc_lzp_encode_block(input, input + n, output + 1, output + n - 1, hashSize, minLen);
+        return (unsigned int *)(*memory + ((64 - ((size_t)*memory & 63)) & 63));
+    }
+
+    return NULL;
+}
+
+static int bsc_lzp_encode_block_buckets(const unsigned char * RESTRICT input, const unsigned char * inputEnd, unsigned char * RESTRICT output, unsigned char * outputEnd, int hashSize, int minLen, bsc_context * context)
+{
+    if (inputEnd - input - minLen < 32)
+    {
+        return LIBBSC_NOT_COMPRESSIBLE;
+    }
+
+    unsigned char * memory = NULL;
+    unsigned int  * table  = bsc_lzp_bucket_table(hashSize, &memory, context);
+    if (table == NULL)
+    {
+        return LIBBSC_NOT_ENOUGH_MEMORY;
+    }
+
+    int                     shift       = 32 - LIBBSC_LZP_BUCKET_BITS(hashSize);
+    const unsigned char *   inputStart  = input;
+    const unsigned char *   outputStart = output;
+    const unsigned char *   outputEOB   = outputEnd - 8;
+
+    const unsigned char * heuristic      = input;
+    const unsigned char * inputMinLenEnd = inputEnd - minLen - 32;
+
+    for (int i = 0; i < 4; ++i) { *output++ = *input++; }
+
+    {
+        unsigned int ctx = input[-1] | (input[-2] << 8) | (input[-3] << 16) | (input[-4] << 24);
+
+        while ((input < inputMinLenEnd) && (output < outputEOB))
+        {
+            int value = bsc_lzp_predict(table, shift, ctx, inputStart, (int)(input - inputStart));
+            if (value > 0)
+            {
+                const unsigned char * RESTRICT reference = inputStart + value;
+#ifndef LIBBSC_NO_UNALIGNED_ACCESS
+                if ((*(unsigned int *)(input + minLen - 4) == *(unsigned int *)(reference + minLen - 4)) && (*(unsigned int *)(input) == *(unsigned int *)(reference)))
+#else
+                if ((memcmp(input + minLen - 4, reference + minLen - 4, sizeof(unsigned int)) == 0) && (memcmp(input, reference, sizeof(unsigned int)) == 0))
+#endif
+                {
+#ifndef LIBBSC_NO_UNALIGNED_ACCESS
+                    if ((heuristic > input) && (*(unsigned int *)heuristic != *(unsigned int *)(reference + (heuristic - input))))
+#else
+                    if ((heuristic > input) && (memcmp(heuristic, reference + (heuristic - input), sizeof(unsigned int)) != 0))
+#endif
+                    {
+                        goto LIBBSC_LZP_MATCH_NOT_FOUND;
+                    }
+
+                    long long len = bsc_lzp_match_length(input, reference, 4, inputMinLenEnd);
+
+                    if (len < minLen)
+                    {
+                        if (heuristic < input + len) heuristic = input + len;
+                        goto LIBBSC_LZP_MATCH_NOT_FOUND;
+                    }
+
+                    input += len; ctx = input[-1] | (input[-2] << 8) | (input[-3] << 16) | (input[-4] << 24);
+
+                    *output++ = LIBBSC_LZP_MATCH_FLAG;
+
+                    len -= minLen; while (len >= 254) { len -= 254; *output++ = 254; if (output >= outputEOB) break; }
+
+                    *output++ = (unsigned char)(len);
+                }
+                else
+                {
+
+LIBBSC_LZP_MATCH_NOT_FOUND:
+                    unsigned char next = *output++ = *input++; ctx = (ctx << 8) | next;
+                    if (next == LIBBSC_LZP_MATCH_FLAG) *output++ = 255;
+                }
+            }
+            else
+            {
+                ctx = (ctx << 8) | (*output++ = *input++);
+            }
+        }
+    }
+
+    {
+        unsigned int ctx = input[-1] | (input[-2] << 8) | (input[-3] << 16) | (input[-4] << 24);
+
+        while ((input < inputEnd) && (output < outputEOB))
+        {
+            int value = bsc_lzp_predict(table, shift, ctx, inputStart, (int)(input - inputStart));
+
+            unsigned char next = *output++ = *input++; ctx = (ctx << 8) | next;
+            if (next == LIBBSC_LZP_MATCH_FLAG && value > 0) *output++ = 255;
+        }
+    }
+
+    bsc_context_free(context, memory);
+
+    return (output >= outputEOB) ? LIBBSC_NOT_COMPRESSIBLE : (int)(output - outputStart);
+}
+
+static int bsc_lzp_decode_block_buckets(const unsigned char * RESTRICT input, const unsigned char * inputEnd, unsigned char * RESTRICT output, int hashSize, int minLen, bsc_context * context)
+{
+    if (inputEnd - input < 4)
+    {
+        return LIBBSC_UNEXPECTED_EOB;
+    }
+
+    unsigned char * memory = NULL;
+    unsigned int  * table  = bsc_lzp_bucket_table(hashSize, &memory, context);
+    if (table == NULL)
+    {
+        return LIBBSC_NOT_ENOUGH_MEMORY;
+    }
+
+    int                     shift       = 32 - LIBBSC_LZP_BUCKET_BITS(hashSize);
+    const unsigned char *   outputStart = output;
+
+    for (int i = 0; i < 4; ++i) { *output++ = *input++; }
+
+    unsigned int ctx = output[-1] | (output[-2] << 8) | (output[-3] << 16) | (output[-4] << 24);
+
+    while (input < inputEnd)
+    {
+        int value = bsc_lzp_predict(table, shift, ctx, outputStart, (int)(output - outputStart));
+        if (*input == LIBBSC_LZP_MATCH_FLAG && value > 0)
+        {
+            input++;
+            if (*input != 255)
+            {
+                int len = minLen; while (true) { len += *input; if (*input++ != 254) break; }
+
+                const unsigned char * reference = outputStart + value;
+                      unsigned char * outputEnd = output + len;
+
+                while (output < outputEnd) *output++ = *reference++;
+
+                ctx = output[-1] | (output[-2] << 8) | (output[-3] << 16) | (output[-4] << 24);
+            }
+            else
+            {
+                input++; ctx = (ctx << 8) | (*output++ = LIBBSC_LZP_MATCH_FLAG);
+            }
+        }
+        else
+        {
+            ctx = (ctx << 8) | (*output++ = *input++);
+        }
+    }
+
+    bsc_context_free(context, memory);
+
+    return (int)(output - outputStart);
+}
+
+static INLINE int bsc_lzp_encode(const unsigned char * input, const unsigned char * inputEnd, unsigned char * output, unsigned char * outputEnd, int hashSize, int minLen, int features, bsc_context * context)
+{
+    if (features & LIBBSC_FEATURE_LZPBUCKETS)
+    {
+        return bsc_lzp_encode_block_buckets(input, inputEnd, output, outputEnd, hashSize, minLen, context);
+    }
+
+    return bsc_lzp_encode_block(input, inputEnd, output, outputEnd, hashSize, minLen, context);
+}
+
+static INLINE int bsc_lzp_decode(const unsigned char * input, const unsigned char * inputEnd, unsigned char * output, int hashSize, int minLen, int features, bsc_context * context)
+{
+    if (features & LIBBSC_FEATURE_LZPBUCKETS)
+    {
+        return bsc_lzp_decode_block_buckets(input, inputEnd, output, hashSize, minLen, context);
+    }
+
+    return bsc_lzp_decode_block(input, inputEnd, output, hashSize, minLen, context);
+}
+
+int bsc_lzp_compress_serial(const unsigned char * input, unsigned char * output, int n, int hashSize, int minLen, int features, int nBlocks, bsc_context * context)
+{
+    if (nBlocks == 1)
+    {
+        int result = bsc_lzp_encode(input, input + n, output + 1, output + n - 1, hashSize, minLen, features, context);
         if (result >= LIBBSC_NO_ERROR) result = (output[0] = 1, result + 1);
 
         return result;
     }
 
-    int nBlocks   = bsc_lzp_num_blocks(n);
     int chunkSize = n / nBlocks;
     int outputPtr = 1 + 8 * nBlocks;
 
@@ -702,7 +1066,7 @@ int bsc_lzp_compress_serial(const unsigned char * input, unsigned char * output,
         int inputSize   = blockId != nBlocks - 1 ? chunkSize : n - inputStart;
         int outputSize  = inputSize; if (outputSize > n - outputPtr) outputSize = n - outputPtr;
 
-        int result = bsc_lzp_encode_block(input + inputStart, input + inputStart + inputSize, output + outputPtr, output + outputPtr + outputSize, hashSize, minLen);
+        int result = bsc_lzp_encode(input + inputStart, input + inputStart + inputSize, output + outputPtr, output + outputPtr + outputSize, hashSize, minLen, features, context);
         if (result < LIBBSC_NO_ERROR)
         {
             if (outputPtr + inputSize >= n) return LIBBSC_NOT_COMPRESSIBLE;
@@ -720,13 +1084,12 @@ int bsc_lzp_compress_serial(const unsigned char * input, unsigned char * output,
 
 #ifdef LIBBSC_OPENMP
 
-int bsc_lzp_compress_parallel(const unsigned char * input, unsigned char * output, int n, int hashSize, int minLen)
+int bsc_lzp_compress_parallel(const unsigned char * input, unsigned char * output, int n, int hashSize, int minLen, int features, int nBlocks, bsc_context * context)
 {
-    if (unsigned char * buffer = (unsigned char *)bsc_malloc(n * sizeof(unsigned char)))
+    if (unsigned char * buffer = (unsigned char *)bsc_context_malloc(context, n * sizeof(unsigned char)))
     {
         int compressionResult[ALPHABET_SIZE];
 
-        int nBlocks   = bsc_lzp_num_blocks(n);
         int result    = LIBBSC_NO_ERROR;
         int chunkSize = n / nBlocks;
 
@@ -738,7 +1101,7 @@ int bsc_lzp_compress_parallel(const unsigned char * input, unsigned char * outpu
         {
             if (omp_get_num_threads() == 1)
             {
-                result = bsc_lzp_compress_serial(input, output, n, hashSize, minLen);
+                result = bsc_lzp_compress_serial(input, output, n, hashSize, minLen, features, nBlocks, context);
             }
             else
             {
@@ -748,7 +1111,7 @@ int bsc_lzp_compress_parallel(const unsigned char * input, unsigned char * outpu
                     int blockStart   = blockId * chunkSize;
                     int blockSize    = blockId != nBlocks - 1 ? chunkSize : n - blockStart;
 
-                    compressionResult[blockId] = bsc_lzp_encode_block(input + blockStart, input + blockStart + blockSize, buffer + blockStart, buffer + blockStart + blockSize, hashSize, minLen);
+                    compressionResult[blockId] = bsc_lzp_encode(input + blockStart, input + blockStart + blockSize, buffer + blockStart, buffer + blockStart + blockSize, hashSize, minLen, features, context);
                     if (compressionResult[blockId] < LIBBSC_NO_ERROR) compressionResult[blockId] = blockSize;
 
                     memcpy(output + 1 + 8 * blockId + 0, &blockSize, sizeof(int));
@@ -790,7 +1153,7 @@ int bsc_lzp_compress_parallel(const unsigned char * input, unsigned char * outpu
             }
         }
 
-        bsc_free(buffer);
+        bsc_context_free(context, buffer);
 
         return result;
     }
@@ -799,28 +1162,29 @@ int bsc_lzp_compress_parallel(const unsigned char * input, unsigned char * outpu
 
 #endif
 
-int bsc_lzp_compress(const unsigned char * input, unsigned char * output, int n, int hashSize, int minLen, int features)
+int bsc_lzp_compress(const unsigned char * input, unsigned char * output, int n, int hashSize, int minLen, int features, bsc_context * context)
 {
+    int nBlocks = bsc_lzp_num_blocks(n, features);
 
 #ifdef LIBBSC_OPENMP
 
-    if ((bsc_lzp_num_blocks(n) != 1) && (features & LIBBSC_FEATURE_MULTITHREADING))
+    if ((nBlocks != 1) && (features & LIBBSC_FEATURE_MULTITHREADING))
     {
-        return bsc_lzp_compress_parallel(input, output, n, hashSize, minLen);
+        return bsc_lzp_compress_parallel(input, output, n, hashSize, minLen, features, nBlocks, context);
     }
 
 #endif
 
-    return bsc_lzp_compress_serial(input, output, n, hashSize, minLen);
+    return bsc_lzp_compress_serial(input, output, n, hashSize, minLen, features, nBlocks, context);
 }
 
-int bsc_lzp_decompress(const unsigned char * input, unsigned char * output, int n, int hashSize, int minLen, int features)
+int bsc_lzp_decompress(const unsigned char * input, unsigned char * output, int n, int hashSize, int minLen, int features, bsc_context * context)
 {
     int nBlocks = input[0];
 
     if (nBlocks == 1)
     {
-        return bsc_lzp_decode_block(input + 1, input + n, output, hashSize, minLen);
+        return bsc_lzp_decode(input + 1, input + n, output, hashSize, minLen, features, context);
     }
 
     int decompressionResult[ALPHABET_SIZE];
@@ -850,7 +1214,7 @@ int bsc_lzp_decompress(const unsigned char * input, unsigned char * output, int
 
             if (inputSize != outputSize)
             {
-                decompressionResult[blockId] = bsc_lzp_decode_block(input + inputPtr, input + inputPtr + inputSize, output + outputPtr, hashSize, minLen);
+                decompressionResult[blockId] = bsc_lzp_decode(input + inputPtr, input + inputPtr + inputSize, output + outputPtr, hashSize, minLen, features, context);
             }
             else
             {
@@ -883,7 +1247,7 @@ int bsc_lzp_decompress(const unsigned char * input, unsigned char * output, int
 
             if (inputSize != outputSize)
             {
-                decompressionResult[blockId] = bsc_lzp_decode_block(input + inputPtr, input + inputPtr + inputSize, output + outputPtr, hashSize, minLen);
+                decompressionResult[blockId] = bsc_lzp_decode(input + inputPtr, input + inputPtr + inputSize, output + outputPtr, hashSize, minLen, features, context);
             }
             else
             {
@@ -902,6 +1266,8 @@ int bsc_lzp_decompress(const unsigned char * input, unsigned char * output, int
     return (result == LIBBSC_NO_ERROR) ? dataSize : result;
 }
 
+#endif
+
 /*-----------------------------------------------------------*/
 /* End                                               lzp.cpp */
 /*-----------------------------------------------------------*/
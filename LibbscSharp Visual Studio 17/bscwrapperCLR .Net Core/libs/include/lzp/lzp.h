@@ -33,6 +33,8 @@ See also the bsc and libbsc web site:
 #ifndef _LIBBSC_LZP_H
 #define _LIBBSC_LZP_H
 
+#include "../platform/platform.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -44,10 +46,11 @@ extern "C" {
     * @param n          - the length of the input/output memory blocks.
     * @param hashSize   - the hash table size.
     * @param minLen     - the minimum match length.
-    * @param features   - the set of additional features.
+    * @param features   - the set of additional features, LIBBSC_FEATURE_LZPBUCKETS for the bucketed match finder.
+    * @param context    - the context that owns the scratch buffers, can be NULL.
     * @return The length of preprocessed memory block if no error occurred, error code otherwise.
     */
-    int bsc_lzp_compress(const unsigned char * input, unsigned char * output, int n, int hashSize, int minLen, int features);
+    int bsc_lzp_compress(const unsigned char * input, unsigned char * output, int n, int hashSize, int minLen, int features, bsc_context * context);
 
     /**
     * Reconstructs the original memory block after LZP algorithm.
@@ -56,10 +59,19 @@ extern "C" {
     * @param n          - the length of the input memory block.
     * @param hashSize   - the hash table size.
     * @param minLen     - the minimum match length.
-    * @param features   - the set of additional features.
+    * @param features   - the set of additional features, LIBBSC_FEATURE_LZPBUCKETS if the block was preprocessed with it.
+    * @param context    - the context that owns the scratch buffers, can be NULL.
     * @return The length of original memory block if no error occurred, error code otherwise.
     */
-    int bsc_lzp_decompress(const unsigned char * input, unsigned char * output, int n, int hashSize, int minLen, int features);
+    int bsc_lzp_decompress(const unsigned char * input, unsigned char * output, int n, int hashSize, int minLen, int features, bsc_context * context);
+
+    /**
+    * Caps the code path of the LZP encoder, so the SSE2, AVX2 and AVX-512 encoders can be timed on one machine.
+    * The output is the same on every path. Meant for benchmarks, do not call it while other threads run LZP.
+    * @param cpuFeatures - the highest LIBBSC_CPU_FEATURE_* to use, -1 for the features of the CPU.
+    * @return the code path the encoder now takes, as a LIBBSC_CPU_FEATURE_* value.
+    */
+    int bsc_lzp_set_cpu_features(int cpuFeatures);
 
 #ifdef __cplusplus
 }
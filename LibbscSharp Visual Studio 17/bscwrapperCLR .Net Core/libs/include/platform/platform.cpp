@@ -34,6 +34,8 @@ See also the bsc and libbsc web site:
 #include <string.h>
 #include <memory.h>
 
+#include <atomic>
+
 #include "platform.h"
 
 #include "../libbsc.h"
@@ -43,6 +45,18 @@ See also the bsc and libbsc web site:
   SIZE_T g_LargePageSize = 0;
 #endif
 
+#if defined(__linux__)
+  #include <stdio.h>
+  #include <stdint.h>
+  #include <sys/mman.h>
+
+  static size_t g_LargePageSize         = 0;
+  static int    g_TransparentLargePages = 0;
+#endif
+
+static std::atomic<long long> g_LargePageBytes(0);
+static std::atomic<long long> g_TransparentLargePageBytes(0);
+
 #if (LIBBSC_CPU_FEATURE >= LIBBSC_CPU_FEATURE_SSE2)
 
 #if defined(_MSC_VER)
@@ -54,11 +68,18 @@ static void bsc_cpuid(unsigned int regs[4], unsigned int level)
 #if defined(_MSC_VER)
     __cpuid((int *)regs, (int)level);
 #else
+    // ebx may hold the PIC register, it is swapped with rdi as a whole as writing ebx would clear the top of rbx
     __asm__ __volatile__
     (
+#if defined(__x86_64__)
+        "xchg %%rbx, %%rdi\n\t"
+        "cpuid\n\t"
+        "xchg %%rbx, %%rdi"
+#else
         "xchg %%ebx, %%edi\n\t"
         "cpuid\n\t"
-        "xchg %%ebx, %%edi" 
+        "xchg %%ebx, %%edi"
+#endif
         : "=a"(regs[0]), "=D"(regs[1]), "=c"(regs[2]), "=d"(regs[3])
         : "a"(level), "c"(0)
     );
@@ -123,15 +144,92 @@ int bsc_get_cpu_features(void)
 
 #endif
 
+#if defined(__linux__)
+
+/* Every allocation starts with a header, so the free function knows whether it was mapped or taken from the heap. */
+#define LIBBSC_ALLOCATION_HEAP      0
+#define LIBBSC_ALLOCATION_MAPPED    1
+#define LIBBSC_ALLOCATION_HEADER    64
+
+typedef struct bsc_allocation_header
+{
+    void *  base;
+    size_t  length;
+    int     kind;
+} bsc_allocation_header;
+
+static void * bsc_large_pages_malloc(size_t size)
+{
+    size_t length = (size + LIBBSC_ALLOCATION_HEADER + g_LargePageSize - 1) & (~(g_LargePageSize - 1));
+
+    unsigned char * base = (unsigned char *)mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (base != (unsigned char *)MAP_FAILED)
+    {
+        g_LargePageBytes += (long long)length;
+    }
+    else
+    {
+        if (!g_TransparentLargePages) return NULL;
+
+        /* No reserved huge pages, map one page more and trim it so the kernel can back the whole range with transparent ones. */
+        size_t reserved = length + g_LargePageSize;
+
+        unsigned char * region = (unsigned char *)mmap(NULL, reserved, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (region == (unsigned char *)MAP_FAILED) return NULL;
+
+        base = (unsigned char *)(((uintptr_t)region + g_LargePageSize - 1) & (~(uintptr_t)(g_LargePageSize - 1)));
+        if (base > region) munmap(region, (size_t)(base - region));
+        if (region + reserved > base + length) munmap(base + length, (size_t)(region + reserved - base - length));
+
+        /* Only a hint, the kernel may still back the range with small pages, so it is not counted as large pages. */
+        if (madvise(base, length, MADV_HUGEPAGE) == 0)
+        {
+            g_TransparentLargePageBytes += (long long)length;
+        }
+    }
+
+    bsc_allocation_header * header = (bsc_allocation_header *)base;
+    header->base    = base;
+    header->length  = length;
+    header->kind    = LIBBSC_ALLOCATION_MAPPED;
+
+    return base + LIBBSC_ALLOCATION_HEADER;
+}
+
+static void * bsc_heap_malloc(size_t size, int zero)
+{
+    if (size > (size_t)-1 - LIBBSC_ALLOCATION_HEADER) return NULL;
+
+    unsigned char * base = (unsigned char *)(zero ? calloc(1, size + LIBBSC_ALLOCATION_HEADER) : malloc(size + LIBBSC_ALLOCATION_HEADER));
+    if (base == NULL) return NULL;
+
+    bsc_allocation_header * header = (bsc_allocation_header *)base;
+    header->base    = base;
+    header->length  = size + LIBBSC_ALLOCATION_HEADER;
+    header->kind    = LIBBSC_ALLOCATION_HEAP;
+
+    return base + LIBBSC_ALLOCATION_HEADER;
+}
+
+#endif
+
 static void * bsc_default_malloc(size_t size)
 {
 #if defined(_WIN32)
     if ((g_LargePageSize != 0) && (size >= 256 * 1024))
     {
-        void * address = VirtualAlloc(0, (size + g_LargePageSize - 1) & (~(g_LargePageSize - 1)), MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
-        if (address != NULL) return address;
+        SIZE_T length = (size + g_LargePageSize - 1) & (~(g_LargePageSize - 1));
+        void * address = VirtualAlloc(0, length, MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+        if (address != NULL) { g_LargePageBytes += (long long)length; return address; }
     }
     return VirtualAlloc(0, size, MEM_COMMIT, PAGE_READWRITE);
+#elif defined(__linux__)
+    if ((g_LargePageSize != 0) && (size >= g_LargePageSize))
+    {
+        void * address = bsc_large_pages_malloc(size);
+        if (address != NULL) return address;
+    }
+    return bsc_heap_malloc(size, 0);
 #else
     return malloc(size);
 #endif
@@ -142,10 +240,19 @@ static void * bsc_default_zero_malloc(size_t size)
 #if defined(_WIN32)
     if ((g_LargePageSize != 0) && (size >= 256 * 1024))
     {
-        void * address = VirtualAlloc(0, (size + g_LargePageSize - 1) & (~(g_LargePageSize - 1)), MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
-        if (address != NULL) return address;
+        SIZE_T length = (size + g_LargePageSize - 1) & (~(g_LargePageSize - 1));
+        void * address = VirtualAlloc(0, length, MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+        if (address != NULL) { g_LargePageBytes += (long long)length; return address; }
     }
     return VirtualAlloc(0, size, MEM_COMMIT, PAGE_READWRITE);
+#elif defined(__linux__)
+    if ((g_LargePageSize != 0) && (size >= g_LargePageSize))
+    {
+        /* Anonymous mappings are zero-filled by the kernel. */
+        void * address = bsc_large_pages_malloc(size);
+        if (address != NULL) return address;
+    }
+    return bsc_heap_malloc(size, 1);
 #else
     return calloc(1, size);
 #endif
@@ -165,6 +272,18 @@ static void bsc_default_free(void * address)
 {
 #if defined(_WIN32)
     VirtualFree(address, 0, MEM_RELEASE);
+#elif defined(__linux__)
+    if (address == NULL) return;
+
+    bsc_allocation_header * header = (bsc_allocation_header *)((unsigned char *)address - LIBBSC_ALLOCATION_HEADER);
+    if (header->kind == LIBBSC_ALLOCATION_MAPPED)
+    {
+        munmap(header->base, header->length);
+    }
+    else
+    {
+        free(header->base);
+    }
 #else
     free(address);
 #endif
@@ -189,6 +308,259 @@ void bsc_free(void* address)
     return bsc_free_fn(address);
 }
 
+long long bsc_get_large_page_bytes(void)
+{
+    return g_LargePageBytes.load();
+}
+
+long long bsc_get_transparent_large_page_bytes(void)
+{
+    return g_TransparentLargePageBytes.load();
+}
+
+#define LIBBSC_CONTEXT_MAX_BUFFERS 64
+
+typedef struct bsc_context_buffer
+{
+    void *  address;
+    size_t  size;
+    int     inUse;
+} bsc_context_buffer;
+
+struct bsc_context
+{
+    int                 features;
+
+    void *              (* malloc)(void * user, size_t size);
+    void *              (* zero_malloc)(void * user, size_t size);
+    void                (* free)(void * user, void * address);
+    void *              user;
+
+#ifdef LIBBSC_OPENMP
+    omp_lock_t          lock;
+#endif
+
+    bsc_context_buffer  buffers[LIBBSC_CONTEXT_MAX_BUFFERS];
+};
+
+static void bsc_context_lock(bsc_context * context)
+{
+#ifdef LIBBSC_OPENMP
+    if (context->features & LIBBSC_FEATURE_MULTITHREADING) omp_set_lock(&context->lock);
+#endif
+}
+
+static void bsc_context_unlock(bsc_context * context)
+{
+#ifdef LIBBSC_OPENMP
+    if (context->features & LIBBSC_FEATURE_MULTITHREADING) omp_unset_lock(&context->lock);
+#endif
+}
+
+static void * bsc_context_raw_malloc(bsc_context * context, size_t size, int zero)
+{
+    if (context->malloc == NULL)
+    {
+        return zero ? bsc_zero_malloc(size) : bsc_malloc(size);
+    }
+
+    if (zero && context->zero_malloc != NULL)
+    {
+        return context->zero_malloc(context->user, size);
+    }
+
+    void * address = context->malloc(context->user, size);
+    if (zero && address != NULL)
+    {
+        memset(address, 0, size);
+    }
+    return address;
+}
+
+static void bsc_context_raw_free(bsc_context * context, void * address)
+{
+    if (context->free != NULL) context->free(context->user, address); else bsc_free(address);
+}
+
+bsc_context * bsc_context_create(int features)
+{
+    return bsc_context_create_full(features, NULL, NULL, NULL, NULL);
+}
+
+bsc_context * bsc_context_create_full(int features, void* (* malloc)(void* user, size_t size), void* (* zero_malloc)(void* user, size_t size), void (* free)(void* user, void* address), void* user)
+{
+    if ((malloc == NULL) != (free == NULL) || (malloc == NULL && zero_malloc != NULL))
+    {
+        return NULL;
+    }
+
+    // The context itself comes from the same allocator, so an arena owns every byte of the request
+    bsc_context * context = (bsc_context *)(malloc != NULL ? malloc(user, sizeof(bsc_context)) : bsc_malloc(sizeof(bsc_context)));
+    if (context != NULL)
+    {
+        memset(context, 0, sizeof(bsc_context));
+        context->features       = features;
+        context->malloc         = malloc;
+        context->zero_malloc    = zero_malloc;
+        context->free           = free;
+        context->user           = user;
+
+#ifdef LIBBSC_OPENMP
+        if (features & LIBBSC_FEATURE_MULTITHREADING) omp_init_lock(&context->lock);
+#endif
+    }
+
+    return context;
+}
+
+void bsc_context_destroy(bsc_context * context)
+{
+    if (context == NULL)
+    {
+        return;
+    }
+
+    for (int i = 0; i < LIBBSC_CONTEXT_MAX_BUFFERS; ++i)
+    {
+        if (context->buffers[i].address != NULL) bsc_context_raw_free(context, context->buffers[i].address);
+    }
+
+#ifdef LIBBSC_OPENMP
+    if (context->features & LIBBSC_FEATURE_MULTITHREADING) omp_destroy_lock(&context->lock);
+#endif
+
+    bsc_context_raw_free(context, context);
+}
+
+static void * bsc_context_allocate(bsc_context * context, size_t size, int zero)
+{
+    if (context == NULL)
+    {
+        return zero ? bsc_zero_malloc(size) : bsc_malloc(size);
+    }
+
+    bsc_context_buffer * buffer = NULL; void * previous = NULL;
+
+    bsc_context_lock(context);
+    {
+        // The smallest idle buffer that fits is reused, otherwise an idle buffer is grown or an empty slot taken
+        bsc_context_buffer * fit = NULL, * idle = NULL, * empty = NULL;
+        for (int i = 0; i < LIBBSC_CONTEXT_MAX_BUFFERS; ++i)
+        {
+            bsc_context_buffer * candidate = &context->buffers[i];
+            if (candidate->inUse) continue;
+
+            if (candidate->address == NULL)
+            {
+                if (empty == NULL) empty = candidate;
+            }
+            else if (candidate->size >= size)
+            {
+                if (fit == NULL || candidate->size < fit->size) fit = candidate;
+            }
+            else
+            {
+                if (idle == NULL || candidate->size > idle->size) idle = candidate;
+            }
+        }
+
+        if (fit != NULL)
+        {
+            fit->inUse = 1;
+            bsc_context_unlock(context);
+
+            if (zero) memset(fit->address, 0, size);
+            return fit->address;
+        }
+
+        buffer = idle != NULL ? idle : empty;
+        if (buffer != NULL)
+        {
+            previous = buffer->address; buffer->address = NULL; buffer->size = 0; buffer->inUse = 1;
+        }
+    }
+    bsc_context_unlock(context);
+
+    if (previous != NULL) bsc_context_raw_free(context, previous);
+
+    void * address = bsc_context_raw_malloc(context, size, zero);
+    if (buffer != NULL)
+    {
+        bsc_context_lock(context);
+        {
+            if (address != NULL)
+            {
+                buffer->address = address; buffer->size = size;
+            }
+            else
+            {
+                buffer->inUse = 0;
+            }
+        }
+        bsc_context_unlock(context);
+    }
+
+    return address;
+}
+
+void * bsc_context_malloc(bsc_context * context, size_t size)
+{
+    return bsc_context_allocate(context, size, 0);
+}
+
+void * bsc_context_zero_malloc(bsc_context * context, size_t size)
+{
+    return bsc_context_allocate(context, size, 1);
+}
+
+void bsc_context_free(bsc_context * context, void * address)
+{
+    if (context == NULL)
+    {
+        bsc_free(address);
+        return;
+    }
+
+    if (address == NULL)
+    {
+        return;
+    }
+
+    bsc_context_lock(context);
+    for (int i = 0; i < LIBBSC_CONTEXT_MAX_BUFFERS; ++i)
+    {
+        if (context->buffers[i].address == address)
+        {
+            context->buffers[i].inUse = 0;
+            bsc_context_unlock(context);
+            return;
+        }
+    }
+    bsc_context_unlock(context);
+
+    // Buffers allocated while every slot was in use are not cached
+    bsc_context_raw_free(context, address);
+}
+
+// Per thread, so the workers of a container each route libsais through their own context
+static thread_local bsc_context * g_CurrentContext = NULL;
+
+bsc_context * bsc_context_set_current(bsc_context * context)
+{
+    bsc_context * previous = g_CurrentContext; g_CurrentContext = context;
+    return previous;
+}
+
+void * bsc_current_malloc(size_t size)
+{
+    return bsc_context_malloc(g_CurrentContext, size);
+}
+
+void bsc_current_free(void * address)
+{
+    bsc_context_free(g_CurrentContext, address);
+}
+
 int bsc_platform_init(int features, void* (* malloc)(size_t size), void* (* zero_malloc)(size_t size), void (* free)(void* address))
 {
     /* If the caller provides a malloc function but not a zero_malloc
@@ -254,6 +626,39 @@ int bsc_platform_init(int features, void* (* malloc)(size_t size), void* (* zero
         }
     }
 
+#elif defined(__linux__)
+
+    if (features & LIBBSC_FEATURE_LARGEPAGES)
+    {
+        size_t largePageSize = 2 * 1024 * 1024;
+
+        if (FILE * meminfo = fopen("/proc/meminfo", "r"))
+        {
+            char line[256]; unsigned long long kilobytes = 0;
+            while (fgets(line, sizeof(line), meminfo) != NULL)
+            {
+                if (sscanf(line, "Hugepagesize: %llu kB", &kilobytes) == 1) { largePageSize = (size_t)kilobytes * 1024; break; }
+            }
+            fclose(meminfo);
+        }
+
+        if ((largePageSize & (largePageSize - 1)) != 0) largePageSize = 0;
+
+        int transparentLargePages = 0;
+        if (FILE * enabled = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r"))
+        {
+            char line[256];
+            if (fgets(line, sizeof(line), enabled) != NULL)
+            {
+                transparentLargePages = strstr(line, "[never]") == NULL;
+            }
+            fclose(enabled);
+        }
+
+        g_LargePageSize         = largePageSize;
+        g_TransparentLargePages = transparentLargePages;
+    }
+
 #endif
 
     return LIBBSC_NO_ERROR;
@@ -225,6 +225,65 @@ extern "C" {
     */
     LIBBSC_API void bsc_free(void * address);
 
+    /**
+    * Reports how many bytes the default allocator placed on large pages since the process started.
+    * On Linux this counts explicit hugetlb pages only, on Windows MEM_LARGE_PAGES allocations.
+    * @return the number of bytes, 0 unless the library was initialized with LIBBSC_FEATURE_LARGEPAGES.
+    */
+    LIBBSC_API long long bsc_get_large_page_bytes(void);
+
+    /**
+    * Reports how many bytes the default allocator advised for transparent huge pages since the process started.
+    * madvise(MADV_HUGEPAGE) is a hint, AnonHugePages in /proc/self/smaps tells how much the kernel actually backed.
+    * @return the number of bytes, always 0 outside Linux.
+    */
+    LIBBSC_API long long bsc_get_transparent_large_page_bytes(void);
+
+    typedef struct bsc_context bsc_context;
+
+    /**
+    * Allocates a scratch buffer, reusing one the context kept from a previous call if it is large enough.
+    * @param context     - the context that owns the buffer, NULL to use bsc_malloc.
+    * @param size        - bytes to allocate.
+    * @return a pointer to allocated space or NULL if there is insufficient memory available.
+    */
+    void * bsc_context_malloc(bsc_context * context, size_t size);
+
+    /**
+    * Allocates a scratch buffer and initializes all its bits to zero, see @ref bsc_context_malloc.
+    * @param context     - the context that owns the buffer, NULL to use bsc_zero_malloc.
+    * @param size        - bytes to allocate.
+    * @return a pointer to allocated space or NULL if there is insufficient memory available.
+    */
+    void * bsc_context_zero_malloc(bsc_context * context, size_t size);
+
+    /**
+    * Returns a scratch buffer to the context, which keeps it for the next allocation.
+    * @param context     - the context the buffer was allocated from, NULL to use bsc_free.
+    * @param address     - previously allocated memory block to be released.
+    */
+    void bsc_context_free(bsc_context * context, void * address);
+
+    /**
+    * Makes a context the allocator of the calling thread for code that takes no context parameter (libsais).
+    * @param context     - the context to allocate from, NULL to use bsc_malloc.
+    * @return the context that was current before, to be restored once the call returns.
+    */
+    bsc_context * bsc_context_set_current(bsc_context * context);
+
+    /**
+    * Allocates a scratch buffer from the current context of the calling thread, see @ref bsc_context_set_current.
+    * @param size        - bytes to allocate.
+    * @return a pointer to allocated space or NULL if there is insufficient memory available.
+    */
+    void * bsc_current_malloc(size_t size);
+
+    /**
+    * Returns a buffer of @ref bsc_current_malloc to the current context, on the thread that allocated it.
+    * @param address     - previously allocated memory block to be released.
+    */
+    void bsc_current_free(void * address);
+
     /**
     * Detects supported CPU features (Streaming SIMD Extensions).
     * @return highest supported CPU feature.
@@ -235,14 +235,70 @@ static int bsc_st6_transform_serial(unsigned char * RESTRICT T, unsigned int * R
     return index;
 }
 
+static int bsc_st78_transform_serial(unsigned char * RESTRICT T, unsigned int * RESTRICT P, int * RESTRICT I, int * RESTRICT bucket, int n, int k)
+{
+    for (int i = 0; i < LIBBSC_HEADER_SIZE; ++i) T[n + i] = T[i];
+
+    int shift = k == 7 ? 8 : 0, nLowKeys = k == 7 ? ALPHABET_SIZE : ALPHABET_SIZE * ALPHABET_SIZE;
+
+    for (int i = 0; i < n; ++i)
+    {
+        bucket[((T[i + 6] << 8) | T[i + 7]) >> shift]++;
+    }
+
+    for (int sum = 0, i = 0; i < nLowKeys; ++i)
+    {
+        int tmp = sum; sum += bucket[i]; bucket[i] = tmp;
+    }
+
+    for (int i = 0; i < n; ++i)
+    {
+        I[bucket[((T[i + 6] << 8) | T[i + 7]) >> shift]++] = i;
+    }
+
+    memset(bucket, 0, nLowKeys * sizeof(int));
+
+    unsigned int W = (T[0] << 8) | T[1];
+    for (int i = 0; i < n; ++i)
+    {
+        W = (W << 8) | T[i + 2]; bucket[W & 0x00ffffff]++;
+    }
+
+    for (int sum = 0, i = 0; i < ALPHABET_SIZE * ALPHABET_SIZE * ALPHABET_SIZE; ++i)
+    {
+        int tmp = sum; sum += bucket[i]; bucket[i] = tmp;
+    }
+
+    int pos = 0;
+    for (int j = 0; j < n; ++j)
+    {
+        int i = I[j], key = (T[i + 3] << 16) | (T[i + 4] << 8) | T[i + 5];
+
+        if (i == 0) pos = bucket[key];
+        P[bucket[key]++] = (T[i] << 24) | (T[i + 1] << 16) | (T[i + 2] << 8) | T[i > 0 ? i - 1 : n - 1];
+    }
+
+    for (int i = n - 1; i >= pos; --i)
+    {
+        T[--bucket[P[i] >> 8]] = P[i] & 0xff;
+    }
+    int index = bucket[P[pos] >> 8];
+    for (int i = pos - 1; i >= 0; --i)
+    {
+        T[--bucket[P[i] >> 8]] = P[i] & 0xff;
+    }
+
+    return index;
+}
+
 #ifdef LIBBSC_OPENMP
 
-static int bsc_st3_transform_parallel(unsigned char * RESTRICT T, unsigned short * RESTRICT P, int * RESTRICT bucket0, int n)
+static int bsc_st3_transform_parallel(unsigned char * RESTRICT T, unsigned short * RESTRICT P, int * RESTRICT bucket0, int n, bsc_context * context)
 {
     unsigned int count0[ALPHABET_SIZE]; memset(count0, 0, ALPHABET_SIZE * sizeof(unsigned int));
     unsigned int count1[ALPHABET_SIZE]; memset(count1, 0, ALPHABET_SIZE * sizeof(unsigned int));
 
-    if (int * RESTRICT bucket1 = (int *)bsc_zero_malloc(ALPHABET_SIZE * ALPHABET_SIZE * sizeof(int)))
+    if (int * RESTRICT bucket1 = (int *)bsc_context_zero_malloc(context, ALPHABET_SIZE * ALPHABET_SIZE * sizeof(int)))
     {
         int pos, index = 0;
 
@@ -375,17 +431,17 @@ static int bsc_st3_transform_parallel(unsigned char * RESTRICT T, unsigned short
             }
         }
 
-        bsc_free(bucket1);
+        bsc_context_free(context, bucket1);
         return index;
     };
     return LIBBSC_NOT_ENOUGH_MEMORY;
 }
 
-static int bsc_st4_transform_parallel(unsigned char * RESTRICT T, unsigned int * RESTRICT P, int * RESTRICT bucket, int n)
+static int bsc_st4_transform_parallel(unsigned char * RESTRICT T, unsigned int * RESTRICT P, int * RESTRICT bucket, int n, bsc_context * context)
 {
-    if (int * RESTRICT bucket0 = (int *)bsc_zero_malloc(ALPHABET_SIZE * ALPHABET_SIZE * sizeof(int)))
+    if (int * RESTRICT bucket0 = (int *)bsc_context_zero_malloc(context, ALPHABET_SIZE * ALPHABET_SIZE * sizeof(int)))
     {
-        if (int * RESTRICT bucket1 = (int *)bsc_zero_malloc(ALPHABET_SIZE * ALPHABET_SIZE * sizeof(int)))
+        if (int * RESTRICT bucket1 = (int *)bsc_context_zero_malloc(context, ALPHABET_SIZE * ALPHABET_SIZE * sizeof(int)))
         {
             int pos, index = 0;
 
@@ -520,17 +576,17 @@ static int bsc_st4_transform_parallel(unsigned char * RESTRICT T, unsigned int *
                 }
             }
 
-            bsc_free(bucket1); bsc_free(bucket0);
+            bsc_context_free(context, bucket1); bsc_context_free(context, bucket0);
             return index;
         };
-        bsc_free(bucket0);
+        bsc_context_free(context, bucket0);
     };
     return LIBBSC_NOT_ENOUGH_MEMORY;
 }
 
-static int bsc_st5_transform_parallel(unsigned char * RESTRICT T, unsigned int * RESTRICT P, int * RESTRICT bucket0, int n)
+static int bsc_st5_transform_parallel(unsigned char * RESTRICT T, unsigned int * RESTRICT P, int * RESTRICT bucket0, int n, bsc_context * context)
 {
-    if (int * RESTRICT bucket1 = (int *)bsc_zero_malloc(ALPHABET_SQRT_SIZE * ALPHABET_SIZE * ALPHABET_SIZE * sizeof(int)))
+    if (int * RESTRICT bucket1 = (int *)bsc_context_zero_malloc(context, ALPHABET_SQRT_SIZE * ALPHABET_SIZE * ALPHABET_SIZE * sizeof(int)))
     {
         int pos, index = 0;
 
@@ -698,17 +754,17 @@ static int bsc_st5_transform_parallel(unsigned char * RESTRICT T, unsigned int *
             }
         }
 
-        bsc_free(bucket1);
+        bsc_context_free(context, bucket1);
         return index;
     };
     return LIBBSC_NOT_ENOUGH_MEMORY;
 }
 
-static int bsc_st6_transform_parallel(unsigned char * RESTRICT T, unsigned int * RESTRICT P, int * RESTRICT bucket, int n)
+static int bsc_st6_transform_parallel(unsigned char * RESTRICT T, unsigned int * RESTRICT P, int * RESTRICT bucket, int n, bsc_context * context)
 {
-    if (int * RESTRICT bucket0 = (int *)bsc_zero_malloc(ALPHABET_SIZE * ALPHABET_SIZE * ALPHABET_SIZE * sizeof(int)))
+    if (int * RESTRICT bucket0 = (int *)bsc_context_zero_malloc(context, ALPHABET_SIZE * ALPHABET_SIZE * ALPHABET_SIZE * sizeof(int)))
     {
-        if (int * RESTRICT bucket1 = (int *)bsc_zero_malloc(ALPHABET_SIZE * ALPHABET_SIZE * ALPHABET_SIZE * sizeof(int)))
+        if (int * RESTRICT bucket1 = (int *)bsc_context_zero_malloc(context, ALPHABET_SIZE * ALPHABET_SIZE * ALPHABET_SIZE * sizeof(int)))
         {
             int pos, index = 0;
 
@@ -857,21 +913,214 @@ static int bsc_st6_transform_parallel(unsigned char * RESTRICT T, unsigned int *
                 }
             }
 
-            bsc_free(bucket1); bsc_free(bucket0);
+            bsc_context_free(context, bucket1); bsc_context_free(context, bucket0);
             return index;
         };
-        bsc_free(bucket0);
+        bsc_context_free(context, bucket0);
+    };
+    return LIBBSC_NOT_ENOUGH_MEMORY;
+}
+
+static int bsc_st78_transform_parallel(unsigned char * RESTRICT T, unsigned int * RESTRICT P, int * RESTRICT I, int * RESTRICT bucket, int n, int k, bsc_context * context)
+{
+    if (int * RESTRICT bucket0 = (int *)bsc_context_zero_malloc(context, ALPHABET_SIZE * ALPHABET_SIZE * ALPHABET_SIZE * sizeof(int)))
+    {
+        if (int * RESTRICT bucket1 = (int *)bsc_context_zero_malloc(context, ALPHABET_SIZE * ALPHABET_SIZE * ALPHABET_SIZE * sizeof(int)))
+        {
+            if (int * RESTRICT low0 = (int *)bsc_context_zero_malloc(context, 2 * ALPHABET_SIZE * ALPHABET_SIZE * sizeof(int)))
+            {
+                int * RESTRICT low1 = low0 + ALPHABET_SIZE * ALPHABET_SIZE;
+
+                int shift = k == 7 ? 8 : 0, nLowKeys = k == 7 ? ALPHABET_SIZE : ALPHABET_SIZE * ALPHABET_SIZE;
+
+                int pos = 0, index = 0;
+
+                for (int i = 0; i < LIBBSC_HEADER_SIZE; ++i) T[n + i] = T[i];
+
+                #pragma omp parallel num_threads(2)
+                {
+                    int nThreads = omp_get_num_threads();
+                    int threadId = omp_get_thread_num();
+
+                    if (nThreads == 1)
+                    {
+                        index = bsc_st78_transform_serial(T, P, I, bucket, n, k);
+                    }
+                    else
+                    {
+                        int median = n / 2;
+
+                        {
+                            if (threadId == 0)
+                            {
+                                unsigned int W = (T[0] << 8) | T[1];
+                                for (int i = 0; i < median; ++i)
+                                {
+                                    W = (W << 8) | T[i + 2]; bucket0[W & 0x00ffffff]++;
+                                    low0[((T[i + 6] << 8) | T[i + 7]) >> shift]++;
+                                }
+                            }
+                            else
+                            {
+                                unsigned int W = (T[median] << 8) | T[median + 1];
+                                for (int i = median; i < n; ++i)
+                                {
+                                    W = (W << 8) | T[i + 2]; bucket1[W & 0x00ffffff]++;
+                                    low1[((T[i + 6] << 8) | T[i + 7]) >> shift]++;
+                                }
+                            }
+
+                            #pragma omp barrier
+                        }
+
+                        {
+                            if (threadId == 0)
+                            {
+                                for (int sum = 0, i = 0; i < nLowKeys; ++i)
+                                {
+                                    int tmp = sum; sum = sum + low0[i] + low1[i]; low0[i] = tmp; low1[i] = sum - 1;
+                                }
+
+                                for (int sum = 0, i = 0; i < ALPHABET_SIZE * ALPHABET_SIZE * ALPHABET_SIZE / 2; ++i)
+                                {
+                                    int tmp = sum; sum = sum + bucket0[i] + bucket1[i]; bucket[i] = bucket0[i] = tmp; bucket1[i] = sum - 1;
+                                }
+                            }
+                            else
+                            {
+                                for (int sum = n, i = ALPHABET_SIZE * ALPHABET_SIZE * ALPHABET_SIZE - 1; i >= ALPHABET_SIZE * ALPHABET_SIZE * ALPHABET_SIZE / 2; --i)
+                                {
+                                    int tmp = sum; sum = sum - bucket0[i] - bucket1[i]; bucket[i] = bucket0[i] = sum; bucket1[i] = tmp - 1;
+                                }
+                            }
+
+                            #pragma omp barrier
+                        }
+
+                        {
+                            if (threadId == 0)
+                            {
+                                for (int i = 0; i < median; ++i)
+                                {
+                                    I[low0[((T[i + 6] << 8) | T[i + 7]) >> shift]++] = i;
+                                }
+                            }
+                            else
+                            {
+                                for (int i = n - 1; i >= median; --i)
+                                {
+                                    I[low1[((T[i + 6] << 8) | T[i + 7]) >> shift]--] = i;
+                                }
+                            }
+
+                            #pragma omp barrier
+                        }
+
+                        {
+                            if (threadId == 0)
+                            {
+                                for (int j = 0; j < median; ++j)
+                                {
+                                    int i = I[j], key = (T[i + 3] << 16) | (T[i + 4] << 8) | T[i + 5];
+
+                                    if (i == 0) pos = bucket0[key];
+                                    P[bucket0[key]++] = (T[i] << 24) | (T[i + 1] << 16) | (T[i + 2] << 8) | T[i > 0 ? i - 1 : n - 1];
+                                }
+                            }
+                            else
+                            {
+                                for (int j = n - 1; j >= median; --j)
+                                {
+                                    int i = I[j], key = (T[i + 3] << 16) | (T[i + 4] << 8) | T[i + 5];
+
+                                    if (i == 0) pos = bucket1[key];
+                                    P[bucket1[key]--] = (T[i] << 24) | (T[i + 1] << 16) | (T[i + 2] << 8) | T[i > 0 ? i - 1 : n - 1];
+                                }
+                            }
+
+                            #pragma omp barrier
+                        }
+
+                        {
+                            if (threadId == 0)
+                            {
+                                memcpy(bucket1, bucket + 1, (ALPHABET_SIZE * ALPHABET_SIZE * ALPHABET_SIZE / 2) * sizeof(int));
+                            }
+                            else
+                            {
+                                memcpy(bucket1 + ALPHABET_SIZE * ALPHABET_SIZE * ALPHABET_SIZE / 2, bucket  + ALPHABET_SIZE * ALPHABET_SIZE * ALPHABET_SIZE / 2 + 1, (ALPHABET_SIZE * ALPHABET_SIZE * ALPHABET_SIZE / 2- 1) * sizeof(int));
+                                bucket1[ALPHABET_SIZE * ALPHABET_SIZE * ALPHABET_SIZE - 1] = n;
+                            }
+
+                            #pragma omp barrier
+                        }
+
+                        {
+                            if (threadId == 0)
+                            {
+                                if (pos < median)
+                                {
+                                    for (int i = 0; i < pos; ++i)
+                                    {
+                                        T[bucket[P[i] >> 8]++] = P[i] & 0xff;
+                                    }
+                                    index = bucket[P[pos] >> 8];
+                                    for (int i = pos; i < median; ++i)
+                                    {
+                                        T[bucket[P[i] >> 8]++] = P[i] & 0xff;
+                                    }
+                                }
+                                else
+                                {
+                                    for (int i = 0; i < median; ++i)
+                                    {
+                                        T[bucket[P[i] >> 8]++] = P[i] & 0xff;
+                                    }
+                                }
+                            }
+                            else
+                            {
+                                if (pos >= median)
+                                {
+                                    for (int i = n - 1; i >= pos; --i)
+                                    {
+                                        T[--bucket1[P[i] >> 8]] = P[i] & 0xff;
+                                    }
+                                    index = bucket1[P[pos] >> 8];
+                                    for (int i = pos - 1; i >= median; --i)
+                                    {
+                                        T[--bucket1[P[i] >> 8]] = P[i] & 0xff;
+                                    }
+                                }
+                                else
+                                {
+                                    for (int i = n - 1; i >= median; --i)
+                                    {
+                                        T[--bucket1[P[i] >> 8]] = P[i] & 0xff;
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+
+                bsc_context_free(context, low0); bsc_context_free(context, bucket1); bsc_context_free(context, bucket0);
+                return index;
+            };
+            bsc_context_free(context, bucket1);
+        };
+        bsc_context_free(context, bucket0);
     };
     return LIBBSC_NOT_ENOUGH_MEMORY;
 }
 
 #endif
 
-int bsc_st3_encode(unsigned char * T, int n, int features)
+int bsc_st3_encode(unsigned char * T, int n, int features, bsc_context * context)
 {
-    if (unsigned short * P = (unsigned short *)bsc_malloc(n * sizeof(unsigned short)))
+    if (unsigned short * P = (unsigned short *)bsc_context_malloc(context, n * sizeof(unsigned short)))
     {
-        if (int * bucket = (int *)bsc_zero_malloc(ALPHABET_SIZE * ALPHABET_SIZE * sizeof(int)))
+        if (int * bucket = (int *)bsc_context_zero_malloc(context, ALPHABET_SIZE * ALPHABET_SIZE * sizeof(int)))
         {
             int index = LIBBSC_NO_ERROR;
 
@@ -879,7 +1128,7 @@ int bsc_st3_encode(unsigned char * T, int n, int features)
 
             if ((features & LIBBSC_FEATURE_MULTITHREADING) && (n >= 64 * 1024))
             {
-                index = bsc_st3_transform_parallel(T, P, bucket, n);
+                index = bsc_st3_transform_parallel(T, P, bucket, n, context);
             }
             else
 
@@ -889,19 +1138,19 @@ int bsc_st3_encode(unsigned char * T, int n, int features)
                 index = bsc_st3_transform_serial(T, P, bucket, n);
             }
 
-            bsc_free(bucket); bsc_free(P);
+            bsc_context_free(context, bucket); bsc_context_free(context, P);
             return index;
         };
-        bsc_free(P);
+        bsc_context_free(context, P);
     };
     return LIBBSC_NOT_ENOUGH_MEMORY;
 }
 
-int bsc_st4_encode(unsigned char * T, int n, int features)
+int bsc_st4_encode(unsigned char * T, int n, int features, bsc_context * context)
 {
-    if (unsigned int * P = (unsigned int *)bsc_malloc(n * sizeof(unsigned int)))
+    if (unsigned int * P = (unsigned int *)bsc_context_malloc(context, n * sizeof(unsigned int)))
     {
-        if (int * bucket = (int *)bsc_zero_malloc(ALPHABET_SIZE * ALPHABET_SIZE * sizeof(int)))
+        if (int * bucket = (int *)bsc_context_zero_malloc(context, ALPHABET_SIZE * ALPHABET_SIZE * sizeof(int)))
         {
             int index = LIBBSC_NO_ERROR;
 
@@ -909,7 +1158,7 @@ int bsc_st4_encode(unsigned char * T, int n, int features)
 
             if ((features & LIBBSC_FEATURE_MULTITHREADING) && (n >= 64 * 1024))
             {
-                index = bsc_st4_transform_parallel(T, P, bucket, n);
+                index = bsc_st4_transform_parallel(T, P, bucket, n, context);
             }
             else
 
@@ -919,19 +1168,19 @@ int bsc_st4_encode(unsigned char * T, int n, int features)
                 index = bsc_st4_transform_serial(T, P, bucket, n);
             }
 
-            bsc_free(bucket); bsc_free(P);
+            bsc_context_free(context, bucket); bsc_context_free(context, P);
             return index;
         };
-        bsc_free(P);
+        bsc_context_free(context, P);
     };
     return LIBBSC_NOT_ENOUGH_MEMORY;
 }
 
-int bsc_st5_encode(unsigned char * T, int n, int features)
+int bsc_st5_encode(unsigned char * T, int n, int features, bsc_context * context)
 {
-    if (unsigned int * P = (unsigned int *)bsc_malloc(n * sizeof(unsigned int)))
+    if (unsigned int * P = (unsigned int *)bsc_context_malloc(context, n * sizeof(unsigned int)))
     {
-        if (int * bucket = (int *)bsc_zero_malloc(ALPHABET_SQRT_SIZE * ALPHABET_SIZE * ALPHABET_SIZE * sizeof(int)))
+        if (int * bucket = (int *)bsc_context_zero_malloc(context, ALPHABET_SQRT_SIZE * ALPHABET_SIZE * ALPHABET_SIZE * sizeof(int)))
         {
             int index = LIBBSC_NO_ERROR;
 
@@ -939,7 +1188,7 @@ int bsc_st5_encode(unsigned char * T, int n, int features)
 
             if ((features & LIBBSC_FEATURE_MULTITHREADING) && (n >= 64 * 1024))
             {
-                index = bsc_st5_transform_parallel(T, P, bucket, n);
+                index = bsc_st5_transform_parallel(T, P, bucket, n, context);
             }
             else
 
@@ -949,19 +1198,19 @@ int bsc_st5_encode(unsigned char * T, int n, int features)
                 index = bsc_st5_transform_serial(T, P, bucket, n);
             }
 
-            bsc_free(bucket); bsc_free(P);
+            bsc_context_free(context, bucket); bsc_context_free(context, P);
             return index;
         };
-        bsc_free(P);
+        bsc_context_free(context, P);
     };
     return LIBBSC_NOT_ENOUGH_MEMORY;
 }
 
-int bsc_st6_encode(unsigned char * T, int n, int features)
+int bsc_st6_encode(unsigned char * T, int n, int features, bsc_context * context)
 {
-    if (unsigned int * P = (unsigned int *)bsc_malloc(n * sizeof(unsigned int)))
+    if (unsigned int * P = (unsigned int *)bsc_context_malloc(context, n * sizeof(unsigned int)))
     {
-        if (int * bucket = (int *)bsc_zero_malloc(ALPHABET_SIZE * ALPHABET_SIZE * ALPHABET_SIZE * sizeof(int)))
+        if (int * bucket = (int *)bsc_context_zero_malloc(context, ALPHABET_SIZE * ALPHABET_SIZE * ALPHABET_SIZE * sizeof(int)))
         {
             int index = LIBBSC_NO_ERROR;
 
@@ -969,7 +1218,7 @@ int bsc_st6_encode(unsigned char * T, int n, int features)
 
             if ((features & LIBBSC_FEATURE_MULTITHREADING) && (n >= 6 * 1024 * 1024))
             {
-                index = bsc_st6_transform_parallel(T, P, bucket, n);
+                index = bsc_st6_transform_parallel(T, P, bucket, n, context);
             }
             else
 
@@ -979,15 +1228,49 @@ int bsc_st6_encode(unsigned char * T, int n, int features)
                 index = bsc_st6_transform_serial(T, P, bucket, n);
             }
 
-            bsc_free(bucket); bsc_free(P);
+            bsc_context_free(context, bucket); bsc_context_free(context, P);
             return index;
         };
-        bsc_free(P);
+        bsc_context_free(context, P);
+    };
+    return LIBBSC_NOT_ENOUGH_MEMORY;
+}
+
+static int bsc_st78_encode(unsigned char * T, int n, int k, int features, bsc_context * context)
+{
+    if (unsigned int * P = (unsigned int *)bsc_context_malloc(context, n * sizeof(unsigned int)))
+    {
+        if (int * I = (int *)bsc_context_malloc(context, n * sizeof(int)))
+        {
+            if (int * bucket = (int *)bsc_context_zero_malloc(context, ALPHABET_SIZE * ALPHABET_SIZE * ALPHABET_SIZE * sizeof(int)))
+            {
+                int index = LIBBSC_NO_ERROR;
+
+#ifdef LIBBSC_OPENMP
+
+                if ((features & LIBBSC_FEATURE_MULTITHREADING) && (n >= 6 * 1024 * 1024))
+                {
+                    index = bsc_st78_transform_parallel(T, P, I, bucket, n, k, context);
+                }
+                else
+
+#endif
+
+                {
+                    index = bsc_st78_transform_serial(T, P, I, bucket, n, k);
+                }
+
+                bsc_context_free(context, bucket); bsc_context_free(context, I); bsc_context_free(context, P);
+                return index;
+            };
+            bsc_context_free(context, I);
+        };
+        bsc_context_free(context, P);
     };
     return LIBBSC_NOT_ENOUGH_MEMORY;
 }
 
-int bsc_st_encode(unsigned char * T, int n, int k, int features)
+int bsc_st_encode(unsigned char * T, int n, int k, int features, bsc_context * context)
 {
     if ((T == NULL) || (n < 0)) return LIBBSC_BAD_PARAMETER;
     if ((k < 3) || (k > 8))     return LIBBSC_BAD_PARAMETER;
@@ -998,17 +1281,17 @@ int bsc_st_encode(unsigned char * T, int n, int k, int features)
     if (features & LIBBSC_FEATURE_CUDA)
     {
         int index = bsc_st_encode_cuda(T, n, k, features);
-        if (index >= LIBBSC_NO_ERROR || k >= 7) return index;
+        if (index >= LIBBSC_NO_ERROR) return index;
     }
 
 #endif
 
-    if (k == 3) return bsc_st3_encode(T, n, features);
-    if (k == 4) return bsc_st4_encode(T, n, features);
-    if (k == 5) return bsc_st5_encode(T, n, features);
-    if (k == 6) return bsc_st6_encode(T, n, features);
+    if (k == 3) return bsc_st3_encode(T, n, features, context);
+    if (k == 4) return bsc_st4_encode(T, n, features, context);
+    if (k == 5) return bsc_st5_encode(T, n, features, context);
+    if (k == 6) return bsc_st6_encode(T, n, features, context);
 
-    return LIBBSC_NOT_SUPPORTED;
+    return bsc_st78_encode(T, n, k, features, context);
 }
 
 static bool bsc_unst_sort_serial(unsigned char * RESTRICT T, unsigned int * RESTRICT P, unsigned int * RESTRICT count, unsigned int * RESTRICT bucket, int n, int k)
@@ -1488,16 +1771,16 @@ static void bsc_unst_reconstruct_parallel(unsigned char * T, unsigned int * P, u
 
 #endif
 
-int bsc_st_decode(unsigned char * T, int n, int k, int index, int features)
+int bsc_st_decode(unsigned char * T, int n, int k, int index, int features, bsc_context * context)
 {
     if ((T == NULL) || (n < 0))      return LIBBSC_BAD_PARAMETER;
     if ((index < 0) || (index >= n)) return LIBBSC_BAD_PARAMETER;
     if ((k < 3) || (k > 8))          return LIBBSC_BAD_PARAMETER;
     if (n <= 1)                      return LIBBSC_NO_ERROR;
 
-    if (unsigned int * P = (unsigned int *)bsc_zero_malloc(n * sizeof(unsigned int)))
+    if (unsigned int * P = (unsigned int *)bsc_context_zero_malloc(context, n * sizeof(unsigned int)))
     {
-        if (unsigned int * bucket = (unsigned int *)bsc_zero_malloc(ALPHABET_SIZE * ALPHABET_SIZE * sizeof(unsigned int)))
+        if (unsigned int * bucket = (unsigned int *)bsc_context_zero_malloc(context, ALPHABET_SIZE * ALPHABET_SIZE * sizeof(unsigned int)))
         {
             unsigned int count[ALPHABET_SIZE]; memset(count, 0, ALPHABET_SIZE * sizeof(unsigned int));
 
@@ -1517,10 +1800,10 @@ int bsc_st_decode(unsigned char * T, int n, int k, int index, int features)
                 bsc_unst_reconstruct_serial(T, P, count, n, index, failBack);
             }
 
-            bsc_free(bucket); bsc_free(P);
+            bsc_context_free(context, bucket); bsc_context_free(context, P);
             return LIBBSC_NO_ERROR;
         };
-        bsc_free(P);
+        bsc_context_free(context, P);
     };
 
     return LIBBSC_NOT_ENOUGH_MEMORY;
@@ -33,6 +33,8 @@ See also the bsc and libbsc web site:
 #ifndef _LIBBSC_ST_H
 #define _LIBBSC_ST_H
 
+#include "../platform/platform.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -52,9 +54,10 @@ extern "C" {
     * @param n          - the length of the given string.
     * @param k[3..8]    - the order of Sort Transform.
     * @param features   - the set of additional features.
+    * @param context    - the context that owns the scratch buffers, can be NULL.
     * @return the primary index if no error occurred, error code otherwise.
     */
-    int bsc_st_encode(unsigned char * T, int n, int k, int features);
+    int bsc_st_encode(unsigned char * T, int n, int k, int features, bsc_context * context);
 
     /**
     * Reconstructs the original string from Sort Transform of order k transformed string.
@@ -63,9 +66,10 @@ extern "C" {
     * @param k[3..8]    - the order of Sort Transform.
     * @param index      - the primary index.
     * @param features   - the set of additional features.
+    * @param context    - the context that owns the scratch buffers, can be NULL.
     * @return LIBBSC_NO_ERROR if no error occurred, error code otherwise.
     */
-    int bsc_st_decode(unsigned char * T, int n, int k, int index, int features);
+    int bsc_st_decode(unsigned char * T, int n, int k, int index, int features, bsc_context * context);
 
 #endif
 
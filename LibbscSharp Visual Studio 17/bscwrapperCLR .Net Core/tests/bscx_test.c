@@ -0,0 +1,165 @@
+/*-----------------------------------------------------------*/
+/* Block Sorting, Lossless Data Compression Library.         */
+/* Round trips through the plain C bscx ABI                  */
+/*-----------------------------------------------------------*/
+
+/*--
+
+This file is a part of LibBSC Sharp, a .NET port of bsc and libbsc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+Only includes bscx.h, so it also shows the library used from plain C.
+Exits with 0 if every round trip gives back the input.
+
+--*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "container/bscx.h"
+
+#include "test_data.h"
+
+#define BSCX_TEST_SIZE (3 * 1024 * 1024)
+
+static int bscx_test_failures = 0;
+
+static void bscx_test_check(int condition, const char * name, const char * what)
+{
+    if (!condition)
+    {
+        fprintf(stderr, "%s: %s\n", name, what);
+        bscx_test_failures++;
+    }
+}
+
+static void bscx_test_round_trip(const char * name, const uint8_t * input, size_t inputSize, const bscx_params * params, char signature)
+{
+    int64_t bound = bscx_compress_bound(inputSize, params);
+    bscx_test_check(bound > 0, name, "bscx_compress_bound failed");
+    if (bound <= 0) return;
+
+    uint8_t * container = (uint8_t *)malloc((size_t)bound);
+    uint8_t * output    = (uint8_t *)malloc(inputSize);
+    if (container == NULL || output == NULL)
+    {
+        bscx_test_check(0, name, "not enough memory");
+        free(container); free(output);
+        return;
+    }
+
+    int64_t size = bscx_compress_container(input, inputSize, container, (size_t)bound, params);
+    bscx_test_check(size > 0, name, "bscx_compress_container failed");
+
+    if (size > 0)
+    {
+        bscx_test_check(memcmp(container, "bsc", 3) == 0 && container[3] == (uint8_t)signature, name, "unexpected container signature");
+        bscx_test_check(bscx_decompressed_size(container, (size_t)size) == (int64_t)inputSize, name, "bscx_decompressed_size mismatch");
+        bscx_test_check(bscx_decompress_container(container, (size_t)size, output, inputSize, 0) == (int64_t)inputSize, name, "bscx_decompress_container failed");
+        bscx_test_check(memcmp(input, output, inputSize) == 0, name, "round trip mismatch");
+        bscx_test_check(bscx_decompress_container(container, (size_t)size, output, inputSize - 1, 0) == BSCX_UNEXPECTED_EOB, name, "short output accepted");
+    }
+
+    free(container); free(output);
+}
+
+static void bscx_test_incremental(const uint8_t * input, size_t inputSize)
+{
+    const char * name = "incremental";
+
+    bscx_params params;
+    bscx_default_params(&params);
+    params.blockSize    = 256 * 1024;
+    params.cdcBlockSize = 64 * 1024;
+    params.writeIndex   = BSCX_INDEX_HASHES;
+
+    int64_t bound = bscx_compress_bound(inputSize, &params);
+    uint8_t * previous  = (uint8_t *)malloc((size_t)bound);
+    uint8_t * container = (uint8_t *)malloc((size_t)bound);
+    uint8_t * edited    = (uint8_t *)malloc(inputSize);
+    uint8_t * output    = (uint8_t *)malloc(inputSize);
+    if (bound <= 0 || previous == NULL || container == NULL || edited == NULL || output == NULL)
+    {
+        bscx_test_check(0, name, "not enough memory");
+        free(previous); free(container); free(edited); free(output);
+        return;
+    }
+
+    int64_t previousSize = bscx_compress_container(input, inputSize, previous, (size_t)bound, &params);
+    bscx_test_check(previousSize > 0, name, "previous version failed");
+
+    memcpy(edited, input, inputSize);
+    memcpy(edited + inputSize / 2, "an edit in the middle of the new version", 41);
+
+    int64_t size = previousSize > 0 ? bscx_compress_incremental(edited, inputSize, previous, (size_t)previousSize, container, (size_t)bound, &params) : -1;
+    bscx_test_check(size > 0, name, "bscx_compress_incremental failed");
+
+    if (size > 0)
+    {
+        bscx_test_check(bscx_decompress_container(container, (size_t)size, output, inputSize, 0) == (int64_t)inputSize, name, "bscx_decompress_container failed");
+        bscx_test_check(memcmp(edited, output, inputSize) == 0, name, "round trip mismatch");
+    }
+
+    free(previous); free(container); free(edited); free(output);
+}
+
+int main(void)
+{
+    uint8_t * input = (uint8_t *)malloc(BSCX_TEST_SIZE);
+    if (input == NULL)
+    {
+        fprintf(stderr, "not enough memory\n");
+        return 1;
+    }
+
+    bsc_test_fill(input, BSCX_TEST_SIZE);
+
+    bscx_params params;
+
+    bscx_default_params(&params);
+    params.blockSize = 1024 * 1024;
+    bscx_test_round_trip("bsc1", input, BSCX_TEST_SIZE, &params, '1');
+    bscx_test_round_trip("defaults", input, BSCX_TEST_SIZE, NULL, '1');
+
+    bscx_default_params(&params);
+    params.blockSize    = 64 * 1024;
+    params.deduplicate  = 1;
+    bscx_test_round_trip("bsc2", input, BSCX_TEST_SIZE, &params, '2');
+
+    bscx_default_params(&params);
+    params.blockSize    = 1024 * 1024;
+    params.longRange    = 1;
+    bscx_test_round_trip("bsc3", input, BSCX_TEST_SIZE, &params, '3');
+
+    bscx_default_params(&params);
+    params.blockSize    = 1024 * 1024;
+    params.lzpHashSize  = BSCX_LZP_AUTODETECT;
+    params.lzpMinLen    = BSCX_LZP_AUTODETECT;
+    bscx_test_round_trip("lzp autodetect", input, BSCX_TEST_SIZE, &params, '1');
+
+    bscx_test_incremental(input, BSCX_TEST_SIZE);
+
+    bscx_test_check(bscx_compress_container(NULL, 0, NULL, 0, NULL) == BSCX_BAD_PARAMETER, "parameters", "NULL input accepted");
+
+    free(input);
+
+    if (bscx_test_failures == 0) printf("bscx: all round trips passed\n");
+
+    return bscx_test_failures == 0 ? 0 : 1;
+}
+
+/*-----------------------------------------------------------*/
+/* End                                           bscx_test.c */
+/*-----------------------------------------------------------*/
@@ -0,0 +1,619 @@
+/*-----------------------------------------------------------*/
+/* Block Sorting, Lossless Data Compression Library.         */
+/* Round trips through the bsc1, bsc2 and bsc3 containers    */
+/*-----------------------------------------------------------*/
+
+/*--
+
+This file is a part of LibBSC Sharp, a .NET port of bsc and libbsc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+Every container written is read back through the buffer, positioned, stream
+and range decoders. Exits with 0 if every round trip gives back the input.
+
+--*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <atomic>
+
+#include "container/container.h"
+#include "libbsc.h"
+
+#include "test_data.h"
+
+#define CONTAINER_TEST_SIZE (3 * 1024 * 1024)
+
+static int container_test_failures = 0;
+
+static void container_test_check(bool condition, const char * name, const char * what)
+{
+    if (!condition)
+    {
+        fprintf(stderr, "%s: %s\n", name, what);
+        container_test_failures++;
+    }
+}
+
+typedef struct
+{
+    unsigned char * data;
+    long long       size;
+    long long       capacity;
+    long long       position;
+} container_test_buffer;
+
+static int container_test_write(void * context, const unsigned char * data, int size)
+{
+    container_test_buffer * buffer = (container_test_buffer *)context;
+    if (buffer->size + size > buffer->capacity)
+    {
+        return LIBBSC_UNEXPECTED_EOB;
+    }
+
+    memcpy(buffer->data + buffer->size, data, size); buffer->size += size;
+
+    return LIBBSC_NO_ERROR;
+}
+
+static int container_test_write_at(void * context, long long position, const unsigned char * data, int size)
+{
+    container_test_buffer * buffer = (container_test_buffer *)context;
+    if (position < 0 || position + size > buffer->capacity)
+    {
+        return LIBBSC_UNEXPECTED_EOB;
+    }
+
+    memcpy(buffer->data + position, data, size);
+    if (position + size > buffer->size) buffer->size = position + size;
+
+    return LIBBSC_NO_ERROR;
+}
+
+/* Reads at most 100000 bytes at a time, so callers never see a whole container or input in one call */
+static int container_test_read(void * context, unsigned char * data, int size)
+{
+    container_test_buffer * buffer = (container_test_buffer *)context;
+
+    long long remaining = buffer->size - buffer->position;
+    if (size > remaining) size = (int)remaining;
+    if (size > 100000) size = 100000;
+
+    memcpy(data, buffer->data + buffer->position, size); buffer->position += size;
+
+    return size;
+}
+
+static int container_test_read_at(void * context, long long position, unsigned char * data, int size)
+{
+    container_test_buffer * buffer = (container_test_buffer *)context;
+    if (position < 0 || position > buffer->size)
+    {
+        return LIBBSC_UNEXPECTED_EOB;
+    }
+
+    long long remaining = buffer->size - position;
+    if (size > remaining) size = (int)remaining;
+
+    memcpy(data, buffer->data + position, size);
+
+    return size;
+}
+
+static bool container_test_alloc(container_test_buffer * buffer, long long capacity)
+{
+    buffer->data = (unsigned char *)malloc((size_t)(capacity > 0 ? capacity : 1));
+    buffer->size = buffer->position = 0; buffer->capacity = capacity;
+
+    return buffer->data != NULL;
+}
+
+/* Decodes the container through every decoder and compares the result with the input */
+static void container_test_decode(const char * name, const container_test_buffer * container, const unsigned char * input, long long n, int features)
+{
+    long long dataSize = -1;
+    container_test_check(bsc_container_data_size(container->data, container->size, features, &dataSize) == LIBBSC_NO_ERROR && dataSize == n, name, "bsc_container_data_size mismatch");
+
+    container_test_buffer output;
+    if (!container_test_alloc(&output, n))
+    {
+        container_test_check(false, name, "not enough memory"); return;
+    }
+
+    container_test_check(bsc_container_decompress_buffer(container->data, container->size, output.data, n, 0, features) == LIBBSC_NO_ERROR, name, "bsc_container_decompress_buffer failed");
+    container_test_check(memcmp(input, output.data, (size_t)n) == 0, name, "buffer round trip mismatch");
+    container_test_check(bsc_container_decompress_buffer(container->data, container->size, output.data, n - 1, 0, features) != LIBBSC_NO_ERROR, name, "short output accepted");
+
+    memset(output.data, 0, (size_t)n); output.size = 0;
+    container_test_check(bsc_container_decompress(container->data, container->size, 0, features, container_test_write_at, &output) == LIBBSC_NO_ERROR, name, "bsc_container_decompress failed");
+    container_test_check(output.size == n && memcmp(input, output.data, (size_t)n) == 0, name, "positioned round trip mismatch");
+
+    container_test_buffer source = *container; source.position = 0;
+    memset(output.data, 0, (size_t)n); output.size = 0;
+    container_test_check(bsc_container_decompress_stream(container_test_read, &source, 0, features, container_test_write, &output) == LIBBSC_NO_ERROR, name, "bsc_container_decompress_stream failed");
+    container_test_check(output.size == n && memcmp(input, output.data, (size_t)n) == 0, name, "stream round trip mismatch");
+
+    long long ranges[3][2] = { { 0, 1 }, { n / 3 - 1000, 700000 }, { n - 4096, 4096 } };
+    for (int r = 0; r < 3; ++r)
+    {
+        if (ranges[r][0] < 0 || ranges[r][0] + ranges[r][1] > n) continue;
+
+        output.size = 0;
+        container_test_check(bsc_container_decompress_range(container_test_read_at, &source, container->size, ranges[r][0], ranges[r][1], 0, features, container_test_write, &output) == LIBBSC_NO_ERROR, name, "bsc_container_decompress_range failed");
+        container_test_check(output.size == ranges[r][1] && memcmp(input + ranges[r][0], output.data, (size_t)ranges[r][1]) == 0, name, "range round trip mismatch");
+    }
+
+    output.size = 0;
+    container_test_check(bsc_container_decompress_range(container_test_read_at, &source, container->size, n - 10, 11, 0, features, container_test_write, &output) == LIBBSC_BAD_PARAMETER, name, "range past the end accepted");
+
+    free(output.data);
+}
+
+static void container_test_round_trip(const char * name, const unsigned char * input, long long n, const bsc_container_params * params, char signature)
+{
+    long long bound = bsc_container_compress_bound(n, params);
+    container_test_check(bound > 0, name, "bsc_container_compress_bound failed");
+
+    container_test_buffer container;
+    if (bound <= 0 || !container_test_alloc(&container, bound))
+    {
+        container_test_check(false, name, "not enough memory"); return;
+    }
+
+    int result = bsc_container_compress(input, n, params, container_test_write, &container);
+    container_test_check(result == LIBBSC_NO_ERROR, name, "bsc_container_compress failed");
+
+    if (result == LIBBSC_NO_ERROR)
+    {
+        container_test_check(container.size >= 4 && memcmp(container.data, "bsc", 3) == 0 && container.data[3] == (unsigned char)signature, name, "unexpected container signature");
+        // The LZP match finder is recorded in the block headers, decoders never need the bucket bit
+        container_test_decode(name, &container, input, n, params->features & ~LIBBSC_FEATURE_LZPBUCKETS);
+    }
+
+    free(container.data);
+}
+
+static void container_test_compress_stream(const unsigned char * input, long long n)
+{
+    const char * name = "compress stream";
+
+    bsc_container_params params;
+    bsc_container_default_params(&params);
+    params.blockSize    = 512 * 1024;
+    params.writeIndex   = 1;
+
+    container_test_buffer source = { (unsigned char *)input, n, n, 0 };
+    container_test_buffer container;
+    if (!container_test_alloc(&container, bsc_container_compress_bound(n, &params)))
+    {
+        container_test_check(false, name, "not enough memory"); return;
+    }
+
+    int result = bsc_container_compress_stream(container_test_read, &source, n, &params, container_test_write, &container);
+    container_test_check(result == LIBBSC_NO_ERROR, name, "bsc_container_compress_stream failed");
+    if (result == LIBBSC_NO_ERROR)
+    {
+        container_test_decode(name, &container, input, n, params.features);
+    }
+
+    source.position = 0; container.size = 0;
+    container_test_check(bsc_container_compress_stream(container_test_read, &source, n + 1, &params, container_test_write, &container) != LIBBSC_NO_ERROR, name, "short input accepted");
+
+    free(container.data);
+}
+
+static void container_test_incremental(const unsigned char * input, long long n)
+{
+    const char * name = "incremental";
+
+    bsc_container_params params;
+    bsc_container_default_params(&params);
+    params.blockSize    = 256 * 1024;
+    params.cdcBlockSize = 64 * 1024;
+    params.writeIndex   = LIBBSC_CONTAINER_INDEX_HASHES;
+
+    container_test_buffer previous, container;
+    unsigned char * edited = (unsigned char *)malloc((size_t)n);
+    bool allocated = container_test_alloc(&previous, bsc_container_compress_bound(n, &params));
+    allocated = container_test_alloc(&container, bsc_container_compress_bound(n, &params)) && allocated;
+    if (!allocated || edited == NULL)
+    {
+        container_test_check(false, name, "not enough memory");
+        free(previous.data); free(container.data); free(edited);
+        return;
+    }
+
+    int result = bsc_container_compress(input, n, &params, container_test_write, &previous);
+    container_test_check(result == LIBBSC_NO_ERROR, name, "previous version failed");
+
+    memcpy(edited, input, (size_t)n);
+    memcpy(edited + n / 2, "an edit in the middle of the new version", 41);
+
+    bsc_container_stats stats;
+    memset(&stats, 0, sizeof(stats));
+
+    params.previous     = previous.data;
+    params.previousSize = previous.size;
+    params.stats        = &stats;
+    if (result == LIBBSC_NO_ERROR)
+    {
+        result = bsc_container_compress(edited, n, &params, container_test_write, &container);
+        container_test_check(result == LIBBSC_NO_ERROR, name, "bsc_container_compress failed");
+    }
+
+    if (result == LIBBSC_NO_ERROR)
+    {
+        container_test_check(stats.reusedBlocks > 0 && stats.reusedBlocks < stats.nBlocks, name, "unexpected number of reused blocks");
+        container_test_decode(name, &container, edited, n, params.features);
+    }
+
+    free(previous.data); free(container.data); free(edited);
+}
+
+/* ST7 and ST8 only sort in parallel from 6MB blocks on, and only with two threads or more left to the block */
+static void container_test_st78_parallel()
+{
+    const long long n = 6 * 1024 * 1024;
+
+    unsigned char * input = (unsigned char *)malloc((size_t)n);
+    if (input == NULL)
+    {
+        container_test_check(false, "st78 parallel", "not enough memory"); return;
+    }
+
+    bsc_test_fill(input, n);
+
+    bsc_container_params params;
+    bsc_container_default_params(&params);
+    params.blockSize    = (int)n;
+    params.lzpHashSize  = 0;
+    params.lzpMinLen    = 0;
+    params.numThreads   = 2;
+    params.features     = LIBBSC_FEATURE_MULTITHREADING;
+
+    params.blockSorter  = LIBBSC_BLOCKSORTER_ST7;
+    container_test_round_trip("st7 parallel", input, n, &params, '1');
+
+    params.blockSorter  = LIBBSC_BLOCKSORTER_ST8;
+    container_test_round_trip("st8 parallel", input, n, &params, '1');
+
+    free(input);
+}
+
+/* A new version made of the range of a bsc3 block that a long-range reference repeats must not reuse that block */
+static void container_test_long_range_reuse()
+{
+    const char * name = "long-range reuse";
+
+    const int size = 100 * 1024, matchOffset = 10 * 1024, matchSize = 50 * 1024;
+
+    unsigned char * input = (unsigned char *)malloc(size + matchSize);
+    if (input == NULL)
+    {
+        container_test_check(false, name, "not enough memory"); return;
+    }
+
+    unsigned int seed = 777;
+    for (int i = 0; i < size; ++i) { seed = seed * 1103515245u + 12345u; input[i] = (unsigned char)(seed >> 16); }
+    memcpy(input + size, input + matchOffset, matchSize);
+
+    bsc_container_params params;
+    bsc_container_default_params(&params);
+    params.blockSize    = 64 * 1024;
+    params.longRange    = 1;
+    params.writeIndex   = LIBBSC_CONTAINER_INDEX_HASHES;
+
+    container_test_buffer previous, container;
+    bool allocated = container_test_alloc(&previous, bsc_container_compress_bound(size + matchSize, &params));
+    allocated = container_test_alloc(&container, bsc_container_compress_bound(matchSize, &params)) && allocated;
+
+    int result = allocated ? bsc_container_compress(input, size + matchSize, &params, container_test_write, &previous) : LIBBSC_NOT_ENOUGH_MEMORY;
+    container_test_check(result == LIBBSC_NO_ERROR && previous.size > 3 && previous.data[3] == '3', name, "previous version failed");
+
+    if (result == LIBBSC_NO_ERROR)
+    {
+        params.previous     = previous.data;
+        params.previousSize = previous.size;
+
+        result = bsc_container_compress(input + matchOffset, matchSize, &params, container_test_write, &container);
+        container_test_check(result == LIBBSC_NO_ERROR, name, "bsc_container_compress failed");
+        if (result == LIBBSC_NO_ERROR)
+        {
+            container_test_decode(name, &container, input + matchOffset, matchSize, params.features);
+        }
+    }
+
+    free(previous.data); free(container.data); free(input);
+}
+
+typedef struct
+{
+    std::atomic<long long>  calls;
+    std::atomic<long long>  live;
+    long long               failAfter;
+} container_test_allocator;
+
+static void * container_test_malloc(void * user, size_t size)
+{
+    container_test_allocator * allocator = (container_test_allocator *)user;
+    if (allocator->calls.fetch_add(1) >= allocator->failAfter)
+    {
+        return NULL;
+    }
+
+    void * address = malloc(size);
+    if (address != NULL) allocator->live++;
+
+    return address;
+}
+
+static void container_test_free(void * user, void * address)
+{
+    container_test_allocator * allocator = (container_test_allocator *)user;
+    if (address != NULL) allocator->live--;
+
+    free(address);
+}
+
+static std::atomic<long long> container_test_global_calls(0);
+
+static void * container_test_global_malloc(size_t size)
+{
+    container_test_global_calls++;
+    return malloc(size);
+}
+
+static void container_test_global_free(void * address)
+{
+    free(address);
+}
+
+/* Every allocation of a compression goes through the hooks and is released, a failing hook only fails the call.
+   The process-wide allocator is swapped for a counting one to catch what bypasses them, so this runs last. */
+static void container_test_allocator_hooks(const unsigned char * input, long long n)
+{
+    const char * name = "allocator hooks";
+
+    if (bsc_init_full(LIBBSC_DEFAULT_FEATURES, container_test_global_malloc, NULL, container_test_global_free) != LIBBSC_NO_ERROR)
+    {
+        container_test_check(false, name, "bsc_init_full failed"); return;
+    }
+
+    container_test_allocator allocator;
+    allocator.calls = 0; allocator.live = 0; allocator.failAfter = 1LL << 62;
+
+    bsc_container_params params;
+    bsc_container_default_params(&params);
+    params.blockSize        = 512 * 1024;
+    params.deduplicate      = 1;
+    params.lzpHashSize      = LIBBSC_CONTAINER_LZP_AUTODETECT;
+    params.lzpMinLen        = LIBBSC_CONTAINER_LZP_AUTODETECT;
+    params.malloc           = container_test_malloc;
+    params.free             = container_test_free;
+    params.allocatorUser    = &allocator;
+
+    container_test_round_trip(name, input, n, &params, '2');
+    container_test_check(allocator.calls > 0, name, "the hooks were not called");
+    container_test_check(allocator.live == 0, name, "memory left allocated");
+
+    container_test_buffer container;
+    if (!container_test_alloc(&container, bsc_container_compress_bound(n, &params)))
+    {
+        container_test_check(false, name, "not enough memory"); return;
+    }
+
+    long long globalCalls = container_test_global_calls; allocator.calls = 0;
+    container_test_check(bsc_container_compress(input, n, &params, container_test_write, &container) == LIBBSC_NO_ERROR, name, "bsc_container_compress failed");
+    container_test_check(container_test_global_calls == globalCalls, name, "allocations bypassed the hooks");
+
+    long long calls = allocator.calls;
+    for (long long failAfter = 0; failAfter < calls; failAfter += calls / 7 + 1)
+    {
+        allocator.calls = 0; allocator.failAfter = failAfter; container.size = 0;
+
+        container_test_check(bsc_container_compress(input, n, &params, container_test_write, &container) == LIBBSC_NOT_ENOUGH_MEMORY, name, "failing allocator not reported");
+        container_test_check(allocator.live == 0, name, "memory left allocated after a failure");
+    }
+
+    free(container.data);
+}
+
+static void container_test_files(const unsigned char * input, long long n)
+{
+    const char * name = "files";
+
+    char inputFile[64], containerFile[64], outputFile[64];
+    snprintf(inputFile, sizeof(inputFile), "container_test_%d.in", (int)n);
+    snprintf(containerFile, sizeof(containerFile), "container_test_%d.bsc", (int)n);
+    snprintf(outputFile, sizeof(outputFile), "container_test_%d.out", (int)n);
+
+    FILE * file = fopen(inputFile, "wb");
+    container_test_check(file != NULL && fwrite(input, 1, (size_t)n, file) == (size_t)n, name, "cannot write the input file");
+    if (file != NULL) fclose(file);
+
+    bsc_container_params params;
+    bsc_container_default_params(&params);
+    params.blockSize = 1024 * 1024;
+
+    container_test_check(bsc_container_compress_file(inputFile, containerFile, &params) == LIBBSC_NO_ERROR, name, "bsc_container_compress_file failed");
+    container_test_check(bsc_container_decompress_file(containerFile, outputFile, 0, params.features) == LIBBSC_NO_ERROR, name, "bsc_container_decompress_file failed");
+
+    unsigned char * output = (unsigned char *)malloc((size_t)n + 1);
+    file = fopen(outputFile, "rb");
+    container_test_check(file != NULL && output != NULL && fread(output, 1, (size_t)n + 1, file) == (size_t)n && memcmp(input, output, (size_t)n) == 0, name, "file round trip mismatch");
+    if (file != NULL) fclose(file);
+    free(output);
+
+    remove(outputFile);
+
+    // the output is opened with O_TRUNC, writing onto the input, directly or through a hard link, would wipe it first
+    container_test_check(bsc_container_compress_file(inputFile, inputFile, &params) == LIBBSC_BAD_PARAMETER, name, "compression onto the input accepted");
+    container_test_check(bsc_container_decompress_file(containerFile, containerFile, 0, params.features) == LIBBSC_BAD_PARAMETER, name, "decompression onto the input accepted");
+    container_test_check(link(inputFile, outputFile) == 0, name, "cannot link the input file");
+    container_test_check(bsc_container_compress_file(inputFile, outputFile, &params) == LIBBSC_BAD_PARAMETER, name, "compression onto a hard link of the input accepted");
+    remove(outputFile);
+
+    output = (unsigned char *)malloc((size_t)n + 1);
+    file = fopen(inputFile, "rb");
+    container_test_check(file != NULL && output != NULL && fread(output, 1, (size_t)n + 1, file) == (size_t)n && memcmp(input, output, (size_t)n) == 0, name, "input changed by a rejected call");
+    if (file != NULL) fclose(file);
+    free(output);
+
+    container_test_check(bsc_container_decompress_file(containerFile, outputFile, 0, params.features) == LIBBSC_NO_ERROR, name, "container changed by a rejected call");
+    remove(outputFile);
+
+    file = fopen(containerFile, "r+b");
+    if (file != NULL)
+    {
+        fseek(file, 0, SEEK_END); long size = ftell(file); fclose(file);
+        container_test_check(truncate(containerFile, size / 2) == 0, name, "cannot truncate the container");
+    }
+    container_test_check(bsc_container_decompress_file(containerFile, outputFile, 0, params.features) != LIBBSC_NO_ERROR, name, "truncated container accepted");
+    file = fopen(outputFile, "rb");
+    container_test_check(file == NULL, name, "output of a failed decompression left behind");
+    if (file != NULL) fclose(file);
+
+    file = fopen(inputFile, "wb"); if (file != NULL) fclose(file);
+    container_test_check(bsc_container_compress_file(inputFile, containerFile, &params) == LIBBSC_BAD_PARAMETER, name, "empty input accepted");
+
+    remove(inputFile); remove(containerFile); remove(outputFile);
+}
+
+int main(void)
+{
+    unsigned char * input = (unsigned char *)malloc(CONTAINER_TEST_SIZE);
+    if (input == NULL)
+    {
+        fprintf(stderr, "not enough memory\n");
+        return 1;
+    }
+
+    if (bsc_init(LIBBSC_DEFAULT_FEATURES | LIBBSC_FEATURE_LARGEPAGES) != LIBBSC_NO_ERROR)
+    {
+        fprintf(stderr, "bsc_init failed\n");
+        free(input);
+        return 1;
+    }
+
+    bsc_test_fill(input, CONTAINER_TEST_SIZE);
+
+    bsc_container_params params;
+
+    bsc_container_default_params(&params);
+    params.blockSize        = 1024 * 1024;
+    container_test_round_trip("bsc1", input, CONTAINER_TEST_SIZE, &params, '1');
+
+    params.writeIndex       = 1;
+    container_test_round_trip("bsc1 index", input, CONTAINER_TEST_SIZE, &params, '1');
+
+    // A single block of the whole input, so the large page allocations are made too when the system has them
+    const int modes[] = { LIBBSC_FEATURE_NONE, LIBBSC_FEATURE_FASTMODE, LIBBSC_FEATURE_MULTITHREADING, LIBBSC_DEFAULT_FEATURES | LIBBSC_FEATURE_LARGEPAGES };
+    const char * modeNames[] = { "no features", "fast mode", "multithreading", "large pages" };
+    for (int mode = 0; mode < 4; ++mode)
+    {
+        bsc_container_default_params(&params);
+        params.blockSize    = CONTAINER_TEST_SIZE;
+        params.features     = modes[mode];
+        container_test_round_trip(modeNames[mode], input, CONTAINER_TEST_SIZE, &params, '1');
+    }
+
+    bsc_container_default_params(&params);
+    params.blockSize        = 64 * 1024;
+    params.deduplicate      = 1;
+    container_test_round_trip("bsc2", input, CONTAINER_TEST_SIZE, &params, '2');
+
+    bsc_container_default_params(&params);
+    params.blockSize        = 1024 * 1024;
+    params.longRange        = 1;
+    container_test_round_trip("bsc3", input, CONTAINER_TEST_SIZE, &params, '3');
+
+    bsc_container_default_params(&params);
+    params.blockSize        = 1024 * 1024;
+    params.blockSorter      = LIBBSC_BLOCKSORTER_ST7;
+    container_test_round_trip("st7", input, CONTAINER_TEST_SIZE, &params, '1');
+
+    params.blockSorter      = LIBBSC_BLOCKSORTER_ST8;
+    params.coder            = LIBBSC_CODER_QLFC_ADAPTIVE;
+    container_test_round_trip("st8", input, CONTAINER_TEST_SIZE, &params, '1');
+
+    container_test_st78_parallel();
+
+    bsc_container_default_params(&params);
+    params.blockSize        = 1024 * 1024;
+    params.minBlockSize     = 256 * 1024;
+    params.recordSize       = LIBBSC_CONTAINER_RECORDSIZE_AUTODETECT;
+    params.sortingContexts  = LIBBSC_CONTAINER_CONTEXTS_AUTODETECT;
+    container_test_round_trip("segments", input, CONTAINER_TEST_SIZE, &params, '1');
+
+    bsc_container_default_params(&params);
+    params.blockSize        = 1024 * 1024;
+    params.cdcBlockSize     = 64 * 1024;
+    params.storeThreshold   = 1;
+    container_test_round_trip("cdc stored", input, CONTAINER_TEST_SIZE, &params, '1');
+
+    bsc_container_default_params(&params);
+    params.blockSize        = 1024 * 1024;
+    params.lzpHashSize      = LIBBSC_CONTAINER_LZP_AUTODETECT;
+    params.lzpMinLen        = LIBBSC_CONTAINER_LZP_AUTODETECT;
+    container_test_round_trip("lzp autodetect", input, CONTAINER_TEST_SIZE, &params, '1');
+
+    bsc_container_default_params(&params);
+    params.blockSize        = 1024 * 1024;
+    params.features        |= LIBBSC_FEATURE_LZPBUCKETS;
+    container_test_round_trip("lzp buckets", input, CONTAINER_TEST_SIZE, &params, '1');
+
+    params.lzpHashSize      = 20;
+    params.lzpMinLen        = 32;
+    container_test_round_trip("lzp buckets short matches", input, CONTAINER_TEST_SIZE, &params, '1');
+
+    params.lzpHashSize      = LIBBSC_CONTAINER_LZP_AUTODETECT;
+    params.lzpMinLen        = LIBBSC_CONTAINER_LZP_AUTODETECT;
+    container_test_round_trip("lzp buckets autodetect", input, CONTAINER_TEST_SIZE, &params, '1');
+
+    bsc_container_default_params(&params);
+    params.blockSize        = 1024 * 1024;
+    params.features        |= LIBBSC_FEATURE_SUBBLOCKS(3);
+    container_test_round_trip("sub-blocks", input, CONTAINER_TEST_SIZE, &params, '1');
+
+    container_test_round_trip("small", input, 100, &params, '1');
+
+    // A single 3MB block leaves room for 12 LZP and 11 coder sub-blocks of 256KB, past the 8 of the default split
+    bsc_container_default_params(&params);
+    params.blockSize        = CONTAINER_TEST_SIZE;
+    params.features        |= LIBBSC_FEATURE_SUBBLOCKS(LIBBSC_MAX_SUBBLOCKS);
+    container_test_round_trip("sub-blocks 255", input, CONTAINER_TEST_SIZE, &params, '1');
+
+    container_test_compress_stream(input, CONTAINER_TEST_SIZE);
+    container_test_incremental(input, CONTAINER_TEST_SIZE);
+    container_test_long_range_reuse();
+    container_test_files(input, CONTAINER_TEST_SIZE);
+
+    bsc_container_default_params(&params);
+    container_test_check(bsc_container_compress(input, 0, &params, container_test_write, NULL) == LIBBSC_BAD_PARAMETER, "parameters", "empty input accepted");
+
+    container_test_allocator_hooks(input, CONTAINER_TEST_SIZE);
+
+    free(input);
+
+    if (container_test_failures == 0) printf("container: all round trips passed\n");
+
+    return container_test_failures == 0 ? 0 : 1;
+}
+
+/*-----------------------------------------------------------*/
+/* End                                    container_test.cpp */
+/*-----------------------------------------------------------*/
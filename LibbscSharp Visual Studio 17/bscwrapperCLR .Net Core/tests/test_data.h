@@ -0,0 +1,51 @@
+/*-----------------------------------------------------------*/
+/* Block Sorting, Lossless Data Compression Library.         */
+/* Input generator shared by the round trip tests            */
+/*-----------------------------------------------------------*/
+
+/*--
+
+This file is a part of LibBSC Sharp, a .NET port of bsc and libbsc.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+Plain C, so the C tests and the C++ tests fill the same input. The console
+testers generate it again in TestData.cs.
+
+--*/
+
+#ifndef _LIBBSC_TEST_DATA_H
+#define _LIBBSC_TEST_DATA_H
+
+/* Text like records, a 64KB window repeated every 1MB so references and LZP have something to find */
+static inline void bsc_test_fill(unsigned char * data, long long size)
+{
+    unsigned int seed = 12345;
+    for (long long i = 0; i < size; ++i)
+    {
+        if (i >= 1024 * 1024 && (i % (1024 * 1024)) < 65536)
+        {
+            data[i] = data[i - 1024 * 1024];
+            continue;
+        }
+
+        seed = seed * 1103515245u + 12345u;
+        data[i] = (i % 64) == 63 ? '\n' : (unsigned char)('a' + ((seed >> 16) % 8));
+    }
+}
+
+#endif
+
+/*-----------------------------------------------------------*/
+/* End                                           test_data.h */
+/*-----------------------------------------------------------*/